@@ -24,10 +24,12 @@ class TestTxnMan : public txn_man
 {
 public:
 	void init(thread_t * h_thd, workload * h_wl, uint64_t part_id); 
+	template<int ALG>
 	RC run_txn(int type, int access_num);
-	RC run_txn(base_query * m_query) { assert(false); };
 private:
+	template<int ALG>
 	RC testReadwrite(int access_num);
+	template<int ALG>
 	RC testConflict(int access_num);
 	
 	TestWorkload * _wl;
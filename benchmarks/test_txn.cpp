@@ -6,24 +6,26 @@ void TestTxnMan::init(thread_t * h_thd, workload * h_wl, uint64_t thd_id) {
 	_wl = (TestWorkload *) h_wl;
 }
 
+template<int ALG>
 RC TestTxnMan::run_txn(int type, int access_num) {
 	switch(type) {
 	case READ_WRITE :
-		return testReadwrite(access_num);
+		return testReadwrite<ALG>(access_num);
 	case CONFLICT:
-		return testConflict(access_num);
+		return testConflict<ALG>(access_num);
 	default:
 		assert(false);
 	}
 }
 
+template<int ALG>
 RC TestTxnMan::testReadwrite(int access_num) {
 	RC rc = RCOK;
 	itemid_t * m_item;
 
 	m_item = index_read(_wl->the_index, 0, 0);
 	row_t * row = ((row_t *)m_item->location);
-	row_t * row_local = get_row(row, WR);
+	row_t * row_local = get_row<ALG>(row, WR);
 	if (access_num == 0) {			
 		char str[] = "hello";
 		row_local->set_value(0, 1234);
@@ -46,13 +48,14 @@ RC TestTxnMan::testReadwrite(int access_num) {
     	assert(v3 == 8589934592UL);
 	    assert(strcmp(v4, "hello") == 0);
 	}
-	rc = finish(rc);
+	rc = finish<ALG>(rc);
 	if (access_num == 0)
 		return RCOK;
 	else 
 		return FINISH;
 }
 
+template<int ALG>
 RC 
 TestTxnMan::testConflict(int access_num)
 {
@@ -64,7 +67,7 @@ TestTxnMan::testConflict(int access_num)
 		m_item = index_read(_wl->the_index, key, 0);
 		row_t * row = ((row_t *)m_item->location);
 		row_t * row_local; 
-		row_local = get_row(row, WR);
+		row_local = get_row<ALG>(row, WR);
 		if (row_local) {
 			char str[] = "hello";
 			row_local->set_value(0, 1234);
@@ -77,6 +80,10 @@ TestTxnMan::testConflict(int access_num)
 			break;
 		}
 	}
-	rc = finish(rc);
+	rc = finish<ALG>(rc);
 	return rc;
 }
+
+#define TEST_RUN_TXN(alg) \
+	template RC TestTxnMan::run_txn<alg>(int, int);
+CC_EACH(TEST_RUN_TXN)
@@ -3,7 +3,9 @@
 #include "row.h"
 #include "mem_alloc.h"
 #include "index_hash.h"
+#include "index_hash_lf.h"
 #include "index_btree.h"
+#include "index_btree_olc.h"
 #include "thread.h"
 
 RC TestWorkload::init() {
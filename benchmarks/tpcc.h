@@ -14,6 +14,7 @@ public:
 	RC init_table();
 	RC init_schema(const char * schema_file);
 	RC get_txn_man(txn_man *& txn_manager, thread_t * h_thd);
+	void index_row(table_t * table, row_t * row);
 	table_t * 		t_warehouse; // The WAREHOUSE table
 	table_t * 		t_district; // The DISTRICT table
 	table_t * 		t_customer; // The CUSTOMER table
@@ -30,14 +31,27 @@ public:
 	INDEX * 	i_customer_id; // The CUSTOMER_IDX index (primary key)
 	INDEX * 	i_customer_last; // The CUSTOMER_LAST_IDX index (primary key)
 	INDEX * 	i_stock; // The STOCK_IDX index (primary key)
-	INDEX * 	i_order; // The ORDER_IDX index (foreign key), key = (w_id, d_id, o_id)
-	INDEX * 	i_orderline; // The ORDERLINE_IDX index (foreign key), key = (w_id, d_id, o_id)
-	INDEX * 	i_orderline_wd; // The ORDERLINE_WD_IDX index (foreign key), key = (w_id, d_id). 
-	
-	bool ** delivering;
+	INDEX * 	i_order; // The ORDER_IDX index (primary key), key = (w_id, d_id, o_id)
+	INDEX * 	i_order_cust; // The ORDER_CUST_IDX index (foreign key), key = (w_id, d_id, c_id), newest order first
+	INDEX * 	i_neworder; // The NEW-ORDER_IDX index (primary key), key = (w_id, d_id, o_id)
+	INDEX * 	i_orderline; // The ORDER-LINE_IDX index (foreign key), key = (w_id, d_id, o_id)
+
+	// Per district, by distKey. The rows of a new order are indexed as it
+	// commits, its NEW-ORDER row last, which raises `order_cnt` to the
+	// o_id. So `order_cnt` is the largest o_id whose rows are in the
+	// indexes. A delivery scans NEW-ORDER from `undelivered`, below which
+	// every order has been delivered. Both only grow and only bound scans.
+	volatile uint64_t * 	order_cnt;
+	volatile uint64_t * 	undelivered;
 	uint32_t next_tid;
 private:
 	uint64_t num_wh; // Number of warehouses
+	// moves the hints of `undelivered` past the deliveries in tables loaded
+	// from a checkpoint or an image
+	void find_undelivered();
+	// reads the loaded tables a column at a time (table_t::scan_column) and
+	// reports the districts that break TPC-C consistency conditions 2 to 4
+	void check_consistency();
 	void init_tab_item();
 	void init_tab_wh(uint32_t wid);
 	void init_tab_dist(uint64_t w_id);
@@ -63,13 +77,20 @@ class tpcc_txn_man : public txn_man
 {
 public:
 	void init(thread_t * h_thd, workload * h_wl, uint64_t part_id); 
+	// Run a txn/query and get running code. Resouces are handled internally. If abort, may restart later
+	template<int ALG>
 	RC run_txn(base_query * query);
 private:
 	tpcc_wl * _wl;
+	template<int ALG>
 	RC run_payment(tpcc_query * m_query);
+	template<int ALG>
 	RC run_new_order(tpcc_query * m_query);
+	template<int ALG>
 	RC run_order_status(tpcc_query * query);
+	template<int ALG>
 	RC run_delivery(tpcc_query * query);
+	template<int ALG>
 	RC run_stock_level(tpcc_query * query);
 };
 
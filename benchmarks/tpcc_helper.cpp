@@ -10,12 +10,14 @@ uint64_t custKey(uint64_t c_id, uint64_t c_d_id, uint64_t c_w_id) {
 	return (distKey(c_d_id, c_w_id) * g_cust_per_dist + c_id);
 }
 
+// o_id grows with every new order, so it has the low 32 bits to itself and
+// the orders of a district are next to each other in key order.
 uint64_t orderlineKey(uint64_t w_id, uint64_t d_id, uint64_t o_id) {
-	return distKey(d_id, w_id) * g_cust_per_dist + o_id; 
+	return orderPrimaryKey(w_id, d_id, o_id); 
 }
 
 uint64_t orderPrimaryKey(uint64_t w_id, uint64_t d_id, uint64_t o_id) {
-	return orderlineKey(w_id, d_id, o_id); 
+	return (distKey(d_id, w_id) << 32) + o_id; 
 }
 
 uint64_t custNPKey(char * c_last, uint64_t c_d_id, uint64_t c_w_id) {
@@ -7,13 +7,38 @@
 #include "table.h"
 
 void tpcc_query::init(uint64_t thd_id, workload * h_wl) {
-	double x = (double)(rand() % 100) / 100.0;
 	part_to_access = (uint64_t *) 
 		mem_allocator.alloc(sizeof(uint64_t) * g_part_cnt, thd_id);
-	if (x < g_perc_payment) // We only support these two now
+	items = (Item_no *) _mm_malloc(sizeof(Item_no) * MAX_OL_CNT, 64);
+}
+
+void tpcc_query::gen(uint64_t thd_id) {
+	double x = (double)(rand() % 100) / 100.0;
+	if (x < g_perc_payment)
 		gen_payment(thd_id);
+	else if (x < g_perc_payment + g_perc_order_status)
+		gen_order_status(thd_id);
+	else if (x < g_perc_payment + g_perc_order_status + g_perc_delivery)
+		gen_delivery(thd_id);
+	else if (x < g_perc_payment + g_perc_order_status + g_perc_delivery + g_perc_stock_level)
+		gen_stock_level(thd_id);
 	else 
 		gen_new_order(thd_id);
+	read_only = (type == TPCC_ORDER_STATUS || type == TPCC_STOCK_LEVEL);
+}
+// The scalar inputs, from `type` to `ol_delivery_d`, then the items of a new order
+uint32_t tpcc_query::get_cmd_size() {
+	uint32_t size = (char *)(&ol_delivery_d + 1) - (char *)&type;
+	if (type == TPCC_NEW_ORDER)
+		size += sizeof(Item_no) * ol_cnt;
+	return size;
+}
+
+void tpcc_query::write_cmd(char * buf) {
+	uint32_t size = (char *)(&ol_delivery_d + 1) - (char *)&type;
+	memcpy(buf, &type, size);
+	if (type == TPCC_NEW_ORDER)
+		memcpy(buf + size, items, sizeof(Item_no) * ol_cnt);
 }
 // This txn will be a payment
 void tpcc_query::gen_payment(uint64_t thd_id) {
@@ -69,9 +94,8 @@ void tpcc_query::gen_new_order(uint64_t thd_id) {
 	d_id = URand(1, DIST_PER_WARE, w_id-1);
 	c_id = NURand(1023, 1, g_cust_per_dist, w_id-1);
 	rbk = URand(1, 100, w_id-1);
-	ol_cnt = URand(5, 15, w_id-1);
+	ol_cnt = URand(5, MAX_OL_CNT, w_id-1);
 	o_entry_d = 2013;
-	items = (Item_no *) _mm_malloc(sizeof(Item_no) * ol_cnt, 64);
 	remote = false;
 	part_to_access[0] = wh_to_part(w_id);
 	part_num = 1;
@@ -122,6 +146,8 @@ tpcc_query::gen_order_status(uint64_t thd_id) {
 	d_id = URand(1, DIST_PER_WARE, w_id-1);
 	c_w_id = w_id;
 	c_d_id = d_id;
+	part_to_access[0] = wh_to_part(w_id);
+	part_num = 1;
 	int y = URand(1, 100, w_id-1);
 	if(y <= 60) {
 		// by last name
@@ -133,3 +159,29 @@ tpcc_query::gen_order_status(uint64_t thd_id) {
 		c_id = NURand(1023, 1, g_cust_per_dist, w_id-1);
 	}
 }
+// Delivers the oldest new order of each district of the warehouse
+void 
+tpcc_query::gen_delivery(uint64_t thd_id) {
+	type = TPCC_DELIVERY;
+	if (FIRST_PART_LOCAL)
+		w_id = thd_id % g_num_wh + 1;
+	else
+		w_id = URand(1, g_num_wh, thd_id % g_num_wh);
+	o_carrier_id = URand(1, 10, w_id-1);
+	ol_delivery_d = 2013;
+	part_to_access[0] = wh_to_part(w_id);
+	part_num = 1;
+}
+
+void 
+tpcc_query::gen_stock_level(uint64_t thd_id) {
+	type = TPCC_STOCK_LEVEL;
+	if (FIRST_PART_LOCAL)
+		w_id = thd_id % g_num_wh + 1;
+	else
+		w_id = URand(1, g_num_wh, thd_id % g_num_wh);
+	d_id = URand(1, DIST_PER_WARE, w_id-1);
+	threshold = URand(10, 20, w_id-1);
+	part_to_access[0] = wh_to_part(w_id);
+	part_num = 1;
+}
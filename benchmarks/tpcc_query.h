@@ -7,6 +7,8 @@
 
 class workload;
 
+// a new order has 5 to 15 items
+#define MAX_OL_CNT		15
 // items of new order transaction
 struct Item_no {
 	uint64_t ol_i_id;
@@ -17,6 +19,10 @@ struct Item_no {
 class tpcc_query : public base_query {
 public:
 	void init(uint64_t thd_id, workload * h_wl);
+	void gen(uint64_t thd_id);
+	uint32_t get_cmd_size();
+	void write_cmd(char * buf);
+	uint32_t get_txn_type() { return type; }
 	TPCCTxnType type;
 	/**********************************************/	
 	// common txn input for both payment & new-order
@@ -41,6 +47,8 @@ public:
 	bool remote;
 	uint64_t ol_cnt;
 	uint64_t o_entry_d;
+	// Input for stock-level
+	uint64_t threshold;
 	// Input for delivery
 	uint64_t o_carrier_id;
 	uint64_t ol_delivery_d;
@@ -53,6 +61,8 @@ private:
 	void gen_payment(uint64_t thd_id);
 	void gen_new_order(uint64_t thd_id);
 	void gen_order_status(uint64_t thd_id);
+	void gen_delivery(uint64_t thd_id);
+	void gen_stock_level(uint64_t thd_id);
 };
 
 #endif
@@ -7,32 +7,37 @@
 #include "table.h"
 #include "row.h"
 #include "index_hash.h"
+#include "index_hash_lf.h"
 #include "index_btree.h"
+#include "index_btree_olc.h"
 #include "tpcc_const.h"
+#include <algorithm>
 
 void tpcc_txn_man::init(thread_t * h_thd, workload * h_wl, uint64_t thd_id) {
 	txn_man::init(h_thd, h_wl, thd_id);
 	_wl = (tpcc_wl *) h_wl;
 }
 
+template<int ALG>
 RC tpcc_txn_man::run_txn(base_query * query) {
 	tpcc_query * m_query = (tpcc_query *) query;
 	switch (m_query->type) {
 		case TPCC_PAYMENT :
-			return run_payment(m_query); break;
+			return run_payment<ALG>(m_query); break;
 		case TPCC_NEW_ORDER :
-			return run_new_order(m_query); break;
-/*		case TPCC_ORDER_STATUS :
-			return run_order_status(m_query); break;
+			return run_new_order<ALG>(m_query); break;
+		case TPCC_ORDER_STATUS :
+			return run_order_status<ALG>(m_query); break;
 		case TPCC_DELIVERY :
-			return run_delivery(m_query); break;
+			return run_delivery<ALG>(m_query); break;
 		case TPCC_STOCK_LEVEL :
-			return run_stock_level(m_query); break;*/
+			return run_stock_level<ALG>(m_query); break;
 		default:
 			assert(false);
 	}
 }
 
+template<int ALG>
 RC tpcc_txn_man::run_payment(tpcc_query * query) {
 	RC rc = RCOK;
 	uint64_t key;
@@ -60,12 +65,12 @@ RC tpcc_txn_man::run_payment(tpcc_query * query) {
 	row_t * r_wh = ((row_t *)item->location);
 	row_t * r_wh_local;
 	if (g_wh_update)
-		r_wh_local = get_row(r_wh, WR);
+		r_wh_local = get_row<ALG>(r_wh, WR);
 	else 
-		r_wh_local = get_row(r_wh, RD);
+		r_wh_local = get_row<ALG>(r_wh, RD);
 
 	if (r_wh_local == NULL) {
-		return finish(Abort);
+		return finish<ALG>(Abort);
 	}
 	double w_ytd;
 	
@@ -85,9 +90,9 @@ RC tpcc_txn_man::run_payment(tpcc_query * query) {
 	item = index_read(_wl->i_district, key, wh_to_part(w_id));
 	assert(item != NULL);
 	row_t * r_dist = ((row_t *)item->location);
-	row_t * r_dist_local = get_row(r_dist, WR);
+	row_t * r_dist_local = get_row<ALG>(r_dist, WR);
 	if (r_dist_local == NULL) {
-		return finish(Abort);
+		return finish<ALG>(Abort);
 	}
 
 	double d_ytd;
@@ -173,9 +178,9 @@ RC tpcc_txn_man::run_payment(tpcc_query * query) {
 	   	EXEC SQL UPDATE customer SET c_balance = :c_balance, c_data = :c_new_data
    		WHERE c_w_id = :c_w_id AND c_d_id = :c_d_id AND c_id = :c_id;
    	+======================================================================*/
-	row_t * r_cust_local = get_row(r_cust, WR);
+	row_t * r_cust_local = get_row<ALG>(r_cust, WR);
 	if (r_cust_local == NULL) {
-		return finish(Abort);
+		return finish<ALG>(Abort);
 	}
 	double c_balance;
 	double c_ytd_payment;
@@ -236,9 +241,10 @@ RC tpcc_txn_man::run_payment(tpcc_query * query) {
 //	insert_row(r_hist, _wl->t_history);
 
 	assert( rc == RCOK );
-	return finish(rc);
+	return finish<ALG>(rc);
 }
 
+template<int ALG>
 RC tpcc_txn_man::run_new_order(tpcc_query * query) {
 	RC rc = RCOK;
 	uint64_t key;
@@ -261,9 +267,9 @@ RC tpcc_txn_man::run_new_order(tpcc_query * query) {
 	item = index_read(index, key, wh_to_part(w_id));
 	assert(item != NULL);
 	row_t * r_wh = ((row_t *)item->location);
-	row_t * r_wh_local = get_row(r_wh, RD);
+	row_t * r_wh_local = get_row<ALG>(r_wh, RD);
 	if (r_wh_local == NULL) {
-		return finish(Abort);
+		return finish<ALG>(Abort);
 	}
 
 
@@ -274,9 +280,9 @@ RC tpcc_txn_man::run_new_order(tpcc_query * query) {
 	item = index_read(index, key, wh_to_part(w_id));
 	assert(item != NULL);
 	row_t * r_cust = (row_t *) item->location;
-	row_t * r_cust_local = get_row(r_cust, RD);
+	row_t * r_cust_local = get_row<ALG>(r_cust, RD);
 	if (r_cust_local == NULL) {
-		return finish(Abort); 
+		return finish<ALG>(Abort); 
 	}
 	uint64_t c_discount;
 	//char * c_last;
@@ -296,43 +302,18 @@ RC tpcc_txn_man::run_new_order(tpcc_query * query) {
 	item = index_read(_wl->i_district, key, wh_to_part(w_id));
 	assert(item != NULL);
 	row_t * r_dist = ((row_t *)item->location);
-	row_t * r_dist_local = get_row(r_dist, WR);
+	row_t * r_dist_local = get_row<ALG>(r_dist, WR);
 	if (r_dist_local == NULL) {
-		return finish(Abort);
+		return finish<ALG>(Abort);
 	}
 	//double d_tax;
 	int64_t o_id;
 	//d_tax = *(double *) r_dist_local->get_value(D_TAX);
 	o_id = *(int64_t *) r_dist_local->get_value(D_NEXT_O_ID);
-	o_id ++;
-	r_dist_local->set_value(D_NEXT_O_ID, o_id);
+	r_dist_local->set_value(D_NEXT_O_ID, o_id + 1);
 
-	/*========================================================================================+
-	EXEC SQL INSERT INTO ORDERS (o_id, o_d_id, o_w_id, o_c_id, o_entry_d, o_ol_cnt, o_all_local)
-		VALUES (:o_id, :d_id, :w_id, :c_id, :datetime, :o_ol_cnt, :o_all_local);
-	+========================================================================================*/
-//	row_t * r_order;
-//	uint64_t row_id;
-//	_wl->t_order->get_new_row(r_order, 0, row_id);
-//	r_order->set_value(O_ID, o_id);
-//	r_order->set_value(O_C_ID, c_id);
-//	r_order->set_value(O_D_ID, d_id);
-//	r_order->set_value(O_W_ID, w_id);
-//	r_order->set_value(O_ENTRY_D, o_entry_d);
-//	r_order->set_value(O_OL_CNT, ol_cnt);
-//	int64_t all_local = (remote? 0 : 1);
-//	r_order->set_value(O_ALL_LOCAL, all_local);
-//	insert_row(r_order, _wl->t_order);
-	/*=======================================================+
-    EXEC SQL INSERT INTO NEW_ORDER (no_o_id, no_d_id, no_w_id)
-        VALUES (:o_id, :d_id, :w_id);
-    +=======================================================*/
-//	row_t * r_no;
-//	_wl->t_neworder->get_new_row(r_no, 0, row_id);
-//	r_no->set_value(NO_O_ID, o_id);
-//	r_no->set_value(NO_D_ID, d_id);
-//	r_no->set_value(NO_W_ID, w_id);
-//	insert_row(r_no, _wl->t_neworder);
+	// the amount of each order line, for the inserts
+	double ol_amounts[MAX_OL_CNT];
 	for (UInt32 ol_number = 0; ol_number < ol_cnt; ol_number++) {
 
 		uint64_t ol_i_id = query->items[ol_number].ol_i_id;
@@ -349,9 +330,9 @@ RC tpcc_txn_man::run_new_order(tpcc_query * query) {
 		assert(item != NULL);
 		row_t * r_item = ((row_t *)item->location);
 
-		row_t * r_item_local = get_row(r_item, RD);
+		row_t * r_item_local = get_row<ALG>(r_item, RD);
 		if (r_item_local == NULL) {
-			return finish(Abort);
+			return finish<ALG>(Abort);
 		}
 		int64_t i_price;
 		//char * i_name;
@@ -380,9 +361,9 @@ RC tpcc_txn_man::run_new_order(tpcc_query * query) {
 		index_read(stock_index, stock_key, wh_to_part(ol_supply_w_id), stock_item);
 		assert(item != NULL);
 		row_t * r_stock = ((row_t *)stock_item->location);
-		row_t * r_stock_local = get_row(r_stock, WR);
+		row_t * r_stock_local = get_row<ALG>(r_stock, WR);
 		if (r_stock_local == NULL) {
-			return finish(Abort);
+			return finish<ALG>(Abort);
 		}
 		
 		// XXX s_dist_xx are not retrieved.
@@ -411,61 +392,96 @@ RC tpcc_txn_man::run_new_order(tpcc_query * query) {
 			quantity = s_quantity - ol_quantity + 91;
 		}
 		r_stock_local->set_value(S_QUANTITY, &quantity);
-
-		/*====================================================+
-		EXEC SQL INSERT
-			INTO order_line(ol_o_id, ol_d_id, ol_w_id, ol_number,
-				ol_i_id, ol_supply_w_id,
-				ol_quantity, ol_amount, ol_dist_info)
-			VALUES(:o_id, :d_id, :w_id, :ol_number,
-				:ol_i_id, :ol_supply_w_id,
-				:ol_quantity, :ol_amount, :ol_dist_info);
-		+====================================================*/
-		// XXX district info is not inserted.
-//		row_t * r_ol;
-//		uint64_t row_id;
-//		_wl->t_orderline->get_new_row(r_ol, 0, row_id);
-//		r_ol->set_value(OL_O_ID, &o_id);
-//		r_ol->set_value(OL_D_ID, &d_id);
-//		r_ol->set_value(OL_W_ID, &w_id);
-//		r_ol->set_value(OL_NUMBER, &ol_number);
-//		r_ol->set_value(OL_I_ID, &ol_i_id);
+		ol_amounts[ol_number] = (double) (ol_quantity * i_price);
+	}
+	// The new rows are indexed and logged as the txn commits (on_commit), so
+	// no txn ever finds the rows of an aborted new order. The order lines go
+	// first and the new order last, so whoever finds a row finds all the
+	// rows of the order it needs.
+	uint64_t part_id = wh_to_part(w_id);
+	uint64_t row_id;
+	/*====================================================+
+	EXEC SQL INSERT
+		INTO order_line(ol_o_id, ol_d_id, ol_w_id, ol_number,
+			ol_i_id, ol_supply_w_id,
+			ol_quantity, ol_amount, ol_dist_info)
+		VALUES(:o_id, :d_id, :w_id, :ol_number,
+			:ol_i_id, :ol_supply_w_id,
+			:ol_quantity, :ol_amount, :ol_dist_info);
+	+====================================================*/
+	// XXX district info is not inserted.
+	for (UInt32 ol_number = 0; ol_number < ol_cnt; ol_number++) {
+		row_t * r_ol;
+		_wl->t_orderline->get_new_row(r_ol, part_id, row_id);
+		r_ol->set_value(OL_O_ID, o_id);
+		r_ol->set_value(OL_D_ID, d_id);
+		r_ol->set_value(OL_W_ID, w_id);
+		r_ol->set_value(OL_NUMBER, (int64_t) ol_number + 1);
+		r_ol->set_value(OL_I_ID, query->items[ol_number].ol_i_id);
 #if !TPCC_SMALL
-//		int w_tax=1, d_tax=1;
-//		int64_t ol_amount = ol_quantity * i_price * (1 + w_tax + d_tax) * (1 - c_discount);
-//		r_ol->set_value(OL_SUPPLY_W_ID, &ol_supply_w_id);
-//		r_ol->set_value(OL_QUANTITY, &ol_quantity);
-//		r_ol->set_value(OL_AMOUNT, &ol_amount);
-#endif		
-//		insert_row(r_ol, _wl->t_orderline);
+		r_ol->set_value(OL_SUPPLY_W_ID, query->items[ol_number].ol_supply_w_id);
+		r_ol->set_value(OL_DELIVERY_D, (int64_t) 0);
+		r_ol->set_value(OL_QUANTITY, query->items[ol_number].ol_quantity);
+		r_ol->set_value(OL_AMOUNT, ol_amounts[ol_number]);
+#endif
+		insert_row(r_ol, _wl->t_orderline);
 	}
+	/*========================================================================================+
+	EXEC SQL INSERT INTO ORDERS (o_id, o_d_id, o_w_id, o_c_id, o_entry_d, o_ol_cnt, o_all_local)
+		VALUES (:o_id, :d_id, :w_id, :c_id, :datetime, :o_ol_cnt, :o_all_local);
+	+========================================================================================*/
+	row_t * r_order;
+	_wl->t_order->get_new_row(r_order, part_id, row_id);
+	r_order->set_primary_key(o_id);
+	r_order->set_value(O_ID, o_id);
+	r_order->set_value(O_C_ID, c_id);
+	r_order->set_value(O_D_ID, d_id);
+	r_order->set_value(O_W_ID, w_id);
+	r_order->set_value(O_ENTRY_D, query->o_entry_d);
+	r_order->set_value(O_CARRIER_ID, (int64_t) 0);
+	r_order->set_value(O_OL_CNT, ol_cnt);
+	r_order->set_value(O_ALL_LOCAL, (int64_t) (remote? 0 : 1));
+	insert_row(r_order, _wl->t_order);
+	/*=======================================================+
+    EXEC SQL INSERT INTO NEW_ORDER (no_o_id, no_d_id, no_w_id)
+        VALUES (:o_id, :d_id, :w_id);
+    +=======================================================*/
+	row_t * r_no;
+	_wl->t_neworder->get_new_row(r_no, part_id, row_id);
+	r_no->set_value(NO_O_ID, o_id);
+	r_no->set_value(NO_D_ID, d_id);
+	r_no->set_value(NO_W_ID, w_id);
+	insert_row(r_no, _wl->t_neworder);
 	assert( rc == RCOK );
-	return finish(rc);
+	rc = finish<ALG>(rc);
+	return rc;
 }
 
+template<int ALG>
 RC 
 tpcc_txn_man::run_order_status(tpcc_query * query) {
-/*	row_t * r_cust;
+	RC rc = RCOK;
+	uint64_t key;
+	itemid_t * item;
+	uint64_t part_id = wh_to_part(query->c_w_id);
+	row_t * r_cust;
 	if (query->by_last_name) {
-		// EXEC SQL SELECT count(c_id) INTO :namecnt FROM customer
-		// WHERE c_last=:c_last AND c_d_id=:d_id AND c_w_id=:w_id;
-		// EXEC SQL DECLARE c_name CURSOR FOR SELECT c_balance, c_first, c_middle, c_id
-		// FROM customer
-		// WHERE c_last=:c_last AND c_d_id=:d_id AND c_w_id=:w_id ORDER BY c_first;
-		// EXEC SQL OPEN c_name;
-		// if (namecnt%2) namecnt++; / / Locate midpoint customer for (n=0; n<namecnt/ 2; n++)
-		// {
-		//	   	EXEC SQL FETCH c_name
-		//	   	INTO :c_balance, :c_first, :c_middle, :c_id;
-		// }
-		// EXEC SQL CLOSE c_name;
-
-		uint64_t key = custNPKey(query->c_last, query->c_d_id, query->c_w_id);
+		/*==========================================================+
+			EXEC SQL SELECT count(c_id) INTO :namecnt FROM customer
+			WHERE c_last=:c_last AND c_d_id=:d_id AND c_w_id=:w_id;
+			EXEC SQL DECLARE c_name CURSOR FOR SELECT c_balance, c_first, c_middle, c_id
+			FROM customer
+			WHERE c_last=:c_last AND c_d_id=:d_id AND c_w_id=:w_id ORDER BY c_first;
+			EXEC SQL OPEN c_name;
+			if (namecnt%2) namecnt++; // Locate midpoint customer
+			for (n=0; n<namecnt/ 2; n++)
+				EXEC SQL FETCH c_name INTO :c_balance, :c_first, :c_middle, :c_id;
+			EXEC SQL CLOSE c_name;
+		+==========================================================*/
+		key = custNPKey(query->c_last, query->c_d_id, query->c_w_id);
 		// XXX: the list is not sorted. But let's assume it's sorted... 
-		// The performance won't be much different.
-		INDEX * index = _wl->i_customer_last;
-		uint64_t thd_id = get_thd_id();
-		itemid_t * item = index_read(index, key, wh_to_part(query->c_w_id));
+		item = index_read(_wl->i_customer_last, key, part_id);
+		assert(item != NULL);
 		int cnt = 0;
 		itemid_t * it = item;
 		itemid_t * mid = item;
@@ -477,154 +493,274 @@ tpcc_txn_man::run_order_status(tpcc_query * query) {
 		}
 		r_cust = ((row_t *)mid->location);
 	} else {
-		// EXEC SQL SELECT c_balance, c_first, c_middle, c_last
-		// INTO :c_balance, :c_first, :c_middle, :c_last
-		// FROM customer
-		// WHERE c_id=:c_id AND c_d_id=:d_id AND c_w_id=:w_id;
-		uint64_t key = custKey(query->c_id, query->c_d_id, query->c_w_id);
-		INDEX * index = _wl->i_customer_id;
-		itemid_t * item = index_read(index, key, wh_to_part(query->c_w_id));
+		/*=====================================================================+
+			EXEC SQL SELECT c_balance, c_first, c_middle, c_last
+			INTO :c_balance, :c_first, :c_middle, :c_last
+			FROM customer
+			WHERE c_id=:c_id AND c_d_id=:d_id AND c_w_id=:w_id;
+		+======================================================================*/
+		key = custKey(query->c_id, query->c_d_id, query->c_w_id);
+		item = index_read(_wl->i_customer_id, key, part_id);
+		assert(item != NULL);
 		r_cust = (row_t *) item->location;
 	}
-#if TPCC_ACCESS_ALL
-
-	row_t * r_cust_local = get_row(r_cust, RD);
+	row_t * r_cust_local = get_row<ALG>(r_cust, RD);
 	if (r_cust_local == NULL) {
-		return finish(Abort);
+		return finish<ALG>(Abort);
 	}
+	int64_t c_id;
 	double c_balance;
+	r_cust_local->get_value(C_ID, c_id);
 	r_cust_local->get_value(C_BALANCE, c_balance);
-	char * c_first = r_cust_local->get_value(C_FIRST);
-	char * c_middle = r_cust_local->get_value(C_MIDDLE);
-	char * c_last = r_cust_local->get_value(C_LAST);
-#endif
-	// EXEC SQL SELECT o_id, o_carrier_id, o_entry_d
-	// INTO :o_id, :o_carrier_id, :entdate FROM orders
-	// ORDER BY o_id DESC;
-	uint64_t key = custKey(query->c_id, query->c_d_id, query->c_w_id);
-	INDEX * index = _wl->i_order;
-	itemid_t * item = index_read(index, key, wh_to_part(query->c_w_id));
-	row_t * r_order = (row_t *) item->location;
-	row_t * r_order_local = get_row(r_order, RD);
+
+	/*=====================================================+
+		EXEC SQL SELECT o_id, o_carrier_id, o_entry_d
+		INTO :o_id, :o_carrier_id, :entdate FROM orders
+		WHERE o_w_id=:w_id AND o_d_id=:d_id AND o_c_id=:c_id
+		ORDER BY o_id DESC;
+	+=====================================================*/
+	// the orders of a customer are listed newest first
+	key = custKey(c_id, query->c_d_id, query->c_w_id);
+	item = index_read(_wl->i_order_cust, key, part_id);
+	assert(item != NULL);
+	row_t * r_order_local = get_row<ALG>((row_t *) item->location, RD);
 	if (r_order_local == NULL) {
-		assert(false); 
-		return finish(Abort);
+		return finish<ALG>(Abort);
 	}
-
-	uint64_t o_id, o_entry_d, o_carrier_id;
+	int64_t o_id, o_entry_d, o_carrier_id;
 	r_order_local->get_value(O_ID, o_id);
-#if TPCC_ACCESS_ALL
 	r_order_local->get_value(O_ENTRY_D, o_entry_d);
 	r_order_local->get_value(O_CARRIER_ID, o_carrier_id);
-#endif
-#if DEBUG_ASSERT
-	itemid_t * it = item;
-	while (it != NULL && it->next != NULL) {
-		uint64_t o_id_1, o_id_2;
-		((row_t *)it->location)->get_value(O_ID, o_id_1);
-		((row_t *)it->next->location)->get_value(O_ID, o_id_2);
-		assert(o_id_1 > o_id_2);
-	}
-#endif
 
-	// EXEC SQL DECLARE c_line CURSOR FOR SELECT ol_i_id, ol_supply_w_id, ol_quantity,
-	// ol_amount, ol_delivery_d
-	// FROM order_line
-	// WHERE ol_o_id=:o_id AND ol_d_id=:d_id AND ol_w_id=:w_id;
-	// EXEC SQL OPEN c_line;
-	// EXEC SQL WHENEVER NOT FOUND CONTINUE;
-	// i=0;
-	// while (sql_notfound(FALSE)) {
-	// 		i++;
-	//		EXEC SQL FETCH c_line
-	//		INTO :ol_i_id[i], :ol_supply_w_id[i], :ol_quantity[i], :ol_amount[i], :ol_delivery_d[i];
-	// }
-	key = orderlineKey(query->w_id, query->d_id, o_id);
-	index = _wl->i_orderline;
-	item = index_read(index, key, wh_to_part(query->w_id));
+	/*=====================================================================+
+		EXEC SQL DECLARE c_line CURSOR FOR SELECT ol_i_id, ol_supply_w_id, ol_quantity,
+		ol_amount, ol_delivery_d
+		FROM order_line
+		WHERE ol_o_id=:o_id AND ol_d_id=:d_id AND ol_w_id=:w_id;
+		EXEC SQL OPEN c_line;
+		while (sql_notfound(FALSE))
+			EXEC SQL FETCH c_line
+			INTO :ol_i_id[i], :ol_supply_w_id[i], :ol_quantity[i], :ol_amount[i], :ol_delivery_d[i];
+	+=====================================================================*/
+	key = orderlineKey(query->c_w_id, query->c_d_id, o_id);
+	item = index_read(_wl->i_orderline, key, part_id);
 	assert(item != NULL);
-#if TPCC_ACCESS_ALL
-	// TODO the rows are simply read without any locking mechanism
-	while (item != NULL) {
-		row_t * r_orderline = (row_t *) item->location;
-		int64_t ol_i_id, ol_supply_w_id, ol_quantity, ol_amount, ol_delivery_d;
-		r_orderline->get_value(OL_I_ID, ol_i_id);
-		r_orderline->get_value(OL_SUPPLY_W_ID, ol_supply_w_id);
-		r_orderline->get_value(OL_QUANTITY, ol_quantity);
-		r_orderline->get_value(OL_AMOUNT, ol_amount);
-		r_orderline->get_value(OL_DELIVERY_D, ol_delivery_d);
-		item = item->next;
-	}
+	for (; item != NULL; item = item->next) {
+		row_t * r_ol_local = get_row<ALG>((row_t *) item->location, RD);
+		if (r_ol_local == NULL) {
+			return finish<ALG>(Abort);
+		}
+		int64_t ol_i_id;
+		r_ol_local->get_value(OL_I_ID, ol_i_id);
+#if !TPCC_SMALL
+		int64_t ol_supply_w_id, ol_quantity, ol_delivery_d;
+		double ol_amount;
+		r_ol_local->get_value(OL_SUPPLY_W_ID, ol_supply_w_id);
+		r_ol_local->get_value(OL_QUANTITY, ol_quantity);
+		r_ol_local->get_value(OL_AMOUNT, ol_amount);
+		r_ol_local->get_value(OL_DELIVERY_D, ol_delivery_d);
 #endif
-
-final:
+	}
 	assert( rc == RCOK );
-	return finish(rc)*/
-	return RCOK;
+	return finish<ALG>(rc);
 }
 
-
-//TODO concurrency for index related operations is not completely supported yet.
-// In correct states may happen with the current code.
-
+template<int ALG>
 RC 
 tpcc_txn_man::run_delivery(tpcc_query * query) {
-/*
-	// XXX HACK if another delivery txn is running on this warehouse, simply commit.
-	if ( !ATOM_CAS(_wl->delivering[query->w_id], false, true) )
-		return finish(RCOK);
-
-	for (int d_id = 1; d_id <= DIST_PER_WARE; d_id++) {
-		uint64_t key = distKey(d_id, query->w_id);
-		INDEX * index = _wl->i_orderline_wd;
-		itemid_t * item = index_read(index, key, wh_to_part(query->w_id));
-		assert(item != NULL);
-		while (item->next != NULL) {
-#if DEBUG_ASSERT
-			uint64_t o_id_1, o_id_2;
-			((row_t *)item->location)->get_value(OL_O_ID, o_id_1);
-			((row_t *)item->next->location)->get_value(OL_O_ID, o_id_2);
-			assert(o_id_1 > o_id_2);
-#endif
-			item = item->next;
+	RC rc = RCOK;
+	itemid_t * item;
+	uint64_t w_id = query->w_id;
+	uint64_t part_id = wh_to_part(w_id);
+	// per district, where the scan started and where the next one may start
+	uint64_t scan_lo[DIST_PER_WARE + 1];
+	uint64_t scan_next[DIST_PER_WARE + 1];
+	for (uint64_t d_id = 1; d_id <= DIST_PER_WARE; d_id++) {
+		/*====================================================+
+			EXEC SQL DECLARE c_no CURSOR FOR
+			SELECT no_o_id FROM new_order
+			WHERE no_d_id = :d_id AND no_w_id = :w_id
+			ORDER BY no_o_id ASC;
+			EXEC SQL OPEN c_no;
+			EXEC SQL FETCH c_no INTO :no_o_id;
+			EXEC SQL DELETE FROM new_order WHERE CURRENT OF c_no;
+			EXEC SQL CLOSE c_no;
+		+====================================================*/
+		// Indexes cannot delete yet, so a delivered new order stays in
+		// NEW-ORDER_IDX with its NO_O_ID negated. The scan starts from the
+		// hint of the district and passes over those up to the oldest one
+		// left.
+		uint64_t dist = distKey(d_id, w_id);
+		uint64_t lo = _wl->undelivered[dist];
+		uint64_t hi = _wl->order_cnt[dist];
+		scan_lo[d_id] = lo;
+		scan_next[d_id] = lo;
+		idx_cursor cursor;
+		index_scan(_wl->i_neworder, orderPrimaryKey(w_id, d_id, lo), 
+			orderPrimaryKey(w_id, d_id, hi), part_id, cursor);
+		uint64_t seen = 0;
+		int64_t no_o_id = 0;
+		row_t * r_no_local = NULL;
+		while ((item = index_next(_wl->i_neworder, cursor)) != NULL) {
+			seen ++;
+			r_no_local = get_row<ALG>((row_t *) item->location, WR);
+			if (r_no_local == NULL) {
+				return finish<ALG>(Abort);
+			}
+			r_no_local->get_value(NO_O_ID, no_o_id);
+			if (no_o_id > 0)
+				break;
 		}
-		uint64_t no_o_id;
-		row_t * r_orderline = (row_t *)item->location;
-		r_orderling->get_value(OL_O_ID, no_o_id);
-		// TODO the orderline row should be removed from the table and indexes.
-		
-		index = _wl->i_order;
-		key = orderPrimaryKey(query->w_id, d_id, no_o_id);
-		itemid_t * item = index_read(index, key, wh_to_part(query->w_id));
-		row_t * r_order = (row_t *)item->location;
-		row_t * r_order_local = get_row(r_order, WR);
+		// The hint may pass what this txn saw delivered, unless an order in
+		// between is not in the index yet.
+		if (no_o_id <= 0) {
+			if (lo <= hi && seen == hi - lo + 1)
+				scan_next[d_id] = hi + 1;
+			continue;
+		}
+		if (seen == no_o_id - lo + 1)
+			scan_next[d_id] = no_o_id + 1;
+		r_no_local->set_value(NO_O_ID, -no_o_id);
 
-		uint64_t o_c_id;
+		/*=====================================================+
+			EXEC SQL SELECT o_c_id INTO :c_id FROM orders
+			WHERE o_id = :no_o_id AND o_d_id = :d_id AND o_w_id = :w_id;
+			EXEC SQL UPDATE orders SET o_carrier_id = :o_carrier_id
+			WHERE o_id = :no_o_id AND o_d_id = :d_id AND o_w_id = :w_id;
+		+=====================================================*/
+		item = index_read(_wl->i_order, orderPrimaryKey(w_id, d_id, no_o_id), part_id);
+		assert(item != NULL);
+		row_t * r_order_local = get_row<ALG>((row_t *) item->location, WR);
+		if (r_order_local == NULL) {
+			return finish<ALG>(Abort);
+		}
+		int64_t o_c_id;
 		r_order_local->get_value(O_C_ID, o_c_id);
 		r_order_local->set_value(O_CARRIER_ID, query->o_carrier_id);
 
-		item = index_read(_wl->i_order_line, orderlineKey(query->w_id, d_id, no_o_id));
-		double sum_ol_amount;
-		double ol_amount;
-		while (item != NULL) {
-			// TODO the row is not locked
-			row_t * r_orderline = (row_t *)item->location;
-			r_orderline->set_value(OL_DELIVERY_D, query->ol_delivery_d);
-			r_orderline->get_value(OL_AMOUNT, ol_amount);
-			sum_ol_amount += ol_amount;
+		/*=====================================================+
+			EXEC SQL UPDATE order_line SET ol_delivery_d = :datetime
+			WHERE ol_o_id = :no_o_id AND ol_d_id = :d_id AND ol_w_id = :w_id;
+			EXEC SQL SELECT SUM(ol_amount) INTO :ol_total FROM order_line
+			WHERE ol_o_id = :no_o_id AND ol_d_id = :d_id AND ol_w_id = :w_id;
+		+=====================================================*/
+		double ol_total = 0;
+#if !TPCC_SMALL
+		// the small schema has neither OL_DELIVERY_D nor OL_AMOUNT
+		item = index_read(_wl->i_orderline, orderlineKey(w_id, d_id, no_o_id), part_id);
+		assert(item != NULL);
+		for (; item != NULL; item = item->next) {
+			row_t * r_ol_local = get_row<ALG>((row_t *) item->location, WR);
+			if (r_ol_local == NULL) {
+				return finish<ALG>(Abort);
+			}
+			double ol_amount;
+			r_ol_local->get_value(OL_AMOUNT, ol_amount);
+			r_ol_local->set_value(OL_DELIVERY_D, query->ol_delivery_d);
+			ol_total += ol_amount;
+		}
+#endif
+
+		/*=====================================================+
+			EXEC SQL UPDATE customer SET c_balance = c_balance + :ol_total,
+			c_delivery_cnt = c_delivery_cnt + 1
+			WHERE c_id = :c_id AND c_d_id = :d_id AND c_w_id = :w_id;
+		+=====================================================*/
+		item = index_read(_wl->i_customer_id, custKey(o_c_id, d_id, w_id), part_id);
+		assert(item != NULL);
+		row_t * r_cust_local = get_row<ALG>((row_t *) item->location, WR);
+		if (r_cust_local == NULL) {
+			return finish<ALG>(Abort);
 		}
-		
-		key = custKey(o_c_id, d_id, query->w_id);
-		itemid_t * item = index_read(_wl->i_customer_id, key, wh_to_part(query->w_id));
-		row_t * r_cust = (row_t *)item->location;
 		double c_balance;
+		r_cust_local->get_value(C_BALANCE, c_balance);
+		r_cust_local->set_value(C_BALANCE, c_balance + ol_total);
+#if !TPCC_SMALL
 		uint64_t c_delivery_cnt;
+		r_cust_local->get_value(C_DELIVERY_CNT, c_delivery_cnt);
+		r_cust_local->set_value(C_DELIVERY_CNT, c_delivery_cnt + 1);
+#endif
 	}
-*/
-	return RCOK;
+	assert( rc == RCOK );
+	rc = finish<ALG>(rc);
+	if (rc != RCOK)
+		return rc;
+	// what this txn saw delivered is committed now
+	for (uint64_t d_id = 1; d_id <= DIST_PER_WARE; d_id++)
+		if (scan_next[d_id] > scan_lo[d_id])
+			ATOM_CAS(_wl->undelivered[distKey(d_id, w_id)], scan_lo[d_id], scan_next[d_id]);
+	return rc;
 }
 
+template<int ALG>
 RC 
 tpcc_txn_man::run_stock_level(tpcc_query * query) {
-	return RCOK;
+	RC rc = RCOK;
+	itemid_t * item;
+	uint64_t w_id = query->w_id;
+	uint64_t d_id = query->d_id;
+	uint64_t part_id = wh_to_part(w_id);
+	/*=====================================================+
+		EXEC SQL SELECT d_next_o_id INTO :o_id
+		FROM district
+		WHERE d_w_id=:w_id AND d_id=:d_id;
+	+=====================================================*/
+	item = index_read(_wl->i_district, distKey(d_id, w_id), part_id);
+	assert(item != NULL);
+	row_t * r_dist_local = get_row<ALG>((row_t *) item->location, RD);
+	if (r_dist_local == NULL) {
+		return finish<ALG>(Abort);
+	}
+	int64_t o_id;
+	r_dist_local->get_value(D_NEXT_O_ID, o_id);
+
+	/*=====================================================+
+		EXEC SQL SELECT COUNT(DISTINCT (s_i_id)) INTO :stock_count
+		FROM order_line, stock
+		WHERE ol_w_id=:w_id AND
+		ol_d_id=:d_id AND ol_o_id<:o_id AND
+		ol_o_id>=:o_id-20 AND s_w_id=:w_id AND
+		s_i_id=ol_i_id AND s_quantity < :threshold;
+	+=====================================================*/
+	// the items of the last 20 orders, in one scan of ORDER-LINE_IDX. Only
+	// the columns read are copied, which of a PAX table is one array each.
+	uint64_t i_ids[20 * MAX_OL_CNT];
+	uint64_t i_cnt = 0;
+	uint64_t lo = (o_id > 20)? o_id - 20 : 1;
+	idx_cursor cursor;
+	index_scan(_wl->i_orderline, orderlineKey(w_id, d_id, lo), 
+		orderlineKey(w_id, d_id, o_id - 1), part_id, cursor);
+	while ((item = index_next(_wl->i_orderline, cursor)) != NULL) {
+		for (; item != NULL; item = item->next) {
+			row_t * r_ol_local = get_row<ALG>((row_t *) item->location, RD,
+				1UL << OL_I_ID);
+			if (r_ol_local == NULL) {
+				return finish<ALG>(Abort);
+			}
+			assert(i_cnt < 20 * MAX_OL_CNT);
+			r_ol_local->get_value(OL_I_ID, i_ids[i_cnt ++]);
+		}
+	}
+	std::sort(i_ids, i_ids + i_cnt);
+	i_cnt = std::unique(i_ids, i_ids + i_cnt) - i_ids;
+	uint64_t stock_count = 0;
+	for (uint64_t i = 0; i < i_cnt; i++) {
+		item = index_read(_wl->i_stock, stockKey(i_ids[i], w_id), part_id);
+		assert(item != NULL);
+		row_t * r_stock_local = get_row<ALG>((row_t *) item->location, RD,
+			1UL << S_QUANTITY);
+		if (r_stock_local == NULL) {
+			return finish<ALG>(Abort);
+		}
+		int64_t s_quantity;
+		r_stock_local->get_value(S_QUANTITY, s_quantity);
+		if (s_quantity < (int64_t) query->threshold)
+			stock_count ++;
+	}
+	assert( rc == RCOK );
+	return finish<ALG>(rc);
 }
+
+#define TPCC_RUN_TXN(alg) \
+	template RC tpcc_txn_man::run_txn<alg>(base_query *);
+CC_EACH(TPCC_RUN_TXN)
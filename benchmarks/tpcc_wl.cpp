@@ -5,13 +5,20 @@
 #include "thread.h"
 #include "table.h"
 #include "index_hash.h"
+#include "index_hash_lf.h"
 #include "index_btree.h"
+#include "index_btree_olc.h"
 #include "tpcc_helper.h"
 #include "row.h"
 #include "query.h"
 #include "txn.h"
 #include "mem_alloc.h"
 #include "tpcc_const.h"
+#include "checkpoint.h"
+
+#define BILLION 1000000000UL
+// rows read per column scan in check_consistency
+#define CHECK_CHUNK 1024
 
 RC tpcc_wl::init() {
 	workload::init();
@@ -24,8 +31,31 @@ RC tpcc_wl::init() {
 	cout << "reading schema file: " << path << endl;
 	init_schema( path.c_str() );
 	cout << "TPCC schema initialized" << endl;
-	init_table();
 	next_tid = 0;
+	// the orders as the loader makes them, which a checkpoint or an image
+	// also holds
+	uint64_t dist_cnt = distKey(DIST_PER_WARE, g_num_wh) + 1;
+	order_cnt = (volatile uint64_t *) _mm_malloc(sizeof(uint64_t) * dist_cnt, 64);
+	undelivered = (volatile uint64_t *) _mm_malloc(sizeof(uint64_t) * dist_cnt, 64);
+	for (uint64_t i = 0; i < dist_cnt; i++) {
+		order_cnt[i] = g_cust_per_dist;
+		undelivered[i] = min(2101UL, (uint64_t)g_cust_per_dist + 1);
+	}
+	if (g_params["image"] != "" || g_recover) {
+		// the loader threads would seed these for the query generator
+		tpcc_buffer = new drand48_data * [g_num_wh];
+		for (uint32_t i = 0; i < g_num_wh; i++) {
+			tpcc_buffer[i] = (drand48_data *) _mm_malloc(sizeof(drand48_data), 64);
+			srand48_r(i + 1, tpcc_buffer[i]);
+		}
+		if (g_params["image"] != "")
+			ckpt_man.load_image(this, g_params["image"].c_str());
+		else
+			ckpt_man.recover(this);
+		find_undelivered();
+		check_consistency();
+	} else
+		init_table();
 	return RCOK;
 }
 
@@ -47,6 +77,10 @@ RC tpcc_wl::init_schema(const char * schema_file) {
 	i_customer_id = indexes["CUSTOMER_ID_IDX"];
 	i_customer_last = indexes["CUSTOMER_LAST_IDX"];
 	i_stock = indexes["STOCK_IDX"];
+	i_order = indexes["ORDER_IDX"];
+	i_order_cust = indexes["ORDER_CUST_IDX"];
+	i_neworder = indexes["NEW-ORDER_IDX"];
+	i_orderline = indexes["ORDER-LINE_IDX"];
 	return RCOK;
 }
 
@@ -84,9 +118,173 @@ RC tpcc_wl::get_txn_man(txn_man *& txn_manager, thread_t * h_thd) {
 	return RCOK;
 }
 
+// The keys are those the loaders below insert with. The ids loaded from a
+// UInt32 are taken from the primary key.
+void tpcc_wl::index_row(table_t * table, row_t * row) {
+	uint64_t part_id = row->get_part_id();
+	uint64_t id = row->get_primary_key();
+	uint64_t w_id;
+	uint64_t d_id;
+	uint64_t o_id;
+	uint64_t c_id;
+	if (table == t_item)
+		index_insert(i_item, id, row, 0);
+	else if (table == t_warehouse)
+		index_insert(i_warehouse, id, row, part_id);
+	else if (table == t_district) {
+		row->get_value(D_W_ID, w_id);
+		index_insert(i_district, distKey(id, w_id), row, part_id);
+	} else if (table == t_stock) {
+		row->get_value(S_W_ID, w_id);
+		index_insert(i_stock, stockKey(id, w_id), row, part_id);
+	} else if (table == t_customer) {
+		row->get_value(C_D_ID, d_id);
+		row->get_value(C_W_ID, w_id);
+		index_insert(i_customer_last, custNPKey(row->get_value(C_LAST), d_id, w_id), row, part_id);
+		index_insert(i_customer_id, custKey(id, d_id, w_id), row, part_id);
+	} else if (table == t_order) {
+		row->get_value(O_D_ID, d_id);
+		row->get_value(O_W_ID, w_id);
+		row->get_value(O_C_ID, c_id);
+		index_insert(i_order, orderPrimaryKey(w_id, d_id, id), row, part_id);
+		index_insert(i_order_cust, custKey(c_id, d_id, w_id), row, part_id);
+	} else if (table == t_neworder) {
+		// a delivered new order has its NO_O_ID negated
+		int64_t no_o_id;
+		row->get_value(NO_O_ID, no_o_id);
+		row->get_value(NO_D_ID, d_id);
+		row->get_value(NO_W_ID, w_id);
+		o_id = (no_o_id < 0)? -no_o_id : no_o_id;
+		index_insert(i_neworder, orderPrimaryKey(w_id, d_id, o_id), row, part_id);
+		// deliveries may scan up to this order now
+		uint64_t dist = distKey(d_id, w_id);
+		uint64_t cnt = order_cnt[dist];
+		while (cnt < o_id && !ATOM_CAS(order_cnt[dist], cnt, o_id))
+			cnt = order_cnt[dist];
+	} else if (table == t_orderline) {
+		row->get_value(OL_O_ID, o_id);
+		row->get_value(OL_D_ID, d_id);
+		row->get_value(OL_W_ID, w_id);
+		index_insert(i_orderline, orderlineKey(w_id, d_id, o_id), row, part_id);
+	}
+	// HISTORY has no index
+}
+
+// Orders are delivered oldest first, so the hint of a district passes the
+// delivered new orders in front.
+void tpcc_wl::find_undelivered() {
+	for (uint64_t w_id = 1; w_id <= g_num_wh; w_id++)
+		for (uint64_t d_id = 1; d_id <= DIST_PER_WARE; d_id++) {
+			uint64_t dist = distKey(d_id, w_id);
+			while (undelivered[dist] <= order_cnt[dist]) {
+				itemid_t * item = NULL;
+				i_neworder->index_read(orderPrimaryKey(w_id, d_id, undelivered[dist]), 
+					item, wh_to_part(w_id), 0);
+				int64_t no_o_id = 0;
+				if (item != NULL)
+					((row_t *) item->location)->get_value(NO_O_ID, no_o_id);
+				if (no_o_id >= 0)
+					break;
+				undelivered[dist] ++;
+			}
+		}
+}
+
+// Reads columns `cols` of up to CHECK_CHUNK rows of `table` from `start`,
+// a column at a time, into vals[c * CHECK_CHUNK + i]. Holes are left out, so
+// i counts the rows returned.
+static uint64_t scan_rows(table_t * table, uint64_t part_id, uint64_t start, 
+		int * cols, int col_cnt, int64_t * vals) {
+	uint64_t cnt = min((uint64_t) CHECK_CHUNK, table->get_row_cnt(part_id) - start);
+	for (int c = 0; c < col_cnt; c++)
+		table->scan_column(part_id, cols[c], start, cnt, (char *) &vals[c * CHECK_CHUNK]);
+	uint64_t n = 0;
+	for (uint64_t i = 0; i < cnt; i++) {
+		if (table->get_row(part_id, start + i)->is_hole())
+			continue;
+		for (int c = 0; c < col_cnt; c++)
+			vals[c * CHECK_CHUNK + n] = vals[c * CHECK_CHUNK + i];
+		n ++;
+	}
+	return n;
+}
+
+// TPC-C consistency conditions 2 to 4 (clause 3.3.2) of each district.
+// A delivered new order has its NO_O_ID negated rather than being deleted.
+void tpcc_wl::check_consistency() {
+	uint64_t starttime = get_server_clock();
+	uint64_t dist_cnt = distKey(DIST_PER_WARE, g_num_wh) + 1;
+	vector<int64_t> next_o_id(dist_cnt, 0);
+	vector<int64_t> max_o_id(dist_cnt, 0);
+	vector<int64_t> ol_sum(dist_cnt, 0);
+	vector<int64_t> max_no_o_id(dist_cnt, 0);
+	vector<int64_t> new_lo(dist_cnt, INT64_MAX);
+	vector<int64_t> new_hi(dist_cnt, 0);
+	vector<int64_t> new_cnt(dist_cnt, 0);
+	vector<int64_t> ol_cnt(dist_cnt, 0);
+	int64_t vals[4 * CHECK_CHUNK];
+	for (uint64_t part_id = 0; part_id < g_part_cnt; part_id++) {
+		int d_cols[] = {D_ID, D_W_ID, D_NEXT_O_ID};
+		for (uint64_t start = 0; start < t_district->get_row_cnt(part_id); start += CHECK_CHUNK) {
+			uint64_t n = scan_rows(t_district, part_id, start, d_cols, 3, vals);
+			for (uint64_t i = 0; i < n; i++)
+				next_o_id[distKey(vals[i], vals[CHECK_CHUNK + i])] = vals[2 * CHECK_CHUNK + i];
+		}
+		int o_cols[] = {O_D_ID, O_W_ID, O_ID, O_OL_CNT};
+		for (uint64_t start = 0; start < t_order->get_row_cnt(part_id); start += CHECK_CHUNK) {
+			uint64_t n = scan_rows(t_order, part_id, start, o_cols, 4, vals);
+			for (uint64_t i = 0; i < n; i++) {
+				uint64_t dist = distKey(vals[i], vals[CHECK_CHUNK + i]);
+				max_o_id[dist] = max(max_o_id[dist], vals[2 * CHECK_CHUNK + i]);
+				ol_sum[dist] += vals[3 * CHECK_CHUNK + i];
+			}
+		}
+		int no_cols[] = {NO_D_ID, NO_W_ID, NO_O_ID};
+		for (uint64_t start = 0; start < t_neworder->get_row_cnt(part_id); start += CHECK_CHUNK) {
+			uint64_t n = scan_rows(t_neworder, part_id, start, no_cols, 3, vals);
+			for (uint64_t i = 0; i < n; i++) {
+				uint64_t dist = distKey(vals[i], vals[CHECK_CHUNK + i]);
+				int64_t no_o_id = vals[2 * CHECK_CHUNK + i];
+				max_no_o_id[dist] = max(max_no_o_id[dist], (no_o_id < 0)? -no_o_id : no_o_id);
+				if (no_o_id < 0)
+					continue;
+				new_lo[dist] = min(new_lo[dist], no_o_id);
+				new_hi[dist] = max(new_hi[dist], no_o_id);
+				new_cnt[dist] ++;
+			}
+		}
+		int ol_cols[] = {OL_D_ID, OL_W_ID};
+		for (uint64_t start = 0; start < t_orderline->get_row_cnt(part_id); start += CHECK_CHUNK) {
+			uint64_t n = scan_rows(t_orderline, part_id, start, ol_cols, 2, vals);
+			for (uint64_t i = 0; i < n; i++)
+				ol_cnt[distKey(vals[i], vals[CHECK_CHUNK + i])] ++;
+		}
+	}
+	uint64_t bad_cnt = 0;
+	for (uint64_t w_id = 1; w_id <= g_num_wh; w_id++)
+		for (uint64_t d_id = 1; d_id <= DIST_PER_WARE; d_id++) {
+			uint64_t dist = distKey(d_id, w_id);
+			bool ok = (next_o_id[dist] - 1 == max_o_id[dist]) && ol_sum[dist] == ol_cnt[dist];
+			if (max_no_o_id[dist] > 0 && max_no_o_id[dist] != max_o_id[dist])
+				ok = false;
+			if (new_cnt[dist] > 0 && new_hi[dist] - new_lo[dist] + 1 != new_cnt[dist])
+				ok = false;
+			if (ok)
+				continue;
+			bad_cnt ++;
+			printf("district (%ld, %ld) is inconsistent: D_NEXT_O_ID=%ld max(O_ID)=%ld "
+				"max(NO_O_ID)=%ld new orders %ld in [%ld, %ld] sum(O_OL_CNT)=%ld order lines %ld\n",
+				w_id, d_id, next_o_id[dist], max_o_id[dist], max_no_o_id[dist], new_cnt[dist], 
+				new_lo[dist], new_hi[dist], ol_sum[dist], ol_cnt[dist]);
+		}
+	printf("checked the consistency of %ld districts in %f s, %ld inconsistent\n", 
+		(uint64_t) g_num_wh * DIST_PER_WARE, 
+		(double)(get_server_clock() - starttime) / BILLION, bad_cnt);
+}
+
 // TODO ITEM table is assumed to be in partition 0 (init by thread 0)
 void tpcc_wl::init_tab_item() {
-	for (UInt32 i = 1; i <= g_max_items; i++) {
+	for (uint64_t i = 1; i <= g_max_items; i++) {
 		row_t * row;
 		uint64_t row_id;
 		t_item->get_new_row(row, 0, row_id);
@@ -113,7 +311,7 @@ void tpcc_wl::init_tab_wh(uint32_t wid) {
 	assert(wid >= 1 && wid <= g_num_wh);
 	row_t * row;
 	uint64_t row_id;
-	t_warehouse->get_new_row(row, 0, row_id);
+	t_warehouse->get_new_row(row, wh_to_part(wid), row_id);
 	row->set_primary_key(wid);
 
 	row->set_value(W_ID, wid);
@@ -146,7 +344,7 @@ void tpcc_wl::init_tab_dist(uint64_t wid) {
 	for (uint64_t did = 1; did <= DIST_PER_WARE; did++) {
 		row_t * row;
 		uint64_t row_id;
-		t_district->get_new_row(row, 0, row_id);
+		t_district->get_new_row(row, wh_to_part(wid), row_id);
 		row->set_primary_key(did);
 		
 		row->set_value(D_ID, did);
@@ -171,7 +369,7 @@ void tpcc_wl::init_tab_dist(uint64_t wid) {
     	double w_ytd=30000.00;
 		row->set_value(D_TAX, tax);
 		row->set_value(D_YTD, w_ytd);
-		row->set_value(D_NEXT_O_ID, 3001);
+		row->set_value(D_NEXT_O_ID, (int64_t) g_cust_per_dist + 1);
 		
 		index_insert(i_district, distKey(did, wid), row, wh_to_part(wid));
 	}
@@ -179,10 +377,10 @@ void tpcc_wl::init_tab_dist(uint64_t wid) {
 
 void tpcc_wl::init_tab_stock(uint64_t wid) {
 	
-	for (UInt32 sid = 1; sid <= g_max_items; sid++) {
+	for (uint64_t sid = 1; sid <= g_max_items; sid++) {
 		row_t * row;
 		uint64_t row_id;
-		t_stock->get_new_row(row, 0, row_id);
+		t_stock->get_new_row(row, wh_to_part(wid), row_id);
 		row->set_primary_key(sid);
 		row->set_value(S_I_ID, sid);
 		row->set_value(S_W_ID, wid);
@@ -219,10 +417,10 @@ void tpcc_wl::init_tab_stock(uint64_t wid) {
 
 void tpcc_wl::init_tab_cust(uint64_t did, uint64_t wid) {
 	assert(g_cust_per_dist >= 1000);
-	for (UInt32 cid = 1; cid <= g_cust_per_dist; cid++) {
+	for (uint64_t cid = 1; cid <= g_cust_per_dist; cid++) {
 		row_t * row;
 		uint64_t row_id;
-		t_customer->get_new_row(row, 0, row_id);
+		t_customer->get_new_row(row, wh_to_part(wid), row_id);
 		row->set_primary_key(cid);
 
 		row->set_value(C_ID, cid);		
@@ -285,7 +483,7 @@ void tpcc_wl::init_tab_cust(uint64_t did, uint64_t wid) {
 void tpcc_wl::init_tab_hist(uint64_t c_id, uint64_t d_id, uint64_t w_id) {
 	row_t * row;
 	uint64_t row_id;
-	t_history->get_new_row(row, 0, row_id);
+	t_history->get_new_row(row, wh_to_part(w_id), row_id);
 	row->set_primary_key(0);
 	row->set_value(H_C_ID, c_id);
 	row->set_value(H_C_D_ID, d_id);
@@ -305,10 +503,10 @@ void tpcc_wl::init_tab_hist(uint64_t c_id, uint64_t d_id, uint64_t w_id) {
 void tpcc_wl::init_tab_order(uint64_t did, uint64_t wid) {
 	uint64_t perm[g_cust_per_dist]; 
 	init_permutation(perm, wid); /* initialize permutation of customer numbers */
-	for (UInt32 oid = 1; oid <= g_cust_per_dist; oid++) {
+	for (uint64_t oid = 1; oid <= g_cust_per_dist; oid++) {
 		row_t * row;
 		uint64_t row_id;
-		t_order->get_new_row(row, 0, row_id);
+		t_order->get_new_row(row, wh_to_part(wid), row_id);
 		row->set_primary_key(oid);
 		uint64_t o_ol_cnt = 1;
 		uint64_t cid = perm[oid - 1]; //get_permutation();
@@ -325,16 +523,19 @@ void tpcc_wl::init_tab_order(uint64_t did, uint64_t wid) {
 		o_ol_cnt = URand(5, 15, wid-1);
 		row->set_value(O_OL_CNT, o_ol_cnt);
 		row->set_value(O_ALL_LOCAL, 1);
+		// a customer's orders are listed newest first
+		index_insert(i_order, orderPrimaryKey(wid, did, oid), row, wh_to_part(wid));
+		index_insert(i_order_cust, custKey(cid, did, wid), row, wh_to_part(wid));
 		
 		// ORDER-LINE	
-#if !TPCC_SMALL
-		for (uint32_t ol = 1; ol <= o_ol_cnt; ol++) {
-			t_orderline->get_new_row(row, 0, row_id);
+		for (uint64_t ol = 1; ol <= o_ol_cnt; ol++) {
+			t_orderline->get_new_row(row, wh_to_part(wid), row_id);
 			row->set_value(OL_O_ID, oid);
 			row->set_value(OL_D_ID, did);
 			row->set_value(OL_W_ID, wid);
 			row->set_value(OL_NUMBER, ol);
-			row->set_value(OL_I_ID, URand(1, 100000, wid-1));
+			row->set_value(OL_I_ID, URand(1, g_max_items, wid-1));
+#if !TPCC_SMALL
 			row->set_value(OL_SUPPLY_W_ID, wid);
 			if (oid < 2101) {
 				row->set_value(OL_DELIVERY_D, o_entry);
@@ -347,14 +548,16 @@ void tpcc_wl::init_tab_order(uint64_t did, uint64_t wid) {
 			char ol_dist_info[24];
 	        MakeAlphaString(24, 24, ol_dist_info, wid-1);
 			row->set_value(OL_DIST_INFO, ol_dist_info);
-		}
 #endif
+			index_insert(i_orderline, orderlineKey(wid, did, oid), row, wh_to_part(wid));
+		}
 		// NEW ORDER
 		if (oid > 2100) {
-			t_neworder->get_new_row(row, 0, row_id);
+			t_neworder->get_new_row(row, wh_to_part(wid), row_id);
 			row->set_value(NO_O_ID, oid);
 			row->set_value(NO_D_ID, did);
 			row->set_value(NO_W_ID, wid);
+			index_insert(i_neworder, orderPrimaryKey(wid, did, oid), row, wh_to_part(wid));
 		}
 	}
 }
@@ -390,6 +593,8 @@ void * tpcc_wl::threadInitWarehouse(void * This) {
 	tpcc_wl * wl = (tpcc_wl *) This;
 	int tid = ATOM_FETCH_ADD(wl->next_tid, 1);
 	uint32_t wid = tid + 1;
+	// the warehouse's rows go to partition wh_to_part(wid), touched first by this thread
+	set_affinity(tid);
 	tpcc_buffer[tid] = (drand48_data *) _mm_malloc(sizeof(drand48_data), 64);
 	assert((uint64_t)tid < g_num_wh);
 	srand48_r(wid, tpcc_buffer[tid]);
@@ -14,12 +14,14 @@ public :
 	RC init_table();
 	RC init_schema(string schema_file);
 	RC get_txn_man(txn_man *& txn_manager, thread_t * h_thd);
+	void index_row(table_t * table, row_t * row);
 	int key_to_part(uint64_t key);
 	INDEX * the_index; // The only index we will use in YCSB
 	table_t * the_table; // The only table we will use in YCSB
 private:
 	void init_table_parallel();
 	void * init_table_slice();
+	void init_row(uint64_t key);
 	static void * threadInitTable(void * This) {
 		((ycsb_wl *)This)->init_table_slice(); 
 		return NULL;
@@ -33,6 +35,8 @@ class ycsb_txn_man : public txn_man
 {
 public:
 	void init(thread_t * h_thd, workload * h_wl, uint64_t part_id); 
+	// Run a txn/query and get running code. Resouces are handled internally. If abort, may restart later
+	template<int ALG>
 	RC run_txn(base_query * query);
 private:
 	uint64_t row_cnt;
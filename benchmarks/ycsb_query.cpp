@@ -17,7 +17,15 @@ void ycsb_query::init(uint64_t thd_id, workload * h_wl, Query_thd * query_thd) {
 	zeta_2_theta = zeta(2, g_zipf_theta);
 	assert(the_n != 0);
 	assert(denom != 0);
-	gen_requests(thd_id, h_wl);
+}
+
+uint32_t ycsb_query::get_cmd_size() {
+	return sizeof(uint64_t) + sizeof(ycsb_request) * request_cnt;
+}
+
+void ycsb_query::write_cmd(char * buf) {
+	memcpy(buf, &request_cnt, sizeof(uint64_t));
+	memcpy(buf + sizeof(uint64_t), requests, sizeof(ycsb_request) * request_cnt);
 }
 
 void 
@@ -56,11 +64,10 @@ uint64_t ycsb_query::zipf(uint64_t n, double theta) {
 	return 1 + (uint64_t)(n * pow(eta*u -eta + 1, alpha));
 }
 
-void ycsb_query::gen_requests(uint64_t thd_id, workload * h_wl) {
-#if CC_ALG == HSTORE
-	assert(g_virtual_part_cnt == g_part_cnt);
-#endif
-	int access_cnt = 0; // No use?
+void ycsb_query::gen_requests(uint64_t thd_id) {
+	if (g_cc_alg == HSTORE)
+		assert(g_virtual_part_cnt == g_part_cnt);
+	int access_cnt = 0; // Rows the txn will access, bounded by MAX_ROW_PER_TXN
 	set<uint64_t> all_keys; // No use?
 	part_num = 0;
 	double r = 0;
@@ -115,6 +122,9 @@ void ycsb_query::gen_requests(uint64_t thd_id, workload * h_wl) {
 		int64_t rint64;
 		lrand48_r(&_query_thd->buffer, &rint64);
 		req->value = rint64 % (1<<8); // A random byte
+		// A txn has MAX_ROW_PER_TXN access slots
+		if (access_cnt + ((req->rtype == SCAN)? req->scan_len : 1) > MAX_ROW_PER_TXN)
+			continue;
 		// Make sure a single row is not accessed twice
 		if (req->rtype == RD || req->rtype == WR) {
 			if (all_keys.find(req->key) == all_keys.end()) { // If it's a different record from before, valid
@@ -122,23 +132,28 @@ void ycsb_query::gen_requests(uint64_t thd_id, workload * h_wl) {
 				access_cnt ++;
 			} else continue; // If not valid, check next candidate
 		} else {
+			// A scan reads the next scan_len keys of the partition in index
+			// order. Keys of a partition are g_part_cnt apart.
 			bool conflict = false;
 			for (UInt32 i = 0; i < req->scan_len; i++) { // If all elem not scanned before, this total scan is valid
-				primary_key = (row_id + i) * g_part_cnt + part_id;
-				if (all_keys.find( primary_key )
+				if (all_keys.find( req->key + i * g_part_cnt )
 					!= all_keys.end())
 					conflict = true;
 			}
 			if (conflict) continue;
 			else {
 				for (UInt32 i = 0; i < req->scan_len; i++) // Simply insert all keys in this scan
-					all_keys.insert( (row_id + i) * g_part_cnt + part_id);
-				access_cnt += SCAN_LEN;
+					all_keys.insert( req->key + i * g_part_cnt );
+				access_cnt += req->scan_len;
 			}
 		}
 		rid ++;
 	}
 	request_cnt = rid;
+	read_only = true;
+	for (UInt32 i = 0; i < request_cnt; i++)
+		if (requests[i].rtype == WR)
+			read_only = false;
 
 	// Sort the requests in key order.
 	if (g_key_order) {
@@ -24,14 +24,17 @@ public:
 	void init(uint64_t thd_id, workload * h_wl) { assert(false); };
 	// Init a single query/txn which attaches to the specified thread
 	void init(uint64_t thd_id, workload * h_wl, Query_thd * query_thd);
+	void gen(uint64_t thd_id) { gen_requests(thd_id); };
 	static void calculateDenom();
+	uint32_t get_cmd_size();
+	void write_cmd(char * buf);
 
 	uint64_t request_cnt; // Valid requests we actually generate
 	ycsb_request * requests; // Req in this query, will be sorted in key order
 
 private:
 	// Generate req for a certain thread
-	void gen_requests(uint64_t thd_id, workload * h_wl);
+	void gen_requests(uint64_t thd_id);
 	// for Zipfian distribution
 	static double zeta(uint64_t n, double theta);
 	uint64_t zipf(uint64_t n, double theta);
@@ -7,7 +7,9 @@
 #include "table.h"
 #include "row.h"
 #include "index_hash.h"
+#include "index_hash_lf.h"
 #include "index_btree.h"
+#include "index_btree_olc.h"
 #include "catalog.h"
 #include "manager.h"
 #include "row_lock.h"
@@ -21,6 +23,7 @@ void ycsb_txn_man::init(thread_t * h_thd, workload * h_wl, uint64_t thd_id) {
 	_wl = (ycsb_wl *) h_wl;
 }
 // Does not include a query engine, simply read or write. Each txn=query, and includes ~16 record accesses
+template<int ALG>
 RC ycsb_txn_man::run_txn(base_query * query) {
 	RC rc;
 	ycsb_query * m_query = (ycsb_query *) query;
@@ -33,22 +36,24 @@ RC ycsb_txn_man::run_txn(base_query * query) {
 		int part_id = wl->key_to_part( req->key );
 		bool finish_req = false;
 		UInt32 iteration = 0; // Used for scan
+		idx_cursor cursor;
+		// the partition holds every g_part_cnt-th key, see ycsb_wl::key_to_part
+		if (req->rtype == SCAN)
+			index_scan(_wl->the_index, req->key, 
+				req->key + (req->scan_len - 1) * g_part_cnt, part_id, cursor);
 		while ( !finish_req ) {
-			if (iteration == 0) {
+			if (req->rtype != SCAN)
 				m_item = index_read(_wl->the_index, req->key, part_id);
-			} 
-#if INDEX_STRUCT == IDX_BTREE
 			else {
-				_wl->the_index->index_next(get_thd_id(), m_item);
-				if (m_item == NULL)
+				m_item = index_next(_wl->the_index, cursor);
+				if (m_item == NULL) // The range ends at the last key of the partition
 					break;
 			}
-#endif
 			row_t * row = ((row_t *)m_item->location);
 			row_t * row_local; // Can index to a remote location, if so, may create a copy in local partition (OCC), can also reference the original one (MVCC)
 			access_t type = req->rtype;
 			
-			row_local = get_row(row, type); // If scan, we will change row by advancing `iteration`
+			row_local = get_row<ALG>(row, type); // If scan, we will change row by advancing `iteration`
 			if (row_local == NULL) {
 				rc = Abort;
 				goto final;
@@ -60,8 +65,8 @@ RC ycsb_txn_man::run_txn(base_query * query) {
                 if (req->rtype == RD || req->rtype == SCAN) {
 //                  for (int fid = 0; fid < schema->get_field_cnt(); fid++) {
 						int fid = 0;
-						char * data = row_local->get_data();
-						__attribute__((unused)) uint64_t fval = *(uint64_t *)(&data[fid * 10]); // Try to read an int64 from this row
+						char * data = row_local->get_value(fid);
+						__attribute__((unused)) uint64_t fval = *(uint64_t *)data; // Try to read an int64 from this row
 //                  }
                 } else {
                     assert(req->rtype == WR);
@@ -69,8 +74,8 @@ RC ycsb_txn_man::run_txn(base_query * query) {
 						int fid = 0;
 						// NOTE: Should write to the local copy before commit, so it should be `row_local` here
 						// See https://github.com/yxymit/DBx1000/issues/12#issuecomment-340285907
-						char * data = row->get_data();
-						*(uint64_t *)(&data[fid * 10]) = 0; // Try to write an int64 to this row
+						char * data = row->get_value(fid);
+						*(uint64_t *)data = 0; // Try to write an int64 to this row
 //					}
                 } 
             }
@@ -83,7 +88,10 @@ RC ycsb_txn_man::run_txn(base_query * query) {
 	}
 	rc = RCOK;
 final:
-	rc = finish(rc); // For OCC, validate + write back
+	rc = finish<ALG>(rc); // For OCC, validate + write back
 	return rc;
 }
 
+#define YCSB_RUN_TXN(alg) \
+	template RC ycsb_txn_man::run_txn<alg>(base_query *);
+CC_EACH(YCSB_RUN_TXN)
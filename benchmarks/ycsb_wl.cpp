@@ -7,7 +7,9 @@
 #include "table.h"
 #include "row.h"
 #include "index_hash.h"
+#include "index_hash_lf.h"
 #include "index_btree.h"
+#include "index_btree_olc.h"
 #include "catalog.h"
 #include "manager.h"
 #include "row_lock.h"
@@ -15,6 +17,7 @@
 #include "row_mvcc.h"
 #include "mem_alloc.h"
 #include "query.h"
+#include "checkpoint.h"
 
 int ycsb_wl::next_tid;
 // Init tables and indexes
@@ -24,7 +27,12 @@ RC ycsb_wl::init() {
 	string path = "./benchmarks/YCSB_schema.txt";
 	init_schema( path );
 	
-	init_table_parallel();
+	if (g_params["image"] != "")
+		ckpt_man.load_image(this, g_params["image"].c_str());
+	else if (g_recover)
+		ckpt_man.recover(this);
+	else
+		init_table_parallel();
 //	init_table();
 	return RCOK;
 }
@@ -35,11 +43,14 @@ RC ycsb_wl::init_schema(string schema_file) {
 	the_index = indexes["MAIN_INDEX"];
 	return RCOK;
 }
+void ycsb_wl::index_row(table_t * table, row_t * row) {
+	index_insert(the_index, row->get_primary_key(), row, row->get_part_id());
+}
 // Which partition this key locates
 int 
 ycsb_wl::key_to_part(uint64_t key) {
-	uint64_t rows_per_part = g_synth_table_size / g_part_cnt;
-	return key / rows_per_part;
+	// same interleaving as ycsb_query::gen_requests
+	return key % g_part_cnt;
 }
 
 RC ycsb_wl::init_table() {
@@ -66,15 +77,7 @@ RC ycsb_wl::init_table() {
 					value[i] = (char)rand() % (1<<8) ; // Give each byte a random value
 				new_row->set_value(fid, value);
 			}
-            itemid_t * m_item = 
-                (itemid_t *) mem_allocator.alloc( sizeof(itemid_t), part_id );
-			assert(m_item != NULL);
-            m_item->type = DT_row;
-            m_item->location = new_row;
-            m_item->valid = true;
-            uint64_t idx_key = primary_key; // Use prikey for indexing
-            rc = the_index->index_insert(idx_key, m_item, part_id);
-            assert(rc == RCOK);
+            index_insert(the_index, primary_key, new_row, part_id); // Use prikey for indexing
             total_row ++;
         }
     }
@@ -109,43 +112,44 @@ void * ycsb_wl::init_table_slice() {
 	set_affinity(tid);
 
 	mem_allocator.register_thread(tid);
-	RC rc;
 	assert(g_synth_table_size % g_init_parallelism == 0);
 	assert(tid < g_init_parallelism);
 	while ((UInt32)ATOM_FETCH_ADD(next_tid, 0) < g_init_parallelism) {}
 	assert((UInt32)ATOM_FETCH_ADD(next_tid, 0) == g_init_parallelism);
+	if (g_part_alloc) {
+		// Load whole partitions so that a partition is first touched by one thread.
+		for (uint64_t part_id = tid; part_id < g_part_cnt; part_id += g_init_parallelism)
+			for (uint64_t key = part_id; key < g_synth_table_size; key += g_part_cnt)
+				init_row(key);
+		return NULL;
+	}
 	uint64_t slice_size = g_synth_table_size / g_init_parallelism; // Slice I'm responsible for
 	for (uint64_t key = slice_size * tid; // My currently checking key
 			key < slice_size * (tid + 1); 
 			key ++
-	) {
-		row_t * new_row = NULL;
-		uint64_t row_id;
-		int part_id = key_to_part(key);
-		rc = the_table->get_new_row(new_row, part_id, row_id); 
-		assert(rc == RCOK);
-		uint64_t primary_key = key;
-		new_row->set_primary_key(primary_key);
-		new_row->set_value(0, &primary_key);
-		Catalog * schema = the_table->get_schema();
-		
-		for (UInt32 fid = 0; fid < schema->get_field_cnt(); fid ++) { // Will overwrite prikey?
-			char value[6] = "hello"; // Will read out of bound?
-			new_row->set_value(fid, value);
-		}
+	)
+		init_row(key);
+	return NULL;
+}
 
-		itemid_t * m_item =
-			(itemid_t *) mem_allocator.alloc( sizeof(itemid_t), part_id );
-		assert(m_item != NULL);
-		m_item->type = DT_row;
-		m_item->location = new_row;
-		m_item->valid = true;
-		uint64_t idx_key = primary_key;
-		
-		rc = the_index->index_insert(idx_key, m_item, part_id);
-		assert(rc == RCOK);
+void ycsb_wl::init_row(uint64_t key) {
+	RC rc;
+	row_t * new_row = NULL;
+	uint64_t row_id;
+	int part_id = key_to_part(key);
+	rc = the_table->get_new_row(new_row, part_id, row_id); 
+	assert(rc == RCOK);
+	uint64_t primary_key = key;
+	new_row->set_primary_key(primary_key);
+	new_row->set_value(0, &primary_key);
+	Catalog * schema = the_table->get_schema();
+	
+	for (UInt32 fid = 0; fid < schema->get_field_cnt(); fid ++) { // Will overwrite prikey?
+		char value[6] = "hello"; // Will read out of bound?
+		new_row->set_value(fid, value);
 	}
-	return NULL;
+
+	index_insert(the_index, primary_key, new_row, part_id);
 }
 // Create a new transaction manager and bind it to this hardware/simulator thread
 RC ycsb_wl::get_txn_man(txn_man *& txn_manager, thread_t * h_thd){
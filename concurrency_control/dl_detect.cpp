@@ -15,6 +15,31 @@
 void DL_detect::init() {
 	dependency = new DepThd[g_thread_cnt];
 	V = g_thread_cnt;
+	for (int i = 0; i < V; i++) {
+		pthread_mutex_init( &dependency[i].lock, NULL );
+		dependency[i].txnid = -1;
+		dependency[i].num_locks = 0;
+	}
+	if (!g_dl_detect_thread)
+		return;
+	_slots = (WaitSlot *) _mm_malloc(sizeof(WaitSlot) * V, CL_SIZE);
+	for (int i = 0; i < V; i++) {
+		_slots[i].seq = 0;
+		_slots[i].txnid = -1;
+		_slots[i].num_locks = 0;
+		_slots[i].cnt = 0;
+		_slots[i].waits_for = (uint64_t *) _mm_malloc(sizeof(uint64_t) * V, CL_SIZE);
+	}
+	_snap_seq = new uint64_t [V];
+	_snap_txnid = new int64_t [V];
+	_snap_num_locks = new int [V];
+	_snap_edges = new vector<uint64_t> [V];
+	_dirty = new bool [V];
+	_visited = new bool [V];
+	for (int i = 0; i < V; i++) {
+		_snap_seq[i] = UINT64_MAX;
+		_snap_txnid[i] = -1;
+	}
 }
 
 int
@@ -22,6 +47,19 @@ DL_detect::add_dep(uint64_t txnid1, uint64_t * txnids, int cnt, int num_locks) {
 	if (g_no_dl)
 		return 0;
 	int thd1 = get_thdid_from_txnid(txnid1);
+	if (g_dl_detect_thread) {
+		WaitSlot * slot = &_slots[thd1];
+		slot->seq ++;
+		COMPILER_BARRIER
+		for (int i = 0; i < cnt; i++)
+			slot->waits_for[i] = txnids[i];
+		slot->cnt = cnt;
+		slot->num_locks = num_locks;
+		slot->txnid = txnid1;
+		COMPILER_BARRIER
+		slot->seq ++;
+		return 0;
+	}
 	pthread_mutex_lock( &dependency[thd1].lock );
 	dependency[thd1].txnid = txnid1;
 	dependency[thd1].num_locks = num_locks;
@@ -144,6 +182,18 @@ void DL_detect::clear_dep(uint64_t txnid) {
 	if (g_no_dl)
 		return;
 	int thd = get_thdid_from_txnid(txnid);
+	if (g_dl_detect_thread) {
+		WaitSlot * slot = &_slots[thd];
+		if (slot->txnid == -1)
+			return;
+		slot->seq ++;
+		COMPILER_BARRIER
+		slot->txnid = -1;
+		slot->cnt = 0;
+		COMPILER_BARRIER
+		slot->seq ++;
+		return;
+	}
 	pthread_mutex_lock( &dependency[thd].lock );
 	
 	dependency[thd].adj.clear();
@@ -153,3 +203,102 @@ void DL_detect::clear_dep(uint64_t txnid) {
 	pthread_mutex_unlock( &dependency[thd].lock );
 }
 
+
+void DL_detect::start() {
+	_stop = false;
+	pthread_create(&_thd, NULL, run_detector, this);
+}
+
+void DL_detect::stop() {
+	_stop = true;
+	pthread_join(_thd, NULL);
+}
+
+void * DL_detect::run_detector(void * This) {
+	((DL_detect *) This)->run();
+	return NULL;
+}
+
+void DL_detect::run() {
+	vector<int> cycle;
+	while (!_stop) {
+		uint64_t starttime = get_sys_clock();
+		// a new cycle has an edge that was added since the last round, so
+		// only the txns that started waiting since then are searched from
+		if (snapshot()) {
+			INC_GLOB_STATS(cycle_detect, 1);
+			for (int thd = 0; thd < V; thd++) {
+				if (!_dirty[thd])
+					continue;
+				_dirty[thd] = false;
+				for (int i = 0; i < V; i++)
+					_visited[i] = false;
+				cycle.clear();
+				if (!find_cycle(thd, thd, cycle))
+					continue;
+				// The snapshot may mix states of different times. The cycle
+				// is real if none of its slots changed since it was read.
+				bool valid = true;
+				int victim = -1;
+				for (uint32_t i = 0; i < cycle.size(); i++) {
+					int t = cycle[i];
+					if (_slots[t].seq != _snap_seq[t])
+						valid = false;
+					// the txn that performs the least amount of work
+					if (victim == -1 || _snap_num_locks[t] < _snap_num_locks[victim])
+						victim = t;
+				}
+				if (!valid)
+					continue;
+				INC_GLOB_STATS(deadlock, 1);
+				glob_manager->get_txn_man(victim)->lock_abort = true;
+				// its edges stay until it gives up its locks
+				_snap_txnid[victim] = -1;
+			}
+			INC_GLOB_STATS(dl_detect_time, get_sys_clock() - starttime);
+		}
+		usleep(g_dl_loop_detect / 1000 > 0? g_dl_loop_detect / 1000 : 1);
+	}
+}
+
+bool DL_detect::snapshot() {
+	bool waiting = false;
+	for (int thd = 0; thd < V; thd++) {
+		WaitSlot * slot = &_slots[thd];
+		uint64_t seq = slot->seq;
+		if (seq == _snap_seq[thd])
+			continue;
+		do {
+			while ((seq = slot->seq) & 1)
+				PAUSE
+			COMPILER_BARRIER
+			_snap_txnid[thd] = slot->txnid;
+			_snap_num_locks[thd] = slot->num_locks;
+			_snap_edges[thd].assign(slot->waits_for, slot->waits_for + slot->cnt);
+			COMPILER_BARRIER
+		} while (slot->seq != seq);
+		_snap_seq[thd] = seq;
+		_dirty[thd] = (_snap_txnid[thd] != -1);
+		if (_dirty[thd])
+			waiting = true;
+	}
+	return waiting;
+}
+
+bool DL_detect::find_cycle(int thd, int start, vector<int> & cycle) {
+	_visited[thd] = true;
+	cycle.push_back(thd);
+	vector<uint64_t> & edges = _snap_edges[thd];
+	for (uint32_t i = 0; i < edges.size(); i++) {
+		int next = get_thdid_from_txnid(edges[i]);
+		// the edge is stale unless the target waits as the txn it names
+		if (_snap_txnid[next] != (int64_t) edges[i])
+			continue;
+		if (next == start)
+			return true;
+		if (!_visited[next] && find_cycle(next, start, cycle))
+			return true;
+	}
+	cycle.pop_back();
+	return false;
+}
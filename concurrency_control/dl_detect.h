@@ -3,6 +3,7 @@
 
 #include <limits.h>
 #include <list>
+#include <vector>
 #include <stdint.h>
 #include "pthread.h"
 #include "config.h"
@@ -18,6 +19,18 @@ struct DepThd {
 	char pad[2 * CL_SIZE - sizeof(int64_t) - sizeof(pthread_mutex_t) - sizeof(std::list<uint64_t>) - sizeof(int)];
 };
 
+// [DL_DETECT_THREAD] the edges of one waiting txn. Only the thread of the
+// txn writes its slot, bumping `seq` to odd before and to even after, and
+// the detector rereads a slot whose seq moved while it was reading.
+struct WaitSlot {
+	volatile uint64_t 	seq;
+	volatile int64_t 	txnid; // -1 while not waiting
+	volatile int 		num_locks;
+	volatile int 		cnt;
+	uint64_t * 			waits_for; // txn ids, g_thread_cnt slots
+	char pad[CL_SIZE - sizeof(uint64_t) * 3 - sizeof(int) * 2];
+};
+
 // shared data for a particular deadlock detection
 struct DetectData {
 	bool * visited;
@@ -44,7 +57,31 @@ public:
 	// remove all outbound dependencies for txnid.
 	// will wait for the lock until acquired.
 	void clear_dep(uint64_t txnid);
+	// [DL_DETECT_THREAD] spawn / join the detector thread
+	void start();
+	void stop();
 private:
+	// the detector thread. Waiters only publish their edges and spin on
+	// their own lock_ready / lock_abort, which the detector sets on a victim.
+	static void * run_detector(void * This);
+	void run();
+	// copies the slots that changed since the last round. Returns whether
+	// one of them is waiting now, i.e. may have closed a cycle.
+	bool snapshot();
+	// a cycle through `thd` in the snapshot, appended to `cycle`
+	bool find_cycle(int thd, int start, std::vector<int> & cycle);
+	WaitSlot * 		_slots;
+	// the snapshot, [thd]. An edge counts if its target still waits as the
+	// txn id it names.
+	uint64_t * 		_snap_seq;
+	int64_t * 		_snap_txnid;
+	int * 			_snap_num_locks;
+	std::vector<uint64_t> * _snap_edges;
+	bool * 			_dirty;
+	bool * 			_visited;
+	pthread_t 		_thd;
+	volatile bool 	_stop;
+
 	int V;    // No. of vertices
 	DepThd * dependency;
 	
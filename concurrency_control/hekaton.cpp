@@ -3,7 +3,6 @@
 #include "row_hekaton.h"
 #include "manager.h"
 
-#if CC_ALG==HEKATON
 
 RC
 txn_man::validate_hekaton(RC rc)
@@ -17,19 +16,23 @@ txn_man::validate_hekaton(RC rc)
 		for (int rid = 0; rid < row_cnt; rid ++) {
 			if (accesses[rid]->type == WR)
 				continue;
-			rc = accesses[rid]->orig_row->manager->prepare_read(this, accesses[rid]->data, commit_ts);
-			if (rc == Abort)
+			rc = accesses[rid]->orig_row->get_manager<HEKATON>()->prepare_read(this, (HekatonVersion *) accesses[rid]->history_entry, commit_ts);
+			if (rc == Abort) {
+				set_abort(ABORT_VALIDATE, accesses[rid]->orig_row);
 				break;
+			}
 		}
 	}
 #endif
+	// the new versions are still invisible to others
+	if (rc == RCOK)
+		on_commit(commit_ts);
 	// postprocess 
 	for (int rid = 0; rid < row_cnt; rid ++) {
 		if (accesses[rid]->type == RD)
 			continue;
-		accesses[rid]->orig_row->manager->post_process(this, commit_ts, rc);
+		accesses[rid]->orig_row->get_manager<HEKATON>()->post_process(this, commit_ts, rc);
 	}
 	return rc;
 }
 
-#endif
@@ -35,7 +35,6 @@ RC OptCC::validate(txn_man * txn) {
 RC 
 OptCC::per_row_validate(txn_man * txn) {
 	RC rc = RCOK;
-#if CC_ALG == OCC
 	// sort all rows accessed in primary key order.
 	// TODO for migration, should first sort by partition id
 	for (int i = txn->row_cnt - 1; i > 0; i--) {
@@ -63,24 +62,25 @@ OptCC::per_row_validate(txn_man * txn) {
 	int lock_cnt = 0;
 	for (int i = 0; i < txn->row_cnt && ok; i++) {
 		lock_cnt ++;
-		txn->accesses[i]->orig_row->manager->latch(); // Acquire original row's latch
-		ok = txn->accesses[i]->orig_row->manager->validate( txn->start_ts ); // Check if it has been modified since we started
+		txn->accesses[i]->orig_row->get_manager<OCC>()->latch(); // Acquire original row's latch
+		ok = txn->accesses[i]->orig_row->get_manager<OCC>()->validate( txn->start_ts ); // Check if it has been modified since we started
 	}
 	if (ok) {
 		// Validation passed.
 		// advance the global timestamp and get the end_ts
 		txn->end_ts = glob_manager->get_ts( txn->get_thd_id() );
+		txn->on_commit(txn->end_ts);
 		// write to each row and update wts
-		txn->cleanup(RCOK);
+		txn->cleanup<OCC>(RCOK);
 		rc = RCOK;
 	} else {
-		txn->cleanup(Abort);
+		txn->set_abort(ABORT_VALIDATE, txn->accesses[lock_cnt - 1]->orig_row);
+		txn->cleanup<OCC>(Abort);
 		rc = Abort;
 	}
 
 	for (int i = 0; i < lock_cnt; i++) 
-		txn->accesses[i]->orig_row->manager->release(); // Now release
-#endif
+		txn->accesses[i]->orig_row->get_manager<OCC>()->release(); // Now release
 	return rc;
 }
 
@@ -91,6 +91,7 @@ RC OptCC::central_validate(txn_man * txn) {
 	set_ent ** finish_active;
 	uint64_t f_active_len;
 	bool valid = true;
+	row_t * conflict = NULL;
 	// OptCC is centralized. No need to do per partition malloc.
 	set_ent * wset;
 	set_ent * rset;
@@ -119,7 +120,7 @@ RC OptCC::central_validate(txn_man * txn) {
 		while (his && his->tn > finish_tn) 
 			his = his->next;
 		while (his && his->tn > start_tn) {
-			valid = test_valid(his, rset);
+			valid = test_valid(his, rset, conflict);
 			if (!valid) 
 				goto final;
 			his = his->next;
@@ -128,15 +129,18 @@ RC OptCC::central_validate(txn_man * txn) {
 
 	for (UInt32 i = 0; i < f_active_len; i++) {
 		set_ent * wact = finish_active[i];
-		valid = test_valid(wact, rset);
+		valid = test_valid(wact, rset, conflict);
 		if (valid) {
-			valid = test_valid(wact, wset);
+			valid = test_valid(wact, wset, conflict);
 		} if (!valid)
 			goto final;
 	}
 final:
-	if (valid) 
-		txn->cleanup(RCOK);
+	if (valid) {
+		// no active txn overlaps our write set
+		txn->on_commit(get_sys_clock());
+		txn->cleanup<OCC>(RCOK);
+	}
 	mem_allocator.free(rset, sizeof(set_ent));
 
 	if (!readonly) {
@@ -167,7 +171,8 @@ final:
 	if (valid) {
 		rc = RCOK;
 	} else {
-		txn->cleanup(Abort);
+		txn->set_abort(ABORT_VALIDATE, conflict);
+		txn->cleanup<OCC>(Abort);
 		rc = Abort;
 	}
 	return rc;
@@ -196,10 +201,11 @@ RC OptCC::get_rw_set(txn_man * txn, set_ent * &rset, set_ent *& wset) {
 	return RCOK;
 }
 
-bool OptCC::test_valid(set_ent * set1, set_ent * set2) {
+bool OptCC::test_valid(set_ent * set1, set_ent * set2, row_t *& conflict) {
 	for (UInt32 i = 0; i < set1->set_size; i++)
 		for (UInt32 j = 0; j < set2->set_size; j++) {
 			if (set1->rows[i] == set2->rows[j]) {
+				conflict = set1->rows[i];
 				return false;
 			}
 		}
@@ -34,7 +34,8 @@ private:
 
 	// parallel validation in the original OCC paper.
 	RC central_validate(txn_man * txn);
-	bool test_valid(set_ent * set1, set_ent * set2);
+	// false if the sets share a row, which is returned in `conflict`
+	bool test_valid(set_ent * set1, set_ent * set2, row_t *& conflict);
 	RC get_rw_set(txn_man * txni, set_ent * &rset, set_ent *& wset);
 	
 	// "history" stores write set of transactions with tn >= smallest running tn
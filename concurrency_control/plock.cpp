@@ -94,6 +94,7 @@ RC Plock::lock(txn_man * txn, uint64_t * parts, uint64_t part_cnt) {
 			break;
 	}
 	if (rc == Abort) {
+		txn->set_abort(ABORT_CONFLICT, NULL);
 		for (UInt32 j = 0; j < i; j++) {
 			uint64_t part_id = parts[j];
 			part_mans[part_id]->unlock(txn);
@@ -5,18 +5,20 @@ class table_t;
 class Catalog;
 class txn_man;
 
-// Only a constant number of versions can be maintained.
+// Versions form a list from the newest to the oldest. Versions that ended
+// before every running txn started are cut off and handed to epoch_gc.
 // If a request accesses an old version that has been recycled,   
 // simply abort the request.
 
-#if CC_ALG == HEKATON
+#include "epoch_gc.h"
 
-struct WriteHisEntry {
+struct HekatonVersion : gc_node {
 	bool begin_txn;	
 	bool end_txn;
 	ts_t begin;
 	ts_t end;
 	row_t * row;
+	HekatonVersion * prev; // the next older version
 };
 
 #define INF UINT64_MAX
@@ -25,20 +27,24 @@ class Row_hekaton {
 public:
 	void 			init(row_t * row);
 	RC 				access(txn_man * txn, TsType type, row_t * row);
-	RC 				prepare_read(txn_man * txn, row_t * row, ts_t commit_ts);
+	// the version committed before `ts`, read without the latch. Every txn
+	// that started below `ts` must be done. NULL if it has been recycled.
+	row_t * 		read_snapshot(ts_t ts);
+	RC 				prepare_read(txn_man * txn, HekatonVersion * entry, ts_t commit_ts);
 	void 			post_process(txn_man * txn, ts_t commit_ts, RC rc);
 
 private:
 	volatile bool 	blatch;
-	uint32_t 		reserveRow(txn_man * txn);
-	void 			doubleHistory();
-
-	uint32_t 		_his_latest;
-	uint32_t 		_his_oldest;
-	WriteHisEntry * _write_history; // circular buffer
-	bool  			_exists_prewrite;
-	
-	uint32_t 		_his_len;
+	HekatonVersion * reserveRow(txn_man * txn);
+	// Cut off the versions that ended before every running txn started
+	void 			collect(txn_man * txn);
+	static void 	free_version(gc_node * node);
+
+	row_t * 		_row;
+	HekatonVersion * volatile _latest; // newest committed version
+	HekatonVersion * _oldest; // oldest version still in the list
+	HekatonVersion * _prewrite; // uncommitted version, not in the list yet
+	// The table's own row is the initial version. It is never freed.
+	HekatonVersion 	_first;
 };
 
-#endif
@@ -6,81 +6,91 @@
 
 void Row_lock::init(row_t * row) {
 	_row = row;
+	_lock = 0;
 	owners = NULL;
 	waiters_head = NULL;
 	waiters_tail = NULL;
-	owner_cnt = 0;
-	waiter_cnt = 0;
-
-	latch = new pthread_mutex_t;
-	pthread_mutex_init(latch, NULL);
-	
-	lock_type = LOCK_NONE;
-	blatch = false;
-
-}
-
-RC Row_lock::lock_get(lock_t type, txn_man * txn) {
-	uint64_t *txnids = NULL;
-	int txncnt = 0;
-	return lock_get(type, txn, txnids, txncnt);
 }
 
+template<int ALG>
 RC Row_lock::lock_get(lock_t type, txn_man * txn, uint64_t* &txnids, int &txncnt) {
-	assert (CC_ALG == DL_DETECT || CC_ALG == NO_WAIT || CC_ALG == WAIT_DIE);
 	RC rc;
-	int part_id =_row->get_part_id();
 	if (g_central_man)
 		glob_manager->lock_row(_row);
-	else 
-		pthread_mutex_lock( latch );
-	assert(owner_cnt <= g_thread_cnt);
-	assert(waiter_cnt < g_thread_cnt);
+	if constexpr (ALG == NO_WAIT) {
+		while (true) {
+			uint64_t v = _lock;
+			uint64_t cnt = v & LOCK_CNT_MASK;
+			if (cnt > 0 && ((v & LOCK_EX_BIT) || type == LOCK_EX)) {
+				rc = Abort;
+				break;
+			}
+			uint64_t newv = (cnt + 1) | (type == LOCK_EX ? LOCK_EX_BIT : 0);
+			if (ATOM_CAS(_lock, v, newv)) {
+				rc = RCOK;
+				break;
+			}
+			PAUSE
+		}
+	} else {
+		uint64_t newv = 1 | (((uint64_t)txn->get_thd_id() + 1) << LOCK_OWNER_SHIFT);
+		if (type == LOCK_EX)
+			newv |= LOCK_EX_BIT;
+		if (_lock == 0 && ATOM_CAS(_lock, 0, newv))
+			rc = RCOK;
+		else 
+			rc = lock_get_slow(type, txn, txnids, txncnt);
+	}
+	if (g_central_man)
+		glob_manager->release_row(_row);
+	return rc;
+}
+
+RC Row_lock::lock_get_slow(lock_t type, txn_man * txn, uint64_t* &txnids, int &txncnt) {
+	RC rc;
+	int part_id =_row->get_part_id();
+	uint64_t v = latch();
+	uint64_t cnt = v & LOCK_CNT_MASK;
+	uint64_t owner = (v & LOCK_OWNER_MASK) >> LOCK_OWNER_SHIFT;
+	lock_t lock_type = LOCK_NONE;
+	if (cnt > 0)
+		lock_type = (v & LOCK_EX_BIT)? LOCK_EX : LOCK_SH;
+	txn_man * owner_txn = owner? glob_manager->get_txn_man(owner - 1) : NULL;
+	assert(cnt <= g_thread_cnt);
 #if DEBUG_ASSERT
-	if (owners != NULL)
-		assert(lock_type == owners->type); 
-	else 
-		assert(lock_type == LOCK_NONE);
 	LockEntry * en = owners;
-	UInt32 cnt = 0;
+	UInt32 owner_cnt = owner? 1 : 0;
+	if (owner)
+		assert(owner - 1 != txn->get_thd_id());
 	while (en) {
 		assert(en->txn->get_thd_id() != txn->get_thd_id());
-		cnt ++;
-		en = en->next;
-	}
-	assert(cnt == owner_cnt);
-	en = waiters_head;
-	cnt = 0;
-	while (en) {
-		cnt ++;
+		assert(en->type == lock_type);
+		owner_cnt ++;
 		en = en->next;
 	}
-	assert(cnt == waiter_cnt);
+	assert(owner_cnt == cnt);
+	assert((waiters_head != NULL) == ((v & LOCK_WAITER_BIT) != 0));
 #endif
 
 	bool conflict = conflict_lock(lock_type, type);
-	if (CC_ALG == WAIT_DIE && !conflict) {
+	if (g_cc_alg == WAIT_DIE && !conflict) {
 		if (waiters_head && txn->get_ts() < waiters_head->txn->get_ts())
 			conflict = true;
 	}
 	// Some txns coming earlier is waiting. Should also wait.
-	if (CC_ALG == DL_DETECT && waiters_head != NULL)
+	if (g_cc_alg == DL_DETECT && waiters_head != NULL)
 		conflict = true;
 	
 	if (conflict) { 
 		// Cannot be added to the owner list.
-		if (CC_ALG == NO_WAIT) {
-			rc = Abort;
-			goto final;
-		} else if (CC_ALG == DL_DETECT) {
+		if (g_cc_alg == DL_DETECT) {
 			LockEntry * entry = get_entry();
 			entry->txn = txn;
 			entry->type = type;
 			LIST_PUT_TAIL(waiters_head, waiters_tail, entry);
-			waiter_cnt ++;
             txn->lock_ready = false;
             rc = WAIT;
-		} else if (CC_ALG == WAIT_DIE) {
+		} else if (g_cc_alg == WAIT_DIE) {
             ///////////////////////////////////////////////////////////
             //  - T is the txn currently running
 			//	IF T.ts < ts of all owners
@@ -89,9 +99,9 @@ RC Row_lock::lock_get(lock_t type, txn_man * txn, uint64_t* &txnids, int &txncnt
             //      T should abort
             //////////////////////////////////////////////////////////
 
-			bool canwait = true;
+			bool canwait = (owner_txn == NULL || txn->get_ts() < owner_txn->get_ts());
 			LockEntry * en = owners;
-			while (en != NULL) {
+			while (canwait && en != NULL) {
                 if (en->txn->get_ts() < txn->get_ts()) {
 					canwait = false;
 					break;
@@ -113,30 +123,34 @@ RC Row_lock::lock_get(lock_t type, txn_man * txn, uint64_t* &txnids, int &txncnt
 						waiters_head = entry;
 				} else 
 					LIST_PUT_TAIL(waiters_head, waiters_tail, entry);
-				waiter_cnt ++;
                 txn->lock_ready = false;
                 rc = WAIT;
             }
             else 
                 rc = Abort;
-        }
+        } else 
+			rc = Abort;
 	} else {
-		LockEntry * entry = get_entry();
-		entry->type = type;
-		entry->txn = txn;
-		STACK_PUSH(owners, entry);
-		owner_cnt ++;
+		if (owner == 0) {
+			owner = txn->get_thd_id() + 1;
+			cnt ++;
+		} else {
+			LockEntry * entry = get_entry();
+			entry->type = type;
+			entry->txn = txn;
+			add_owner(entry, owner, cnt);
+		}
 		lock_type = type;
-		if (CC_ALG == DL_DETECT) 
+		if (g_cc_alg == DL_DETECT) 
 			ASSERT(waiters_head == NULL);
         rc = RCOK;
 	}
-final:
 	
-	if (rc == WAIT && CC_ALG == DL_DETECT) {
+	if (rc == WAIT && g_cc_alg == DL_DETECT) {
 		// Update the waits-for graph
 		ASSERT(waiters_tail->txn == txn);
-		txnids = (uint64_t *) mem_allocator.alloc(sizeof(uint64_t) * (owner_cnt + waiter_cnt), part_id);
+		// every thread owns or waits for the row at most once
+		txnids = (uint64_t *) mem_allocator.alloc(sizeof(uint64_t) * g_thread_cnt, part_id);
 		txncnt = 0;
 		LockEntry * en = waiters_tail->prev;
 		while (en != NULL) {
@@ -144,65 +158,93 @@ final:
 				txnids[txncnt++] = en->txn->get_txn_id();
 			en = en->prev;
 		}
-		en = owners;
-		if (conflict_lock(type, lock_type)) 
+		if (conflict_lock(type, lock_type)) {
+			if (owner_txn)
+				txnids[txncnt++] = owner_txn->get_txn_id();
+			en = owners;
 			while (en != NULL) {
 				txnids[txncnt++] = en->txn->get_txn_id();
 				en = en->next;
 			}
+		}
 		ASSERT(txncnt > 0);
 	}
 
-	if (g_central_man)
-		glob_manager->release_row(_row);
-	else
-		pthread_mutex_unlock( latch );
-
+	unlatch(owner, cnt, lock_type);
 	return rc;
 }
 
-
+template<int ALG>
 RC Row_lock::lock_release(txn_man * txn) {	
-
 	if (g_central_man)
 		glob_manager->lock_row(_row);
-	else 
-		pthread_mutex_lock( latch );
+	if constexpr (ALG == NO_WAIT) {
+		while (true) {
+			uint64_t v = _lock;
+			assert(v & LOCK_CNT_MASK);
+			uint64_t newv = ((v & LOCK_CNT_MASK) == 1)? 0 : v - 1;
+			if (ATOM_CAS(_lock, v, newv))
+				break;
+			PAUSE
+		}
+	} else {
+		// the only owner, kept in the word, and nobody waits
+		uint64_t v = _lock;
+		uint64_t mine = 1 | (((uint64_t)txn->get_thd_id() + 1) << LOCK_OWNER_SHIFT);
+		if ((v & ~LOCK_EX_BIT) != mine || !ATOM_CAS(_lock, v, 0))
+			lock_release_slow(txn);
+	}
+	if (g_central_man)
+		glob_manager->release_row(_row);
+	return RCOK;
+}
 
-	// Try to find the entry in the owners
-	LockEntry * en = owners;
-	LockEntry * prev = NULL;
+#define LOCK_ACCESS(alg) \
+	template RC Row_lock::lock_get<alg>(lock_t, txn_man *, uint64_t* &, int &); \
+	template RC Row_lock::lock_release<alg>(txn_man *);
+LOCK_ACCESS(NO_WAIT) LOCK_ACCESS(WAIT_DIE) LOCK_ACCESS(DL_DETECT)
 
-	while (en != NULL && en->txn != txn) {
-		prev = en;
-		en = en->next;
-	}
-	if (en) { // find the entry in the owner list
-		if (prev) prev->next = en->next;
-		else owners = en->next;
-		return_entry(en);
-		owner_cnt --;
-		if (owner_cnt == 0)
-			lock_type = LOCK_NONE;
+void Row_lock::lock_release_slow(txn_man * txn) {
+	uint64_t v = latch();
+	uint64_t cnt = v & LOCK_CNT_MASK;
+	uint64_t owner = (v & LOCK_OWNER_MASK) >> LOCK_OWNER_SHIFT;
+	lock_t lock_type = (v & LOCK_EX_BIT)? LOCK_EX : LOCK_SH;
+
+	if (owner == txn->get_thd_id() + 1) {
+		owner = 0;
+		cnt --;
 	} else {
-		// Not in owners list, try waiters list.
-		en = waiters_head;
-		while (en != NULL && en->txn != txn)
+		// Try to find the entry in the owners
+		LockEntry * en = owners;
+		LockEntry * prev = NULL;
+		while (en != NULL && en->txn != txn) {
+			prev = en;
 			en = en->next;
-		ASSERT(en);
-		LIST_REMOVE(en);
-		if (en == waiters_head)
-			waiters_head = en->next;
-		if (en == waiters_tail)
-			waiters_tail = en->prev;
-		return_entry(en);
-		waiter_cnt --;
+		}
+		if (en) { // find the entry in the owner list
+			if (prev) prev->next = en->next;
+			else owners = en->next;
+			return_entry(en);
+			cnt --;
+		} else {
+			// Not in owners list, try waiters list.
+			en = waiters_head;
+			while (en != NULL && en->txn != txn)
+				en = en->next;
+			ASSERT(en);
+			LIST_REMOVE(en);
+			if (en == waiters_head)
+				waiters_head = en->next;
+			if (en == waiters_tail)
+				waiters_tail = en->prev;
+			return_entry(en);
+		}
 	}
-
-	if (owner_cnt == 0)
-		ASSERT(lock_type == LOCK_NONE);
-#if DEBUG_ASSERT && CC_ALG == WAIT_DIE 
-		for (en = waiters_head; en != NULL && en->next != NULL; en = en->next)
+	if (cnt == 0)
+		lock_type = LOCK_NONE;
+#if DEBUG_ASSERT
+	if (g_cc_alg == WAIT_DIE)
+		for (LockEntry * en = waiters_head; en != NULL && en->next != NULL; en = en->next)
 			assert(en->next->txn->get_ts() < en->txn->get_ts());
 #endif
 
@@ -210,21 +252,46 @@ RC Row_lock::lock_release(txn_man * txn) {
 	// If any waiter can join the owners, just do it!
 	while (waiters_head && !conflict_lock(lock_type, waiters_head->type)) {
 		LIST_GET_HEAD(waiters_head, waiters_tail, entry);
-		STACK_PUSH(owners, entry);
-		owner_cnt ++;
-		waiter_cnt --;
-		ASSERT(entry->txn->lock_ready == false);
-		entry->txn->lock_ready = true;
+		txn_man * waiter = entry->txn;
 		lock_type = entry->type;
+		add_owner(entry, owner, cnt);
+		ASSERT(waiter->lock_ready == false);
+		waiter->lock_ready = true;
 	} 
-	ASSERT((owners == NULL) == (owner_cnt == 0));
+	unlatch(owner, cnt, lock_type);
+}
 
-	if (g_central_man)
-		glob_manager->release_row(_row);
-	else
-		pthread_mutex_unlock( latch );
+uint64_t Row_lock::latch() {
+	while (true) {
+		uint64_t v = _lock;
+		if (!(v & LOCK_LATCH_BIT) && ATOM_CAS(_lock, v, v | LOCK_LATCH_BIT))
+			return v;
+		PAUSE
+	}
+}
 
-	return RCOK;
+void Row_lock::unlatch(uint64_t owner, uint64_t cnt, lock_t type) {
+	ASSERT((owners == NULL) || cnt > 0);
+	uint64_t v = cnt | (owner << LOCK_OWNER_SHIFT);
+	if (cnt > 0 && type == LOCK_EX)
+		v |= LOCK_EX_BIT;
+	if (owners)
+		v |= LOCK_LIST_BIT;
+	if (waiters_head)
+		v |= LOCK_WAITER_BIT;
+	// the latch bit is set, so no CAS on the word can succeed meanwhile
+	COMPILER_BARRIER
+	_lock = v;
+}
+
+// the word keeps one owner, the others go to the list
+void Row_lock::add_owner(LockEntry * entry, uint64_t &owner, uint64_t &cnt) {
+	if (owner == 0) {
+		owner = entry->txn->get_thd_id() + 1;
+		return_entry(entry);
+	} else 
+		STACK_PUSH(owners, entry);
+	cnt ++;
 }
 
 bool Row_lock::conflict_lock(lock_t l1, lock_t l2) {
@@ -244,4 +311,3 @@ LockEntry * Row_lock::get_entry() {
 void Row_lock::return_entry(LockEntry * entry) {
 	mem_allocator.free(entry, sizeof(LockEntry));
 }
-
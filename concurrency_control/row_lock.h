@@ -8,27 +8,51 @@ struct LockEntry {
 	LockEntry * prev;
 };
 
+// The lock of a row is one 64-bit word:
+//   [0, 24)   number of owners
+//   [24, 48)  thread id + 1 of the owner kept in the word, 0 if none
+//   LOCK_EX_BIT      the owners hold the lock exclusively
+//   LOCK_LIST_BIT    the owners list is not empty
+//   LOCK_WAITER_BIT  the waiters list is not empty
+//   LOCK_LATCH_BIT   a thread is updating the lists
+// A free lock is taken by its first owner and released again with one CAS.
+// Only a second owner or a waiter takes the latch and goes to the lists.
+// [NO_WAIT] owners are only counted, so the lists and the latch are never
+// used.
+#define LOCK_CNT_MASK		((1UL << 24) - 1)
+#define LOCK_OWNER_SHIFT	24
+#define LOCK_OWNER_MASK		(((1UL << 24) - 1) << LOCK_OWNER_SHIFT)
+#define LOCK_EX_BIT			(1UL << 60)
+#define LOCK_LIST_BIT		(1UL << 61)
+#define LOCK_WAITER_BIT		(1UL << 62)
+#define LOCK_LATCH_BIT		(1UL << 63)
+
 class Row_lock {
 public:
 	void init(row_t * row);
 	// [DL_DETECT] txnids are the txn_ids that current txn is waiting for.
-    RC lock_get(lock_t type, txn_man * txn);
+	// ALG is NO_WAIT, WAIT_DIE or DL_DETECT
+	template<int ALG>
     RC lock_get(lock_t type, txn_man * txn, uint64_t* &txnids, int &txncnt);
+	template<int ALG>
     RC lock_release(txn_man * txn);
 	
 private:
-    pthread_mutex_t * latch;
-	bool blatch;
+	RC			lock_get_slow(lock_t type, txn_man * txn, uint64_t* &txnids, int &txncnt);
+	void		lock_release_slow(txn_man * txn);
+	// returns the word with the latch bit set
+	uint64_t	latch();
+	// stores the fields back into the word and drops the latch
+	void		unlatch(uint64_t owner, uint64_t cnt, lock_t type);
+	void 		add_owner(LockEntry * entry, uint64_t &owner, uint64_t &cnt);
 	
 	bool 		conflict_lock(lock_t l1, lock_t l2);
 	LockEntry * get_entry();
 	void 		return_entry(LockEntry * entry);
 	row_t * _row;
-    lock_t lock_type;
-    UInt32 owner_cnt;
-    UInt32 waiter_cnt;
+	volatile uint64_t _lock;
 	
-	// owners is a single linked list
+	// owners other than the one in the word; a single linked list
 	// waiters is a double linked list 
 	// [waiters] head is the oldest txn, tail is the youngest txn. 
 	//   So new txns are inserted into the tail.
@@ -4,34 +4,29 @@
 #include "manager.h"
 #include "row_mvcc.h"
 #include "mem_alloc.h"
+#include "epoch_gc.h"
 #include <mm_malloc.h>
 
-#if CC_ALG == MVCC
 
 void Row_mvcc::init(row_t * row) {
 	_row = row;
-	_his_len = 4;
-	_req_len = _his_len;
-
-	_write_history = (WriteHisEntry *) _mm_malloc(sizeof(WriteHisEntry) * _his_len, 64);
-	_requests = (ReqEntry *) _mm_malloc(sizeof(ReqEntry) * _req_len, 64);
-	for (uint32_t i = 0; i < _his_len; i++) {
+	_req_len = MVCC_REQ_INLINE;
+	_requests = _req_inline;
+	for (uint32_t i = 0; i < _req_len; i++)
 		_requests[i].valid = false;
-		_write_history[i].valid = false;
-		_write_history[i].reserved = false;
-		_write_history[i].row = NULL;
-	}
+	_first.ts = 0;
+	_first.row = _row;
+	_first.prev = NULL;
+	_latest = &_first;
 	_latest_row = _row;
 	_latest_wts = 0;
 	_oldest_wts = 0;
 
-	_num_versions = 0;
 	_exists_prewrite = false;
+	_prewrite_row = NULL;
 	_max_served_rts = 0;
 	
 	blatch = false;
-	latch = (pthread_mutex_t *) _mm_malloc(sizeof(pthread_mutex_t), 64);
-	pthread_mutex_init(latch, NULL);
 }
 
 void Row_mvcc::buffer_req(TsType type, txn_man * txn, bool served)
@@ -52,47 +47,29 @@ void Row_mvcc::buffer_req(TsType type, txn_man * txn, bool served)
 			}
 		}
 		assert(access_num == 1); // Should succeed when we do one enlarging
-		double_list(1); // Enlarge the req list until we can tolerate
+		double_list(); // Enlarge the req list until we can tolerate
 		access_num ++;
 	}
 }
 
 
 void 
-Row_mvcc::double_list(uint32_t list)
+Row_mvcc::double_list()
 {
-	if (list == 0) {
-		WriteHisEntry * temp = (WriteHisEntry *) _mm_malloc(sizeof(WriteHisEntry) * _his_len * 2, 64);
-		for (uint32_t i = 0; i < _his_len; i++) {
-			temp[i].valid = _write_history[i].valid;
-			temp[i].reserved = _write_history[i].reserved;
-			temp[i].ts = _write_history[i].ts;
-			temp[i].row = _write_history[i].row;
-		}
-		for (uint32_t i = _his_len; i < _his_len * 2; i++) {
-			temp[i].valid = false;
-			temp[i].reserved = false;
-			temp[i].row = NULL;
-		}
-		_mm_free(_write_history);
-		_write_history = temp;
-		_his_len = _his_len * 2;
-	} else {
-		assert(list == 1);
-		ReqEntry * temp = (ReqEntry *) _mm_malloc(sizeof(ReqEntry) * _req_len * 2, 64);
-		for (uint32_t i = 0; i < _req_len; i++) {
-			temp[i].valid = _requests[i].valid;
-			temp[i].type = _requests[i].type;
-			temp[i].ts = _requests[i].ts;
-			temp[i].txn = _requests[i].txn;
-			temp[i].time = _requests[i].time;
-		}
-		for (uint32_t i = _req_len; i < _req_len * 2; i++) 
-			temp[i].valid = false;
-		_mm_free(_requests);
-		_requests = temp;
-		_req_len = _req_len * 2;
+	ReqEntry * temp = (ReqEntry *) _mm_malloc(sizeof(ReqEntry) * _req_len * 2, 64);
+	for (uint32_t i = 0; i < _req_len; i++) {
+		temp[i].valid = _requests[i].valid;
+		temp[i].type = _requests[i].type;
+		temp[i].ts = _requests[i].ts;
+		temp[i].txn = _requests[i].txn;
+		temp[i].time = _requests[i].time;
 	}
+	for (uint32_t i = _req_len; i < _req_len * 2; i++) 
+		temp[i].valid = false;
+	if (_requests != _req_inline)
+		_mm_free(_requests);
+	_requests = temp;
+	_req_len = _req_len * 2;
 }
 
 RC Row_mvcc::access(txn_man * txn, TsType type, row_t * row) {
@@ -104,7 +81,6 @@ uint64_t t1 = get_sys_clock();
 	else // Default
 		while (!ATOM_CAS(blatch, false, true))
 			PAUSE // Add some delay
-		//pthread_mutex_lock( latch );
 uint64_t t2 = get_sys_clock();
 INC_STATS(txn->get_thd_id(), debug4, t2 - t1);
 // Critical section start
@@ -117,10 +93,11 @@ INC_STATS(txn->get_thd_id(), debug4, t2 - t1);
 		}
 #endif
 	if (type == R_REQ) { // Reader's access try
-		if (ts < _oldest_wts) // There's no version I can see: compare with the first version in chain
+		if (ts < _oldest_wts) { // There's no version I can see: compare with the first version in chain
 			// the version was already recycled... This should be very rare
+			txn->set_abort(ABORT_VERSION, _row);
 			rc = Abort;
-		else if (ts > _latest_wts) { // I'm one of the first to see this latest version
+		} else if (ts > _latest_wts) { // I'm one of the first to see this latest version
 			if (_exists_prewrite && _prewrite_ts < ts) // But there's a prewriter before me
 			{
 				// exists a pending prewrite request before the current read. should wait.
@@ -137,21 +114,15 @@ INC_STATS(txn->get_thd_id(), debug4, t2 - t1);
 		} else { // There's someone wrote this record, read some past versions I can see
 			rc = RCOK;
 			// ts is between _oldest_wts and _latest_wts, should find the correct version
-			uint32_t the_ts = 0; // Last ts I checked
-		   	uint32_t the_i = _his_len;
-	   		for (uint32_t i = 0; i < _his_len; i++) { // Find a version I can see
-		   		if (_write_history[i].valid 
-					&& _write_history[i].ts < ts 
-			   		&& _write_history[i].ts > the_ts) 
-	   			{
-		   			the_ts = _write_history[i].ts;
-			  		the_i = i; // Won't break, we will keep the newest among them (maybe just only one)
-				}
-			}
-			if (the_i == _his_len) // There's no one in history I can see
-				txn->cur_row = _row;
-   			else 
-	   			txn->cur_row = _write_history[the_i].row;
+			// The list is sorted by ts, the first one older than me is the one I can see
+			WriteHisEntry * v = _latest;
+			while (v != NULL && v->ts >= ts)
+				v = v->prev;
+			if (v == NULL) { // Cut off by a concurrent collect()
+				txn->set_abort(ABORT_VERSION, _row);
+				rc = Abort;
+			} else
+				txn->cur_row = v->row;
 		}
 	} else if (type == P_REQ) { // Writer's read phase
 		if (ts < _latest_wts || ts < _max_served_rts || (_exists_prewrite && _prewrite_ts > ts))
@@ -173,19 +144,27 @@ INC_STATS(txn->get_thd_id(), debug4, t2 - t1);
 	} else if (type == W_REQ) { // Writer's commit phase
 		rc = RCOK; // Entering this means we must be the first committer
 		assert(ts > _latest_wts);
-		assert(row == _write_history[_prewrite_his_id].row);
-		_write_history[_prewrite_his_id].valid = true;
-		_write_history[_prewrite_his_id].ts = ts;
+		assert(row == _prewrite_row);
+		WriteHisEntry * entry = (WriteHisEntry *) mem_allocator.alloc(sizeof(WriteHisEntry), _row->get_part_id());
+		entry->ts = ts;
+		entry->row = row;
+		entry->prev = _latest;
+		// snapshot readers follow _latest without the latch
+		COMPILER_BARRIER
+		_latest = entry;
 		_latest_wts = ts;
 		_latest_row = row;
 		_exists_prewrite = false;
-		_num_versions ++;
+		_prewrite_row = NULL;
 		update_buffer(txn, W_REQ);
-	} else if (type == XP_REQ) { // Aborted writer release his resources (reserved slots)
-		assert(row == _write_history[_prewrite_his_id].row);
-		_write_history[_prewrite_his_id].valid = false;
-		_write_history[_prewrite_his_id].reserved = false;
+		collect(txn);
+	} else if (type == XP_REQ) { // Aborted writer release his resources (the unpublished row)
+		assert(row == _prewrite_row);
+		// Nobody else has seen this row, so it can go right away
+		row->free_row();
+		mem_allocator.free(row, sizeof(row_t));
 		_exists_prewrite = false;
+		_prewrite_row = NULL;
 		update_buffer(txn, XP_REQ);
 	} else 
 		assert(false);
@@ -194,130 +173,69 @@ INC_STATS(txn->get_thd_id(), debug3, get_sys_clock() - t2);
 		glob_manager->release_row(_row);
 	else
 		blatch = false; // Note that even if we release the lock, this version can belong to us
-		//pthread_mutex_unlock( latch );	
 // Critical section end	
 	return rc;
 }
 
+row_t * 
+Row_mvcc::read_snapshot(ts_t ts)
+{
+	// collect() keeps the newest version below the oldest snapshot, so the
+	// walk stops before it can fall off a cut list
+	WriteHisEntry * v = _latest;
+	while (v != NULL && v->ts >= ts)
+		v = v->prev;
+	return v == NULL? NULL : v->row;
+}
+
 row_t *
 Row_mvcc::reserveRow(ts_t ts, txn_man * txn)
 {
 	assert(!_exists_prewrite); // We can only serve one prewriter
-	
+	row_t * row = (row_t *) mem_allocator.alloc(sizeof(row_t), _row->get_part_id());
+	row->init(MAX_TUPLE_SIZE);
+	_exists_prewrite = true;
+	_prewrite_row = row;
+	_prewrite_ts = ts;
+	return row;
+}
+
+void 
+Row_mvcc::collect(txn_man * txn)
+{
 	// Garbage Collection
 	ts_t min_ts = glob_manager->get_min_ts(txn->get_thd_id());
-	if (_oldest_wts < min_ts && 
-		_num_versions == _his_len) // Slots full and there's some (clearly) outdated versions
-	{
-		ts_t max_recycle_ts = 0; // Max ts of all recyclable versions
-		ts_t idx = _his_len; // Index of last recyclable versions
-		for (uint32_t i = 0; i < _his_len; i++) { // Maybe this loop will always succeed?
-			if (_write_history[i].valid
-				&& _write_history[i].ts < min_ts
-				&& _write_history[i].ts > max_recycle_ts)		
-			{
-				max_recycle_ts = _write_history[i].ts;
-				idx = i;
-			}
-		}
-		// some entries can be garbage collected.
-		if (idx != _his_len) {
-			row_t * temp = _row;
-			_row = _write_history[idx].row;
-			_write_history[idx].row = temp; // Current version exchange with that slot
-			_oldest_wts = max_recycle_ts;
-			for (uint32_t i = 0; i < _his_len; i++) { // Clear those recyclable versions
-				if (_write_history[i].valid
-					&& _write_history[i].ts <= max_recycle_ts)
-				{
-					_write_history[i].valid = false;
-					_write_history[i].reserved = false;
-					assert(_write_history[i].row);
-					_num_versions --;
-				}
-			}
-		}
+	if (_oldest_wts >= min_ts)
+		return;
+	// Every running txn can see `keep` or a newer version, the older ones are unreachable
+	WriteHisEntry * keep = _latest;
+	while (keep != NULL && keep->ts >= min_ts)
+		keep = keep->prev;
+	if (keep == NULL || keep->prev == NULL)
+		return;
+	WriteHisEntry * v = keep->prev;
+	keep->prev = NULL;
+	_oldest_wts = keep->ts;
+	// A txn that read an old version before the cut may still hold its row,
+	// so the versions are freed only after the epoch has passed
+	while (v != NULL) {
+		WriteHisEntry * prev = v->prev;
+		// the initial version lives in the manager with the table's row
+		if (v != &_first)
+			epoch_gc.retire(txn->get_thd_id(), v, free_version);
+		v = prev;
 	}
-	
-#if DEBUG_CC
-	uint32_t his_size = 0;
-	uint64_t max_ts = 0;
-	for (uint32_t i = 0; i < _his_len; i++) 
-		if (_write_history[i].valid) {
-			his_size ++;
-			if (_write_history[i].ts > max_ts)
-				max_ts = _write_history[i].ts;
-		}
-	assert(his_size == _num_versions);
-	if (_num_versions > 0)
-		assert(max_ts == _latest_wts);
-#endif
-	uint32_t idx = _his_len;
-	// _write_history is not full, find an unused entry for P_REQ.
-	if (_num_versions < _his_len) {
-		for (uint32_t i = 0; i < _his_len; i++) {
-			if (!_write_history[i].valid 
-				&& !_write_history[i].reserved 
-				&& _write_history[i].row != NULL) 
-			{
-				idx = i;
-				break;
-			}
-			else if (!_write_history[i].valid 
-				 	 && !_write_history[i].reserved)
-				idx = i;
-		}
-		assert(idx < _his_len);
-	}
-	row_t * row;
-	if (idx == _his_len) { // Not found, (maybe) used by currently running txn
-		if (_his_len >= g_thread_cnt) {
-			// all entries are taken. recycle the oldest version if _his_len is too long already
-			ts_t min_ts = UINT64_MAX; 
-			for (uint32_t i = 0; i < _his_len; i++) { // Find the one with minimum ts among all (valid) entries
-				if (_write_history[i].valid && _write_history[i].ts < min_ts) {
-					min_ts = _write_history[i].ts;
-					idx = i;
-				}
-			}
-			// Why? Try deleting? Since that estimated lower bound is not accurate?
-			// One case is: txn with `min_ts` hasn't died and its version has not been recycled (_oldest_wts=min_ts) in the first loop
-			// This case can be cleared and recycled here
-			assert(min_ts > _oldest_wts);
-			assert(_write_history[idx].row);
-			// OK, suppose we can always find one slot, now make it empty
-			// What if a txn writes a row multiple times?
-			// Note that we only accept one prewriter
-			row = _row;
-			_row = _write_history[idx].row;
-			_write_history[idx].row = row; // Exchange with the current active version
-			_oldest_wts = min_ts;
-			_num_versions --;
-		} else {
-			// double the history size. 
-			double_list(0);
-			_prewrite_ts = ts; // Not necessary since we will do this later
-#if DEBUG_CC
-			for (uint32_t i = 0; i < _his_len / 2; i++)
-				assert(_write_history[i].valid);
-			assert(!_write_history[_his_len / 2].valid);
-#endif
-			idx = _his_len / 2;
-		}
-	} 
-	assert(idx != _his_len);
-	// some entries are not taken. But the row of that entry is NULL.
-	if (!_write_history[idx].row) { // Those initially empty ones contain an NULL row (and those allocated when enlarging)
-		_write_history[idx].row = (row_t *) _mm_malloc(sizeof(row_t), 64);
-		_write_history[idx].row->init(MAX_TUPLE_SIZE); // Alloc this when necessary
+}
+
+void 
+Row_mvcc::free_version(gc_node * node)
+{
+	WriteHisEntry * entry = (WriteHisEntry *) node;
+	if (entry->row != NULL) {
+		entry->row->free_row();
+		mem_allocator.free(entry->row, sizeof(row_t));
 	}
-	_write_history[idx].valid = false;
-	_write_history[idx].reserved = true;
-	_write_history[idx].ts = ts;
-	_exists_prewrite = true;
-	_prewrite_his_id = idx;
-	_prewrite_ts = ts;
-	return _write_history[idx].row;
+	mem_allocator.free(entry, sizeof(WriteHisEntry));
 }
 
 void Row_mvcc::update_buffer(txn_man * txn, TsType type) {
@@ -358,4 +276,3 @@ void Row_mvcc::update_buffer(txn_man * txn, TsType type) {
 	}
 }
 
-#endif
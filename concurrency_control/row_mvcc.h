@@ -4,18 +4,24 @@ class table_t;
 class Catalog;
 class txn_man;
 
-// Only a constant number of versions can be maintained.
+// Committed versions form a list from the newest to the oldest. Versions
+// that no running txn can read any more are cut off the list and handed to
+// epoch_gc, which frees them once no reader can hold them.
 // If a request accesses an old version that has been recycled,   
 // simply abort the request.
 
-#if CC_ALG == MVCC
-struct WriteHisEntry {
-	bool valid;		// whether the entry/slot contains a valid version
-	bool reserved; 	// when valid == false, this field indicates whether the entry is reserved by a P_REQ. If both=false, this slot is not used
-	ts_t ts;
+#include "epoch_gc.h"
+
+struct WriteHisEntry : gc_node {
+	ts_t ts; 		// wts of this version
 	row_t * row;	// That old version/row
+	WriteHisEntry * prev; // the next older version
 };
 
+// pending requests a row holds in place. More go to a heap list of
+// double the size.
+#define MVCC_REQ_INLINE 2
+
 struct ReqEntry {
 	bool valid;
 	TsType type; // P_REQ or R_REQ
@@ -30,8 +36,10 @@ public:
 	void init(row_t * row);
 	// Will get access to the required row itself
 	RC access(txn_man * txn, TsType type, row_t * row);
+	// the newest version older than `ts`, read without the latch. Every
+	// writer below `ts` must be done. NULL if it has been recycled.
+	row_t * read_snapshot(ts_t ts);
 private:
- 	pthread_mutex_t * latch;
 	volatile bool blatch; // A simple bool latch, used along with CAS
 
 	row_t * _row;
@@ -45,36 +53,33 @@ private:
 	// `served` is not used
 	void buffer_req(TsType type, txn_man * txn, bool served);
 
-	// Invariant: all valid entries in _requests have greater ts than any entry in _write_history 
+	// Invariant: all valid entries in _requests have greater ts than any version
+	WriteHisEntry * volatile _latest; // Latest committed version, head of the version list
 	row_t * 		_latest_row; // Latest version
 	ts_t			_latest_wts; // Latest wts in the version chain (updated when write commit)
 	ts_t			_oldest_wts; // Oldest wts in the version chain (updated when recycling)
-	WriteHisEntry * _write_history; // Slots of write history
 	// the following is a small optimization.
 	// the timestamp for the served prewrite request.
 	// There should be at most one served prewrite request.
-	// prewrite means pending write (slots alloc, but not committed yet)
+	// prewrite means pending write (row alloc, but not committed yet)
 	bool  			_exists_prewrite;
 	ts_t 			_prewrite_ts; // ts of that prewriter
-	// Our reserved index in history buffer
-	uint32_t 		_prewrite_his_id;
+	row_t * 		_prewrite_row; // the row that prewriter writes to
 	ts_t 			_max_served_rts; // Max rts I served all the way
 
 	// _requests only contains pending requests.
 	ReqEntry * 		_requests; // Slots of pending requests
-	uint32_t 		_his_len; // Number of write_history slots (capacity), we will usually fix it to 4
 	uint32_t 		_req_len; // Number of requests slots (capacity)
-	// Invariant: _num_versions <= 4
-	// Invariant: _num_prewrite_reservation <= 2
-	uint32_t 		_num_versions; // Number of (valid) versions we store in our history slots
+	ReqEntry 		_req_inline[MVCC_REQ_INLINE]; // _requests until it grows
+	// The table's own row is the initial version. It is never freed.
+	WriteHisEntry 	_first;
 	
-	// list = 0: _write_history
-	// list = 1: _requests
-	void double_list(uint32_t list);
-	// Reserve a slot/version in the write history for a prewriter
-	// Will always succeed if we do enlarging and garbage collection
+	void double_list();
+	// Allocate the row of a prewriter
 	// Passing other `txn` here is ok
 	row_t * reserveRow(ts_t ts, txn_man * txn);
+	// Cut off the versions older than the newest one every running txn can see
+	void collect(txn_man * txn);
+	static void free_version(gc_node * node);
 };
 
-#endif
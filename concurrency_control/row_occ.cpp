@@ -6,10 +6,7 @@
 void 
 Row_occ::init(row_t * row) {
 	_row = row;
-	int part_id = row->get_part_id();
-	_latch = (pthread_mutex_t *) 
-		mem_allocator.alloc(sizeof(pthread_mutex_t), part_id);
-	pthread_mutex_init( _latch, NULL );
+	pthread_mutex_init( &_latch, NULL );
 	wts = 0;
 	blatch = false;
 }
@@ -17,23 +14,23 @@ Row_occ::init(row_t * row) {
 RC
 Row_occ::access(txn_man * txn, TsType type) {
 	RC rc = RCOK;
-	pthread_mutex_lock( _latch );
+	pthread_mutex_lock( &_latch );
 	if (type == R_REQ) {
 		if (txn->start_ts < wts)
 			rc = Abort;
 		else { 
-			txn->cur_row->copy(_row);
+			txn->cur_row->copy(_row, txn->read_cols);
 			rc = RCOK;
 		}
 	} else 
 		assert(false);
-	pthread_mutex_unlock( _latch );
+	pthread_mutex_unlock( &_latch );
 	return rc;
 }
 
 void
 Row_occ::latch() {
-	pthread_mutex_lock( _latch );
+	pthread_mutex_lock( &_latch );
 }
 
 bool
@@ -53,5 +50,5 @@ Row_occ::write(row_t * data, uint64_t ts) {
 
 void
 Row_occ::release() {
-	pthread_mutex_unlock( _latch );
+	pthread_mutex_unlock( &_latch );
 }
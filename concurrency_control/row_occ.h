@@ -18,7 +18,7 @@ public:
 	void				write(row_t * data, uint64_t ts);
 	void 				release();
 private:
- 	pthread_mutex_t * 	_latch;
+ 	pthread_mutex_t 	_latch;
 	bool 				blatch;
 
 	row_t * 			_row; // The real content
@@ -2,8 +2,8 @@
 #include "row.h"
 #include "row_silo.h"
 #include "mem_alloc.h"
+#include "manager.h"
 
-#if CC_ALG==SILO
 
 void 
 Row_silo::init(row_t * row) 
@@ -16,6 +16,7 @@ Row_silo::init(row_t * row)
 	pthread_mutex_init( _latch, NULL );
 	_tid = 0;
 #endif
+	_versions = NULL;
 }
 
 RC
@@ -29,20 +30,56 @@ Row_silo::access(txn_man * txn, TsType type, row_t * local_row) {
 			PAUSE
 			v = _tid_word;
 		}
-		local_row->copy(_row);
+		local_row->copy(_row, txn->read_cols);
 		COMPILER_BARRIER
 		v2 = _tid_word;
 	} 
 	txn->last_tid = v & (~LOCK_BIT);
 #else 
 	lock();
-	local_row->copy(_row);
+	local_row->copy(_row, txn->read_cols);
 	txn->last_tid = _tid;
 	release();
 #endif
 	return RCOK;
 }
 
+void
+Row_silo::read_snapshot(ts_t snapshot, row_t * local_row, uint64_t cols) {
+	ts_t tid;
+#if ATOMIC_WORD
+	uint64_t v = 0;
+	uint64_t v2 = 1;
+	while (v2 != v) {
+		v = _tid_word;
+		while (v & LOCK_BIT) {
+			PAUSE
+			v = _tid_word;
+		}
+		tid = v & (~LOCK_BIT);
+		if (TID_EPOCH(tid) > snapshot)
+			break;
+		local_row->copy(_row, cols);
+		COMPILER_BARRIER
+		v2 = _tid_word;
+	}
+#else
+	lock();
+	tid = _tid;
+	if (TID_EPOCH(tid) <= snapshot)
+		local_row->copy(_row, cols);
+	release();
+#endif
+	if (TID_EPOCH(tid) <= snapshot)
+		return;
+	// The writer of `tid` kept the version before it, since a running txn
+	// is newer than every snapshot. Kept versions do not change.
+	SiloVersion * ver = _versions;
+	while (TID_EPOCH(ver->tid) > snapshot)
+		ver = ver->prev;
+	local_row->copy(ver->row, cols);
+}
+
 bool
 Row_silo::validate(ts_t tid, bool in_write_set) {
 #if ATOMIC_WORD
@@ -68,7 +105,9 @@ Row_silo::validate(ts_t tid, bool in_write_set) {
 }
 
 void
-Row_silo::write(row_t * data, uint64_t tid) {
+Row_silo::write(txn_man * txn, row_t * data, uint64_t tid) {
+	if (g_read_only_snapshot)
+		keep_version(txn, tid);
 	_row->copy(data);
 #if ATOMIC_WORD
 	uint64_t v = _tid_word;
@@ -79,6 +118,66 @@ Row_silo::write(row_t * data, uint64_t tid) {
 #endif
 }
 
+void
+Row_silo::keep_version(txn_man * txn, ts_t tid) {
+#if ATOMIC_WORD
+	ts_t old_tid = _tid_word & (~LOCK_BIT);
+#else
+	ts_t old_tid = _tid;
+#endif
+	// no snapshot older than this is read now or later
+	ts_t oldest = SNAPSHOT_BEFORE(glob_manager->get_min_ts());
+	ts_t snapshot = SNAPSHOT_BEFORE(TID_EPOCH(tid));
+	if (snapshot >= TID_EPOCH(old_tid) && snapshot >= oldest) {
+		SiloVersion * ver = (SiloVersion *) 
+			mem_allocator.alloc(sizeof(SiloVersion), _row->get_part_id());
+		ver->row = (row_t *) mem_allocator.alloc(sizeof(row_t), _row->get_part_id());
+		ver->row->init(_row->get_tuple_size());
+		ver->row->table = _row->get_table();
+		ver->row->copy(_row);
+		ver->tid = old_tid;
+		ver->end = TID_EPOCH(tid);
+		ver->prev = _versions;
+		// snapshot readers follow _versions without the lock
+		COMPILER_BARRIER
+		_versions = ver;
+		// the row may not be written again before no snapshot reads it
+		txn->kept_versions.push_back(SiloKept(this, ver->end));
+	}
+	prune(txn, oldest);
+}
+
+void
+Row_silo::prune(txn_man * txn, ts_t oldest) {
+	// the ends fall down the list
+	SiloVersion * ver = _versions;
+	if (ver == NULL)
+		return;
+	if (ver->end <= oldest)
+		_versions = NULL;
+	else {
+		while (ver->prev != NULL && ver->prev->end > oldest)
+			ver = ver->prev;
+		SiloVersion * keep = ver;
+		ver = keep->prev;
+		keep->prev = NULL;
+	}
+	// a snapshot reader may still be on them
+	while (ver != NULL) {
+		SiloVersion * prev = ver->prev;
+		epoch_gc.retire(txn->get_thd_id(), ver, free_version);
+		ver = prev;
+	}
+}
+
+void
+Row_silo::free_version(gc_node * node) {
+	SiloVersion * ver = (SiloVersion *) node;
+	ver->row->free_row();
+	mem_allocator.free(ver->row, sizeof(row_t));
+	mem_allocator.free(ver, sizeof(SiloVersion));
+}
+
 void
 Row_silo::lock() {
 #if ATOMIC_WORD
@@ -122,4 +221,3 @@ Row_silo::get_tid()
 	return _tid_word & (~LOCK_BIT);
 }
 
-#endif
@@ -5,16 +5,40 @@ class Catalog;
 class txn_man;
 struct TsReqEntry;
 
-#if CC_ALG==SILO
+#include "epoch_gc.h"
+
 #define LOCK_BIT (1UL << 63)
+// A tid is the epoch of the commit above a sequence number
+#define TID_EPOCH_SHIFT		32
+#define TID_EPOCH(tid)		((tid) >> TID_EPOCH_SHIFT)
+// The newest snapshot older than `epoch`. Snapshots are every SNAPSHOT_EPOCHS
+// epochs and hold the versions of their epoch and before.
+#define SNAPSHOT_BEFORE(epoch) \
+	((epoch) == 0? 0 : ((epoch) - 1) / SNAPSHOT_EPOCHS * SNAPSHOT_EPOCHS)
+
+// a version replaced while a snapshot may still read it. Snapshots of the
+// epochs from that of `tid` up to before `end` read it.
+struct SiloVersion : gc_node {
+	ts_t 				tid;
+	ts_t 				end; // epoch of the write that replaced it
+	row_t * 			row;
+	SiloVersion * 		prev; // the next older version
+};
 
 class Row_silo {
 public:
 	void 				init(row_t * row);
 	RC 					access(txn_man * txn, TsType type, row_t * local_row);
+	// copies the columns `cols` of the newest version of epoch `snapshot` or
+	// before to `local_row`. Every txn of those epochs must be done.
+	void 				read_snapshot(ts_t snapshot, row_t * local_row, uint64_t cols);
 	
 	bool				validate(ts_t tid, bool in_write_set);
-	void				write(row_t * data, uint64_t tid);
+	void				write(txn_man * txn, row_t * data, uint64_t tid);
+	// cuts the versions that ended by `oldest`, the oldest snapshot any txn
+	// reads now or later. The row must be locked.
+	void 				prune(txn_man * txn, ts_t oldest);
+	bool 				has_versions() { return _versions != NULL; }
 	
 	void 				lock();
 	void 				release();
@@ -30,6 +54,11 @@ private:
 	ts_t 				_tid;
 #endif
 	row_t * 			_row;
+	// [READ_ONLY_SNAPSHOT] replaced versions, newest first. Only writers
+	// holding the row lock change the list.
+	SiloVersion * volatile _versions;
+	// keeps the version `tid` replaces if a snapshot needs it
+	void 				keep_version(txn_man * txn, ts_t tid);
+	static void 		free_version(gc_node * node);
 };
 
-#endif
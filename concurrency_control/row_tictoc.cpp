@@ -4,7 +4,6 @@
 #include "mem_alloc.h"
 #include <mm_malloc.h>
 
-#if CC_ALG==TICTOC
 
 void 
 Row_tictoc::init(row_t * row)
@@ -19,7 +18,9 @@ Row_tictoc::init(row_t * row)
 	_rts = 0;
 #endif
 #if TICTOC_MV
-	_hist_wts = 0;
+	for (uint32_t i = 0; i < TICTOC_MV_VERSIONS; i ++)
+		_hist_wts[i] = 0;
+	_hist_head = 0;
 #endif
 }
 	
@@ -39,7 +40,7 @@ Row_tictoc::access(txn_man * txn, TsType type, row_t * local_row)
 			PAUSE
 			v = _ts_word;
 		}
-		local_row->copy(_row);
+		local_row->copy(_row, txn->read_cols);
 		COMPILER_BARRIER
 		v2 = _ts_word;
   #if WRITE_PERMISSION_LOCK
@@ -55,7 +56,7 @@ Row_tictoc::access(txn_man * txn, TsType type, row_t * local_row)
 	lock();
 	txn->last_wts = _wts;
 	txn->last_rts = _rts;
-	local_row->copy(_row); 
+	local_row->copy(_row, txn->read_cols); 
 	release();
 #endif
 	return RCOK;
@@ -67,7 +68,10 @@ Row_tictoc::write_data(row_t * data, ts_t wts)
 #if ATOMIC_WORD
   	uint64_t v = _ts_word;
   #if TICTOC_MV
-	_hist_wts = v & WTS_MASK;
+	uint32_t head = (_hist_head + 1) % TICTOC_MV_VERSIONS;
+	_hist_wts[head] = v & WTS_MASK;
+	COMPILER_BARRIER
+	_hist_head = head;
   #endif
   #if WRITE_PERMISSION_LOCK
 	assert(__sync_bool_compare_and_swap(&_ts_word, v, v | LOCK_BIT));
@@ -81,7 +85,8 @@ Row_tictoc::write_data(row_t * data, ts_t wts)
   #endif
 #else 
   #if TICTOC_MV
-	_hist_wts = _wts;
+	_hist_head = (_hist_head + 1) % TICTOC_MV_VERSIONS;
+	_hist_wts[_hist_head] = _wts;
   #endif
 	_wts = wts;
 	_rts = wts;
@@ -95,7 +100,7 @@ Row_tictoc::renew_lease(ts_t wts, ts_t rts)
 #if !ATOMIC_WORD
 	if (_wts != wts) {
   #if TICTOC_MV
-		if (wts == _hist_wts && rts < _wts) 
+		if (rts < next_wts(wts, _wts))
 			return true;
   #endif
 		return false;
@@ -116,14 +121,17 @@ Row_tictoc::try_renew(ts_t wts, ts_t rts, ts_t &new_rts, uint64_t thd_id)
 	if (v & lock_mask)
 		return false; 
   #if TICTOC_MV
-  	COMPILER_BARRIER
-  	uint64_t hist_wts = _hist_wts;
 	if (wts != (v & WTS_MASK)) {
-		if (wts == hist_wts && rts < (v & WTS_MASK)) {
-			return true;
-		} else {
+		ts_t next = next_wts(wts, v & WTS_MASK);
+		COMPILER_BARRIER
+		// a writer came in between and may have moved the history
+		if ((_ts_word | RTS_MASK) != (v | RTS_MASK))
 			return false;
+		if (rts < next) {
+			INC_STATS(thd_id, mv_renew_cnt, 1);
+			return true;
 		}
+		return false;
 	}
   #else
 	if (wts != (v & WTS_MASK)) 
@@ -156,10 +164,7 @@ Row_tictoc::try_renew(ts_t wts, ts_t rts, ts_t &new_rts, uint64_t thd_id)
 	assert(false);
 	return false;
 #else
-  #if TICTOC_MV
-	if (wts < _hist_wts)
-		return false;
-  #else 
+  #if !TICTOC_MV
 	if (wts != _wts)
 		return false;
   #endif
@@ -169,8 +174,9 @@ Row_tictoc::try_renew(ts_t wts, ts_t rts, ts_t &new_rts, uint64_t thd_id)
 
 	if (wts != _wts) { 
   #if TICTOC_MV
-		if (wts == _hist_wts && rts < _wts) {
+		if (rts < next_wts(wts, _wts)) {
 			pthread_mutex_unlock( _latch );
+			INC_STATS(thd_id, mv_renew_cnt, 1);
 			return true;
 		}
   #endif
@@ -185,6 +191,24 @@ Row_tictoc::try_renew(ts_t wts, ts_t rts, ts_t &new_rts, uint64_t thd_id)
 #endif
 }
 
+#if TICTOC_MV
+ts_t
+Row_tictoc::next_wts(ts_t wts, ts_t cur_wts)
+{
+	// the wts of the versions of a row only grow
+	ts_t next = cur_wts;
+	uint32_t head = _hist_head;
+	for (uint32_t i = 0; i < TICTOC_MV_VERSIONS; i ++) {
+		ts_t hist_wts = _hist_wts[(head + TICTOC_MV_VERSIONS - i) % TICTOC_MV_VERSIONS];
+		if (hist_wts == wts)
+			return next;
+		if (hist_wts < wts)
+			break;
+		next = hist_wts;
+	}
+	return 0;
+}
+#endif
 
 ts_t
 Row_tictoc::get_wts()
@@ -258,4 +282,3 @@ Row_tictoc::release()
 #endif
 }
 
-#endif
@@ -2,7 +2,6 @@
 
 #include "global.h"
 
-#if CC_ALG == TICTOC
 
 #if WRITE_PERMISSION_LOCK
 
@@ -31,9 +30,6 @@ class Row_tictoc {
 public:
 	void 				init(row_t * row);
 	RC 					access(txn_man * txn, TsType type, row_t * local_row);
-#if SPECULATE
-	RC					write_speculate(row_t * data, ts_t version, bool spec_read); 
-#endif
 	void				write_data(row_t * data, ts_t wts);
 	void				write_ptr(row_t * data, ts_t wts, char *& data_to_free);
 	bool 				renew_lease(ts_t wts, ts_t rts);
@@ -56,8 +52,14 @@ private:
 	pthread_mutex_t * 	_latch;
 #endif
 #if TICTOC_MV
-	volatile ts_t 		_hist_wts;
+	// wts of the last TICTOC_MV_VERSIONS versions replaced, the newest at
+	// _hist_head. A read of one of them is still good below the wts of the
+	// version that replaced it. Written under the row lock.
+	volatile ts_t 		_hist_wts[TICTOC_MV_VERSIONS];
+	volatile uint32_t 	_hist_head;
+	// the wts of the version that replaced the one of `wts`, or 0 if that
+	// one is not kept. `cur_wts` is the wts of the current version.
+	ts_t 				next_wts(ts_t wts, ts_t cur_wts);
 #endif
 };
 
-#endif
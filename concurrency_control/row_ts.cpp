@@ -7,7 +7,6 @@
 
 void Row_ts::init(row_t * row) {
 	_row = row;
-	uint64_t part_id = row->get_part_id();
 	wts = 0;
 	rts = 0;
 	min_wts = UINT64_MAX;
@@ -17,9 +16,7 @@ void Row_ts::init(row_t * row) {
     writereq = NULL;
     prereq = NULL;
 	preq_len = 0;
-	latch = (pthread_mutex_t *) 
-		mem_allocator.alloc(sizeof(pthread_mutex_t), part_id);
-	pthread_mutex_init( latch, NULL );
+	pthread_mutex_init( &latch, NULL );
 	blatch = false;
 }
 
@@ -154,7 +151,7 @@ RC Row_ts::access(txn_man * txn, TsType type, row_t * row) {
 	if (g_central_man)
 		glob_manager->lock_row(_row);
 	else
-		pthread_mutex_lock( latch ); // Use mutex instead of CAS (Sec 4.3)
+		pthread_mutex_lock( &latch ); // Use mutex instead of CAS (Sec 4.3)
 	if (type == R_REQ) { // When a reader calls me for the first time
 		if (ts < wts) { // Already wrote by someone else, first writer wins (Sec 2.2)
 			rc = Abort;
@@ -165,7 +162,7 @@ RC Row_ts::access(txn_man * txn, TsType type, row_t * row) {
 			rc = WAIT;
 		} else { // Good, I'm one of the first to access this row
 			// return the value (a copy for read).
-			txn->cur_row->copy(_row);
+			txn->cur_row->copy(_row, txn->read_cols);
 			if (rts < ts)
 				rts = ts;
 			rc = RCOK;
@@ -176,12 +173,15 @@ RC Row_ts::access(txn_man * txn, TsType type, row_t * row) {
 		} else {
 #if TS_TWR
 			buffer_req(P_REQ, txn, NULL);
+			txn->cur_row->copy(_row);
 			rc = RCOK;
 #else 
 			if (ts < wts) { // Sec 2.2
 				rc = Abort;
 			} else { // One of the first to access this row, wait to commit
 				buffer_req(P_REQ, txn, NULL); // Will not set `ts_ready` since there's no wait like R_REQ and we will deal with its commit phase very soon
+				// the whole copy is written back, so it starts as the row
+				txn->cur_row->copy(_row);
 				rc = RCOK;
 			}
 #endif
@@ -238,7 +238,7 @@ final:
 	if (g_central_man)
 		glob_manager->release_row(_row);
 	else
-		pthread_mutex_unlock( latch );
+		pthread_mutex_unlock( &latch );
 	return rc;
 }
 
@@ -258,7 +258,7 @@ void Row_ts::update_buffer() {
 		// for each debuffered readreq, perform read.
 		TsReqEntry * req = ready_read;
 		while (req != NULL) {			// These readers are ready now, read what the writer just wrote
-			req->txn->cur_row->copy(_row);
+			req->txn->cur_row->copy(_row, req->txn->read_cols);
 			if (rts < req->ts)
 				rts = req->ts;
 			req->txn->ts_ready = true;
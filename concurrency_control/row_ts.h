@@ -21,7 +21,7 @@ public:
 	RC access(txn_man * txn, TsType type, row_t * row);
 
 private:
- 	pthread_mutex_t * latch; // A mutex lock, for critical section
+ 	pthread_mutex_t latch; // A mutex lock, for critical section
 	bool blatch;
 	// Put a txn into req buffer, wait for previous txn to commit (similar to reservation in MVCC)
 	// It's more like reserve a slot, not only when someone is blocked do we do buffering
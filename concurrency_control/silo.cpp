@@ -1,8 +1,8 @@
 #include "txn.h"
 #include "row.h"
 #include "row_silo.h"
+#include "manager.h"
 
-#if CC_ALG == SILO
 
 RC
 txn_man::validate_silo()
@@ -35,18 +35,21 @@ txn_man::validate_silo()
 
 	int num_locks = 0;
 	ts_t max_tid = 0;
+	uint64_t epoch = 0;
 	bool done = false;
 	if (_pre_abort) {
 		for (int i = 0; i < wr_cnt; i++) {
 			row_t * row = accesses[ write_set[i] ]->orig_row;
-			if (row->manager->get_tid() != accesses[write_set[i]]->tid) {
+			if (row->get_manager<SILO>()->get_tid() != accesses[write_set[i]]->tid) {
+				set_abort(ABORT_VALIDATE, row);
 				rc = Abort;
 				goto final;
 			}	
 		}	
 		for (int i = 0; i < row_cnt - wr_cnt; i ++) {
 			Access * access = accesses[ read_set[i] ];
-			if (access->orig_row->manager->get_tid() != accesses[read_set[i]]->tid) {
+			if (access->orig_row->get_manager<SILO>()->get_tid() != accesses[read_set[i]]->tid) {
+				set_abort(ABORT_VALIDATE, access->orig_row);
 				rc = Abort;
 				goto final;
 			}
@@ -59,12 +62,13 @@ txn_man::validate_silo()
 			num_locks = 0;
 			for (int i = 0; i < wr_cnt; i++) {
 				row_t * row = accesses[ write_set[i] ]->orig_row;
-				if (!row->manager->try_lock())
+				if (!row->get_manager<SILO>()->try_lock())
 					break;
-				row->manager->assert_lock();
+				row->get_manager<SILO>()->assert_lock();
 				num_locks ++;
-				if (row->manager->get_tid() != accesses[write_set[i]]->tid)
+				if (row->get_manager<SILO>()->get_tid() != accesses[write_set[i]]->tid)
 				{
+					set_abort(ABORT_VALIDATE, row);
 					rc = Abort;
 					goto final;
 				}
@@ -73,19 +77,21 @@ txn_man::validate_silo()
 				done = true;
 			else {
 				for (int i = 0; i < num_locks; i++)
-					accesses[ write_set[i] ]->orig_row->manager->release();
+					accesses[ write_set[i] ]->orig_row->get_manager<SILO>()->release();
 				if (_pre_abort) {
 					num_locks = 0;
 					for (int i = 0; i < wr_cnt; i++) {
 						row_t * row = accesses[ write_set[i] ]->orig_row;
-						if (row->manager->get_tid() != accesses[write_set[i]]->tid) {
+						if (row->get_manager<SILO>()->get_tid() != accesses[write_set[i]]->tid) {
+							set_abort(ABORT_VALIDATE, row);
 							rc = Abort;
 							goto final;
 						}	
 					}	
 					for (int i = 0; i < row_cnt - wr_cnt; i ++) {
 						Access * access = accesses[ read_set[i] ];
-						if (access->orig_row->manager->get_tid() != accesses[read_set[i]]->tid) {
+						if (access->orig_row->get_manager<SILO>()->get_tid() != accesses[read_set[i]]->tid) {
+							set_abort(ABORT_VALIDATE, access->orig_row);
 							rc = Abort;
 							goto final;
 						}
@@ -97,21 +103,25 @@ txn_man::validate_silo()
 	} else {
 		for (int i = 0; i < wr_cnt; i++) {
 			row_t * row = accesses[ write_set[i] ]->orig_row;
-			row->manager->lock();
+			row->get_manager<SILO>()->lock();
 			num_locks++;
-			if (row->manager->get_tid() != accesses[write_set[i]]->tid) {
+			if (row->get_manager<SILO>()->get_tid() != accesses[write_set[i]]->tid) {
+				set_abort(ABORT_VALIDATE, row);
 				rc = Abort;
 				goto final;
 			}
 		}
 	}
 
+	// the write set is locked (with a fence), so the txn commits in this epoch
+	epoch = glob_manager->get_epoch();
 	// validate rows in the read set
 	// for repeatable_read, no need to validate the read set.
 	for (int i = 0; i < row_cnt - wr_cnt; i ++) {
 		Access * access = accesses[ read_set[i] ];
-		bool success = access->orig_row->manager->validate(access->tid, false);
+		bool success = access->orig_row->get_manager<SILO>()->validate(access->tid, false);
 		if (!success) {
+			set_abort(ABORT_VALIDATE, access->orig_row);
 			rc = Abort;
 			goto final;
 		}
@@ -121,8 +131,9 @@ txn_man::validate_silo()
 	// validate rows in the write set
 	for (int i = 0; i < wr_cnt; i++) {
 		Access * access = accesses[ write_set[i] ];
-		bool success = access->orig_row->manager->validate(access->tid, true);
+		bool success = access->orig_row->get_manager<SILO>()->validate(access->tid, true);
 		if (!success) {
+			set_abort(ABORT_VALIDATE, access->orig_row);
 			rc = Abort;
 			goto final;
 		}
@@ -133,20 +144,39 @@ txn_man::validate_silo()
 		_cur_tid = max_tid + 1;
 	else 
 		_cur_tid ++;
+	if (_cur_tid < (epoch << TID_EPOCH_SHIFT))
+		_cur_tid = epoch << TID_EPOCH_SHIFT;
 final:
 	if (rc == Abort) {
 		for (int i = 0; i < num_locks; i++) 
-			accesses[ write_set[i] ]->orig_row->manager->release();
-		cleanup(rc);
+			accesses[ write_set[i] ]->orig_row->get_manager<SILO>()->release();
+		cleanup<SILO>(rc);
 	} else {
+		on_commit(_cur_tid);
 		for (int i = 0; i < wr_cnt; i++) {
 			Access * access = accesses[ write_set[i] ];
-			access->orig_row->manager->write( 
-				access->data, _cur_tid );
-			accesses[ write_set[i] ]->orig_row->manager->release();
+			access->orig_row->get_manager<SILO>()->write( 
+				this, access->data, _cur_tid );
+			accesses[ write_set[i] ]->orig_row->get_manager<SILO>()->release();
 		}
-		cleanup(rc);
+		cleanup<SILO>(rc);
 	}
 	return rc;
 }
-#endif
+
+void
+txn_man::prune_versions()
+{
+	ts_t oldest = SNAPSHOT_BEFORE(glob_manager->get_min_ts());
+	while (!kept_versions.empty() && kept_versions.front().end <= oldest) {
+		Row_silo * row = kept_versions.front().row;
+		if (row->has_versions()) {
+			// a writer holds it, try again next time
+			if (!row->try_lock())
+				break;
+			row->prune(this, oldest);
+			row->release();
+		}
+		kept_versions.pop_front();
+	}
+}
@@ -3,7 +3,6 @@
 #include "row_tictoc.h"
 #include "manager.h"
 
-#if CC_ALG==TICTOC
 
 RC
 txn_man::validate_tictoc()
@@ -72,8 +71,9 @@ txn_man::validate_tictoc()
 	if (_pre_abort) {
 		for (int i = 0; i < wr_cnt; i++) {
 			row_t * row = accesses[ write_set[i] ]->orig_row;
-			if (row->manager->get_wts() != accesses[ write_set[i] ]->wts)
+			if (row->get_manager<TICTOC>()->get_wts() != accesses[ write_set[i] ]->wts)
 			{	
+				set_abort(ABORT_VALIDATE, row);
 				rc = Abort;
 				goto final;
 			}
@@ -83,13 +83,14 @@ txn_man::validate_tictoc()
 			row_t * row = accesses[ read_set[i] ]->orig_row;
 			bool lock;
 			uint64_t wts, rts;
-			row->manager->get_ts_word(lock, rts, wts);
+			row->get_manager<TICTOC>()->get_ts_word(lock, rts, wts);
 		#if TICTOC_MV 
 			if (commit_wts > wts && (wts != accesses[ read_set[i] ]->wts))
 		#else 
 			if (commit_wts > rts && (wts != accesses[ read_set[i] ]->wts))
 		#endif
 			{	
+				set_abort(ABORT_VALIDATE, row);
 				rc = Abort;
 				goto final;
 			}
@@ -103,11 +104,12 @@ txn_man::validate_tictoc()
 			num_locks = 0;
 			for (int i = 0; i < wr_cnt; i++) {
 				row_t * row = accesses[ write_set[i] ]->orig_row;
-				if (!row->manager->try_lock())
+				if (!row->get_manager<TICTOC>()->try_lock())
 					break;
 				num_locks ++;
-				if (row->manager->get_wts() != accesses[ write_set[i] ]->wts)
+				if (row->get_manager<TICTOC>()->get_wts() != accesses[ write_set[i] ]->wts)
 				{
+					set_abort(ABORT_VALIDATE, row);
 					rc = Abort;
 					goto final;
 				}
@@ -116,13 +118,14 @@ txn_man::validate_tictoc()
 				done = true;
 			else {
 				for (int i = 0; i < num_locks; i++)
-					accesses[ write_set[i] ]->orig_row->manager->release();
+					accesses[ write_set[i] ]->orig_row->get_manager<TICTOC>()->release();
 				if (_pre_abort) {
 					num_locks = 0;
 					for (int i = 0; i < wr_cnt; i++) {
 						row_t * row = accesses[ write_set[i] ]->orig_row;
-						if (row->manager->get_wts() != accesses[ write_set[i] ]->wts)
+						if (row->get_manager<TICTOC>()->get_wts() != accesses[ write_set[i] ]->wts)
 						{
+							set_abort(ABORT_VALIDATE, row);
 							rc = Abort;
 							goto final;
 						}
@@ -132,13 +135,14 @@ txn_man::validate_tictoc()
 						Access * access = accesses[ read_set[i] ];
 						bool lock;
 						uint64_t wts, rts;
-						access->orig_row->manager->get_ts_word(lock, rts, wts);
+						access->orig_row->get_manager<TICTOC>()->get_ts_word(lock, rts, wts);
 					#if TICTOC_MV 
 						if (wts != access->wts && commit_wts > wts)
 					#else 
 						if (wts != access->wts && commit_wts > rts)
 					#endif
 						{
+							set_abort(ABORT_VALIDATE, access->orig_row);
 							rc = Abort;
 							goto final;
 						}
@@ -152,10 +156,11 @@ txn_man::validate_tictoc()
 	else { // _validation_no_wait = false
 		for (int i = 0; i < wr_cnt; i++) {
 			row_t * row = accesses[ write_set[i] ]->orig_row;
-			row->manager->lock();
+			row->get_manager<TICTOC>()->lock();
 			num_locks++;
-			if (row->manager->get_wts() != accesses[ write_set[i] ]->wts)
+			if (row->get_manager<TICTOC>()->get_wts() != accesses[ write_set[i] ]->wts)
 			{
+				set_abort(ABORT_VALIDATE, row);
 				rc = Abort;
 				goto final;
 			}
@@ -163,8 +168,8 @@ txn_man::validate_tictoc()
 	}
 	for (int i = 0; i < wr_cnt; i++) {
 		row_t * row = accesses[ write_set[i] ]->orig_row;
-		if (row->manager->get_rts() + 1 > commit_wts)
-			commit_wts = row->manager->get_rts() + 1;
+		if (row->get_manager<TICTOC>()->get_rts() + 1 > commit_wts)
+			commit_wts = row->get_manager<TICTOC>()->get_rts() + 1;
 	}
 
 	assert (num_locks == wr_cnt);
@@ -173,13 +178,14 @@ txn_man::validate_tictoc()
 	#if ISOLATION_LEVEL == SERIALIZABLE || ISOLATION_LEVEL == REPEATABLE_READ
 		Access * access = accesses[ read_set[i] ];
 		if ( access->rts < commit_wts ) {
-			bool success = access->orig_row->manager->try_renew(access->wts, commit_wts, access->rts, get_thd_id());
+			bool success = access->orig_row->get_manager<TICTOC>()->try_renew(access->wts, commit_wts, access->rts, get_thd_id());
     #elif ISOLATION_LEVEL == SNAPSHOT
 		Access * access = accesses[ read_set[i] ];
 		if ( access->rts < commit_rts ) {
-			bool success = access->orig_row->manager->try_renew(access->wts, commit_rts, access->rts, get_thd_id());
+			bool success = access->orig_row->get_manager<TICTOC>()->try_renew(access->wts, commit_rts, access->rts, get_thd_id());
     #endif
 			if (!success) {
+				set_abort(ABORT_VALIDATE, access->orig_row);
 				rc = Abort;
 				goto final;
 			}
@@ -189,18 +195,18 @@ txn_man::validate_tictoc()
 /*	for (int i = 0; i < row_cnt; i++) {
 		int rid = sorted_set[i];
 		row_t * row = accesses[ rid ]->orig_row;
-		row->manager->lock();
+		row->get_manager<TICTOC>()->lock();
 		num_locks++;
 		if (accesses[ rid ]->type == WR) {
-			if (row->manager->get_wts() != accesses[ rid ]->wts) {
+			if (row->get_manager<TICTOC>()->get_wts() != accesses[ rid ]->wts) {
 				rc = Abort;
 				goto final;
 			}
-			if (row->manager->get_rts() + 1 > max_wts)
-				max_wts = row->manager->get_rts() + 1;
+			if (row->get_manager<TICTOC>()->get_rts() + 1 > max_wts)
+				max_wts = row->get_manager<TICTOC>()->get_rts() + 1;
 		} else if (accesses[rid]->type == RD) {
-			if (row->manager->get_wts() != accesses[rid]->wts 
-					&& max_wts > row->manager->get_wts())
+			if (row->get_manager<TICTOC>()->get_wts() != accesses[rid]->wts 
+					&& max_wts > row->get_manager<TICTOC>()->get_wts())
 			{
 				rc = Abort;
 				goto final;
@@ -209,7 +215,7 @@ txn_man::validate_tictoc()
 	}
 	for (int i = 0; i < row_cnt - wr_cnt; i++) {
 		Access * access = accesses[ read_set[i] ];
-		if (!access->orig_row->manager->renew_lease(access->wts, access->rts))
+		if (!access->orig_row->get_manager<TICTOC>()->renew_lease(access->wts, access->rts))
 		{
 			rc = Abort;
 			goto final;
@@ -221,15 +227,16 @@ final:
 	if (rc == Abort) {
 #if WR_VALIDATION_SEPARATE 
 		for (int i = 0; i < num_locks; i++) 
-			accesses[ write_set[i] ]->orig_row->manager->release();
+			accesses[ write_set[i] ]->orig_row->get_manager<TICTOC>()->release();
 #else 
 		for (int i = 0; i < num_locks; i++) 
-			accesses[ sorted_set[i] ]->orig_row->manager->release();
+			accesses[ sorted_set[i] ]->orig_row->get_manager<TICTOC>()->release();
 #endif
-		cleanup(rc);
+		cleanup<TICTOC>(rc);
 	} else {
 		if (commit_wts > _max_wts)
 			_max_wts = commit_wts;
+		on_commit(commit_wts);
 
 		if (_write_copy_ptr) {
 			assert(false);
@@ -237,22 +244,22 @@ final:
 #if WR_VALIDATION_SEPARATE 
 			for (int i = 0; i < wr_cnt; i++) {
 				Access * access = accesses[ write_set[i] ];
-				access->orig_row->manager->write_data( 
+				access->orig_row->get_manager<TICTOC>()->write_data( 
 					access->data, commit_wts);
-				access->orig_row->manager->release();
+				access->orig_row->get_manager<TICTOC>()->release();
 			}
 #else 
 //			for (int i = 0; i < row_cnt; i++) {
 //				Access * access = accesses[ i ];
 //				if (access->type == WR)
-//					access->orig_row->manager->write_data(access->data, max_wts);
-//				access->orig_row->manager->release();
+//					access->orig_row->get_manager<TICTOC>()->write_data(access->data, max_wts);
+//				access->orig_row->get_manager<TICTOC>()->release();
 //			}
 #endif
 		}
 		if (g_prt_lat_distr)
 			stats.add_debug(get_thd_id(), commit_wts, 2);
-		cleanup(rc);
+		cleanup<TICTOC>(rc);
 		if (_atomic_timestamp && rc == RCOK) {
 			ts_t ts = glob_manager->get_ts(get_thd_id());
 			if (g_prt_lat_distr)
@@ -269,4 +276,3 @@ txn_man::update_max_wts(ts_t max_wts)
 	if (max_wts > _max_wts) 
 		_max_wts = max_wts; 
 }
-#endif
@@ -8,7 +8,6 @@
 #include "wl.h"
 #include "catalog.h"
 #include "mem_alloc.h"
-#if CC_ALG == VLL
 
 void 
 VLLMan::init() {
@@ -31,8 +30,8 @@ VLLMan::vllMainLoop(txn_man * txn, base_query * query) {
 		item = txn->index_read(index, req->key, part_id);
 		row_t * row = ((row_t *)item->location);
 		// the following line adds the read/write sets to txn->accesses
-		txn->get_row(row, req->rtype);
-		int cs = row->manager->get_cs();
+		txn->get_row<VLL>(row, req->rtype);
+		int cs = row->get_manager<VLL>()->get_cs();
 	}
 
 	bool done = false;
@@ -80,7 +79,7 @@ VLLMan::beginTxn(txn_man * txn, base_query * query, TxnQEntry *& entry) {
 	
 	for (int rid = 0; rid < txn->row_cnt; rid ++ ) {
 		access_t type = txn->accesses[rid]->type;
-		if (txn->accesses[rid]->orig_row->manager->insert_access(type))
+		if (txn->accesses[rid]->orig_row->get_manager<VLL>()->insert_access(type))
 			txn->vll_txn_type = VLL_Blocked;
 	}
 	
@@ -128,7 +127,7 @@ VLLMan::finishTxn(txn_man * txn, TxnQEntry * entry) {
 	
 	for (int rid = 0; rid < txn->row_cnt; rid ++ ) {
 		access_t type = txn->accesses[rid]->type;
-		txn->accesses[rid]->orig_row->manager->remove_access(type);
+		txn->accesses[rid]->orig_row->get_manager<VLL>()->remove_access(type);
 	}
 	LIST_REMOVE_HT(entry, _txn_queue, _txn_queue_tail);
 	pthread_mutex_unlock(&_mutex);
@@ -151,4 +150,3 @@ VLLMan::returnQEntry(TxnQEntry * entry) {
  	mem_allocator.free(entry, sizeof(TxnQEntry));
 }
 
-#endif
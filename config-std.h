@@ -20,25 +20,35 @@
 // print the transaction latency distribution
 #define PRT_LAT_DISTR				false
 #define STATS_ENABLE				true
+// sample the stats of all threads every SAMPLE_INTERVAL ms during the run
+// into SAMPLE_FILE (0: off)
+#define SAMPLE_INTERVAL				0
+#define SAMPLE_FILE					"samples.csv"
+// attribute aborts to reasons and rows, reporting the PROF_TOP_K rows of each
+// table that wasted most time in aborted attempts
+#define PROF_ABORT					false
+#define PROF_TOP_K					16
 #define TIME_ENABLE					true 
 
 #define MEM_ALLIGN					8 
 
 // [THREAD_ALLOC]
 #define THREAD_ALLOC				false
-#define THREAD_ARENA_SIZE			(1UL << 22) 
+#define THREAD_HEAP_SIZE			(1UL << 36) // Address space reserved for the slabs of all threads
 #define MEM_PAD 					true
 
 // [PART_ALLOC] 
 #define PART_ALLOC 					false
-#define MEM_SIZE					(1UL << 30) 
+#define MEM_SIZE					(1UL << 30) // Split evenly among partitions, each bound to a NUMA node
 #define NO_FREE						false
 
 /***********************************************/
 // Concurrency Control
 /***********************************************/
 // WAIT_DIE, NO_WAIT, DL_DETECT, TIMESTAMP, MVCC, HEKATON, HSTORE, OCC, VLL, TICTOC, SILO
-// TODO TIMESTAMP does not work at this moment
+// TODO TIMESTAMP does not work at this moment (a warning is printed)
+// TODO VLL is rejected at this moment
+// every algorithm is compiled in. This is the default of -c<ALG>.
 #define CC_ALG 						TICTOC
 #define ISOLATION_LEVEL 			SERIALIZABLE
 
@@ -56,12 +66,14 @@
 #define ENABLE_LATCH				false
 #define CENTRAL_INDEX				false
 #define CENTRAL_MANAGER 			false
-#define INDEX_STRUCT				IDX_HASH
+#define INDEX_STRUCT				IDX_HASH // IDX_HASH, IDX_HASH_LF, IDX_BTREE or IDX_BTREE_OLC
 #define BTREE_ORDER 				16
 
 // [DL_DETECT] 
 #define DL_LOOP_DETECT				1000 	// 100 us
 #define DL_LOOP_TRIAL				100	// 1 us
+// a background thread looks for cycles every DL_LOOP_DETECT instead of the waiters
+#define DL_DETECT_THREAD			false
 #define NO_DL						KEY_ORDER
 #define TIMEOUT						1000000 // 1ms
 // [TIMESTAMP]
@@ -69,19 +81,28 @@
 #define TS_ALLOC					TS_CAS
 #define TS_BATCH_ALLOC				false
 #define TS_BATCH_NUM				1
+// OCC takes only TS_MUTEX and TS_CAS
+// [TS_LOCAL_CLOCK] ns between two skew corrections of a thread's clock
+#define TS_SYNC_INTVL				100000
 // [MVCC]
 // when read/write history is longer than HIS_RECYCLE_LEN
 // the history should be recycled.
 //#define HIS_RECYCLE_LEN				10
 //#define MAX_PRE_REQ					1024
 //#define MAX_READ_REQ				1024
-#define MIN_TS_INTVL				5000000 //5 ms. In nanoseconds
+#define GC_BATCH_SIZE				256 // Retired versions a thread keeps before it tries to free them
+// [MVCC, HEKATON, SILO] a txn declared read-only reads a snapshot without
+// leaving a trace on the rows and commits without validation
+#define READ_ONLY_SNAPSHOT			false
 // [OCC]
 #define MAX_WRITE_SET				10
 #define PER_ROW_VALID				true
 // [TICTOC]
 #define WRITE_COPY_FORM				"data" // ptr or data
 #define TICTOC_MV					false
+// [TICTOC_MV] replaced versions whose wts a row keeps, so that a read of one
+// of them still commits below the wts of the version after it
+#define TICTOC_MV_VERSIONS			4
 #define WR_VALIDATION_SEPARATE		true
 #define WRITE_PERMISSION_LOCK		false
 #define ATOMIC_TIMESTAMP			"false"
@@ -89,6 +110,9 @@
 #define VALIDATION_LOCK				"no-wait" // no-wait or waiting
 #define PRE_ABORT					"true"
 #define ATOMIC_WORD					true
+// [SILO, READ_ONLY_SNAPSHOT] epochs between two snapshots. A write keeps the
+// version it replaces if a snapshot lies between the two.
+#define SNAPSHOT_EPOCHS				10
 // [HSTORE]
 // when set to true, hstore will not access the global timestamp.
 // This is fine for single partition transactions. 
@@ -102,13 +126,26 @@
 #define LOG_COMMAND					false
 #define LOG_REDO					false
 #define LOG_BATCH_TIME				10 // in ms
+#define LOG_THREAD_CNT				1 // Logger threads, each writes its own file
+#define LOG_BUFFER_SIZE				(1UL << 22) // Per worker log ring and per logger staging buffer, a power of 2
+#define LOG_DIR						"log"
+// snapshot the tables to LOG_DIR at startup / load them from there and
+// replay the redo log instead of generating them
+#define CHECKPOINT					false
+#define RECOVER						false
 
 /***********************************************/
 // Benchmark
 /***********************************************/
-// max number of rows touched per transaction
-#define MAX_ROW_PER_TXN				64
+// max number of rows touched per transaction. A TPC-C stock-level reads up
+// to 600 rows.
+#define MAX_ROW_PER_TXN				1024
 #define QUERY_INTVL 				1UL
+#define QUERY_POOL_SIZE				64 // Queries each thread generates ahead, in one batch
+// Offered load in txns/s of all threads. With 0 a thread starts its next txn
+// as soon as the last one commits (closed loop).
+#define ARRIVAL_RATE				0
+#define ARRIVAL_POISSON				true // Exponential interarrival times, or a constant rate
 #define MAX_TXN_PER_PART 			100
 #define FIRST_PART_LOCAL 			true
 #define MAX_TUPLE_SIZE				1024 // in bytes
@@ -144,7 +181,12 @@ enum TPCCTxnType {TPCC_ALL,
 extern TPCCTxnType 					g_tpcc_txn_type;
 
 //#define TXN_TYPE					TPCC_ALL
-#define PERC_PAYMENT 				0.5
+// The mix of the five txns. New-order takes what the others leave, 45% with
+// the defaults, which are the shares of the TPC-C spec.
+#define PERC_PAYMENT 				0.43
+#define PERC_ORDER_STATUS			0.04
+#define PERC_DELIVERY				0.04
+#define PERC_STOCK_LEVEL			0.04
 #define FIRSTNAME_MINLEN 			8
 #define FIRSTNAME_LEN 				16
 #define LASTNAME_LEN 				16
@@ -189,6 +231,8 @@ extern TestCases					g_test_case;
 // INDEX_STRUCT
 #define IDX_HASH 					1
 #define IDX_BTREE					2
+#define IDX_HASH_LF					3
+#define IDX_BTREE_OLC				4
 // WORKLOAD
 #define YCSB						1
 #define TPCC						2
@@ -214,5 +258,6 @@ extern TestCases					g_test_case;
 #define TS_CAS						2
 #define TS_HW						3
 #define TS_CLOCK					4
+#define TS_LOCAL_CLOCK				5
 
 #endif
@@ -4,10 +4,14 @@
 
 void 
 Catalog::init(const char * table_name, int field_cnt) { // Specify how many fields we need
-	this->table_name = table_name;
+	// the caller's string may not outlive the catalog
+	char * name = new char [strlen(table_name) + 1];
+	strcpy(name, table_name);
+	this->table_name = name;
 	this->field_cnt = 0;
 	this->_columns = new Column [field_cnt];
 	this->tuple_size = 0;
+	this->pax = false;
 }
 
 void Catalog::add_col(char * col_name, uint64_t size, char * type) {
@@ -4,6 +4,12 @@
 #include <vector>
 #include "global.h"
 #include "helper.h"
+// [PAX] The tuples of a PAX table lie in pages of 2^PAX_PAGE_BITS rows. A
+// page stores one column after the other, so a scan of one column reads only
+// that column.
+#define PAX_PAGE_BITS		6
+#define PAX_PAGE_ROWS		(1UL << PAX_PAGE_BITS)
+
 // Column title / specifications
 class Column {
 public:
@@ -51,9 +57,14 @@ public:
 	uint64_t 		get_field_id(const char * name);
 	char * 			get_field_type(char * name);
 	uint64_t 		get_field_index(char * name);
+	// [PAX] where field `id` of the row in `slot` of a page lies in the page
+	uint64_t 		get_pax_offset(int id, uint64_t slot) { 
+		return PAX_PAGE_ROWS * _columns[id].index + slot * _columns[id].size; 
+	};
 
 	void 			print_schema();
 	Column * 		_columns; // Array of column data structure (column title)
 	UInt32 			tuple_size; // Size of a single tuple (sum of all its fields/cols)
+	bool 			pax; // the table is stored in PAX pages
 };
 
@@ -4,6 +4,18 @@
 
 class table_t;
 
+// Position of a range scan. index_scan fills it in and index_next moves it.
+// `node`, `version` and `pos` belong to the index that filled the cursor.
+struct idx_cursor {
+	idx_key_t 			key; // smallest key not returned yet
+	idx_key_t 			hi; // the scan covers [lo, hi]
+	int 				part_id;
+	bool 				done;
+	void * 				node;
+	uint64_t 			version;
+	UInt32 				pos;
+};
+
 class index_base {
 public:
 	virtual RC 			init() { return RCOK; };
@@ -23,6 +35,32 @@ public:
 							itemid_t * &item,
 							int part_id=-1, int thd_id=0)=0;
 
+	// Range scan over [lo, hi] of one partition. After index_scan, every
+	// index_next returns the item of the next key in order, or NULL once the
+	// range is exhausted. Indexes without key order probe each key of the range.
+	virtual RC 			index_scan(idx_key_t lo, idx_key_t hi,
+							idx_cursor &cursor, int part_id=-1) {
+		cursor.key = lo;
+		cursor.hi = hi;
+		cursor.part_id = part_id;
+		cursor.done = (lo > hi);
+		cursor.node = NULL;
+		return RCOK;
+	};
+
+	virtual RC 			index_next(idx_cursor &cursor, itemid_t * &item) {
+		item = NULL;
+		while (item == NULL && !cursor.done) {
+			if (index_read(cursor.key, item, cursor.part_id, 0) != RCOK)
+				item = NULL;
+			if (cursor.key == cursor.hi)
+				cursor.done = true;
+			else
+				cursor.key ++;
+		}
+		return RCOK;
+	};
+
 	// TODO implement index_remove
 	virtual RC 			index_remove(idx_key_t key) { return RCOK; };
 	
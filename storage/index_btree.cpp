@@ -7,9 +7,6 @@ RC index_btree::init(uint64_t part_cnt) {
 	order = BTREE_ORDER;
 	// these pointers can be mapped anywhere. They won't be changed
 	roots = (bt_node **) malloc(part_cnt * sizeof(bt_node *));
-	// "cur_xxx_per_thd" is only for SCAN queries.
-	ARR_PTR(bt_node *, cur_leaf_per_thd, g_thread_cnt);
-	ARR_PTR(UInt32, cur_idx_per_thd, g_thread_cnt);
 	// the index tree of each partition musted be mapped to corresponding l2 slices
 	for (UInt32 part_id = 0; part_id < part_cnt; part_id ++) {
 		RC rc;
@@ -46,25 +43,55 @@ bool index_btree::index_exist(idx_key_t key) {
 	return false;
 }
 
-RC index_btree::index_next(uint64_t thd_id, itemid_t * &item, bool samekey) {
-	int idx = *cur_idx_per_thd[thd_id];
-	bt_node * leaf = *cur_leaf_per_thd[thd_id];
-	idx_key_t cur_key = leaf->keys[idx] ;
-	
-	*cur_idx_per_thd[thd_id] += 1;
-	if (*cur_idx_per_thd[thd_id] >= leaf->num_keys) {
-		leaf = leaf->next;
-		*cur_leaf_per_thd[thd_id] = leaf;
-		*cur_idx_per_thd[thd_id] = 0;
-	}
-	if (leaf == NULL)
-		item = NULL;
-	else {
-		assert( leaf->is_leaf );
-		if ( samekey && leaf->keys[ *cur_idx_per_thd[thd_id] ] != cur_key)
-			item = NULL;
-		else 
-			item = (itemid_t *) leaf->pointers[ *cur_idx_per_thd[thd_id] ];
+RC index_btree::index_scan(idx_key_t lo, idx_key_t hi, idx_cursor &cursor, int part_id) {
+	glob_param params;
+	assert(part_id != -1);
+	params.part_id = part_id;
+	bt_node * leaf;
+	if (find_leaf(params, lo, INDEX_READ, leaf) != RCOK)
+		return Abort;
+	UInt32 i = 0;
+	while (i < leaf->num_keys && leaf->keys[i] < lo)
+		i++;
+	release_latch(leaf);
+	cursor.key = lo;
+	cursor.hi = hi;
+	cursor.part_id = part_id;
+	cursor.done = (lo > hi);
+	cursor.node = leaf;
+	cursor.pos = i;
+	return RCOK;
+}
+
+RC index_btree::index_next(idx_cursor &cursor, itemid_t * &item) {
+	item = NULL;
+	bt_node * leaf = (bt_node *) cursor.node;
+	while (!cursor.done) {
+		while (!latch_node(leaf, LATCH_SH))
+			PAUSE
+		if (cursor.pos >= leaf->num_keys) {
+			bt_node * next = leaf->next;
+			release_latch(leaf);
+			if (next == NULL)
+				cursor.done = true;
+			leaf = next;
+			cursor.node = leaf;
+			cursor.pos = 0;
+			continue;
+		}
+		idx_key_t key = leaf->keys[cursor.pos];
+		if (key > cursor.hi)
+			cursor.done = true;
+		else {
+			item = (itemid_t *) leaf->pointers[cursor.pos];
+			cursor.pos ++;
+			if (key == cursor.hi)
+				cursor.done = true;
+			else
+				cursor.key = key + 1;
+		}
+		release_latch(leaf);
+		break;
 	}
 	return RCOK;
 }
@@ -79,11 +106,11 @@ index_btree::index_read(idx_key_t key,
 	itemid_t *& item, 
 	int part_id) {
 	
-	return index_read(key, item, 0, part_id);
+	return index_read(key, item, part_id, 0);
 }
 
 RC index_btree::index_read(idx_key_t key, itemid_t *& item, 
-	uint64_t thd_id, int64_t part_id) 
+	int part_id, int thd_id) 
 {
 	RC rc = Abort;
 	glob_param params;
@@ -97,8 +124,6 @@ RC index_btree::index_read(idx_key_t key, itemid_t *& item,
 		if (leaf->keys[i] == key) {
 			item = (itemid_t *)leaf->pointers[i];
 			release_latch(leaf);
-			(*cur_leaf_per_thd[thd_id]) = leaf;
-			*cur_idx_per_thd[thd_id] = i;
 			return RCOK;
 		}
 	// release the latch after reading the node
@@ -31,10 +31,12 @@ public:
 	bool 		index_exist(idx_key_t key); // check if the key exist. 
 	RC 			index_insert(idx_key_t key, itemid_t * item, int part_id = -1);
 	RC	 		index_read(idx_key_t key, itemid_t * &item, 
-					uint64_t thd_id, int64_t part_id = -1);
+					int part_id, int thd_id);
 	RC	 		index_read(idx_key_t key, itemid_t * &item, int part_id = -1);
 	RC	 		index_read(idx_key_t key, itemid_t * &item);
-	RC 			index_next(uint64_t thd_id, itemid_t * &item, bool samekey = false);
+	// walks the leaf chain from the first key not smaller than lo
+	RC 			index_scan(idx_key_t lo, idx_key_t hi, idx_cursor &cursor, int part_id = -1);
+	RC 			index_next(idx_cursor &cursor, itemid_t * &item);
 
 private:
 	// index structures may have part_cnt = 1 or PART_CNT.
@@ -65,10 +67,6 @@ private:
 	RC		 	upgrade_latch(bt_node * node);
 	// clean up all the LATCH_EX up tp last_ex
 	RC 			cleanup(bt_node * node, bt_node * last_ex);
-
-	// the leaf and the idx within the leaf that the thread last accessed.
-	bt_node *** cur_leaf_per_thd;
-	UInt32 ** 		cur_idx_per_thd;
 };
 
 #endif
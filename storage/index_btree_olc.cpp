@@ -0,0 +1,353 @@
+#include "mem_alloc.h"
+#include "index_btree_olc.h"
+
+RC index_btree_olc::init(uint64_t part_cnt) {
+	this->part_cnt = part_cnt;
+	roots = (olc_node * volatile *) _mm_malloc(part_cnt * sizeof(olc_node *), 64);
+	for (UInt32 part_id = 0; part_id < part_cnt; part_id ++)
+		roots[part_id] = make_leaf(part_id);
+	return RCOK;
+}
+
+RC index_btree_olc::init(uint64_t part_cnt, table_t * table) {
+	this->table = table;
+	init(part_cnt);
+	return RCOK;
+}
+
+olc_leaf * index_btree_olc::make_leaf(uint64_t part_id) {
+	olc_leaf * leaf = (olc_leaf *) mem_allocator.alloc(sizeof(olc_leaf), part_id);
+	assert(leaf != NULL);
+	leaf->version = 0;
+	leaf->is_leaf = true;
+	leaf->num_keys = 0;
+	leaf->next = NULL;
+	return leaf;
+}
+
+olc_inner * index_btree_olc::make_inner(uint64_t part_id) {
+	olc_inner * inner = (olc_inner *) mem_allocator.alloc(sizeof(olc_inner), part_id);
+	assert(inner != NULL);
+	inner->version = 0;
+	inner->is_leaf = false;
+	inner->num_keys = 0;
+	return inner;
+}
+
+/************** version lock ******************/
+
+uint64_t index_btree_olc::read_lock(olc_node * node, bool &restart) {
+	uint64_t version = node->version;
+	COMPILER_BARRIER
+	if (version & OLC_LOCK_BIT) {
+		PAUSE
+		restart = true;
+	}
+	return version;
+}
+
+void index_btree_olc::check(olc_node * node, uint64_t version, bool &restart) {
+	COMPILER_BARRIER
+	if (node->version != version)
+		restart = true;
+}
+
+void index_btree_olc::upgrade_lock(olc_node * node, uint64_t version, bool &restart) {
+	if (!ATOM_CAS(node->version, version, version + OLC_LOCK_BIT))
+		restart = true;
+}
+
+// clears the lock bit and bumps the version at the same time
+void index_btree_olc::write_unlock(olc_node * node) {
+	ATOM_ADD(node->version, OLC_LOCK_BIT);
+}
+
+/************** operations ******************/
+
+UInt32 index_btree_olc::lower_bound(olc_node * node, idx_key_t key) {
+	// num_keys may be torn by a concurrent writer. The caller checks the
+	// version before it uses the result.
+	UInt32 lo = 0;
+	UInt32 hi = node->num_keys;
+	if (hi > OLC_NODE_KEYS)
+		hi = OLC_NODE_KEYS;
+	while (lo < hi) {
+		UInt32 mid = (lo + hi) / 2;
+		if (node->keys[mid] < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+bool index_btree_olc::index_exist(idx_key_t key) {
+	itemid_t * item;
+	for (UInt32 part_id = 0; part_id < part_cnt; part_id ++)
+		if (lookup(key, item, part_id) == RCOK)
+			return true;
+	return false;
+}
+
+RC index_btree_olc::index_read(idx_key_t key, itemid_t *& item, int part_id) {
+	assert(part_id != -1);
+	return lookup(key, item, part_id);
+}
+
+RC index_btree_olc::index_read(idx_key_t key, itemid_t *& item,
+	int part_id, int thd_id)
+{
+	assert(part_id != -1);
+	return lookup(key, item, part_id);
+}
+
+olc_leaf * index_btree_olc::find_leaf(idx_key_t key, uint64_t part_id, uint64_t &version) {
+	assert(part_id < part_cnt);
+retry:
+	bool restart = false;
+	olc_node * node = roots[part_id];
+	version = read_lock(node, restart);
+	if (restart || node != roots[part_id])
+		goto retry;
+	while (!node->is_leaf) {
+		olc_inner * inner = (olc_inner *) node;
+		olc_node * child = inner->children[lower_bound(inner, key)];
+		check(inner, version, restart);
+		if (restart) goto retry;
+		node = child;
+		version = read_lock(node, restart);
+		if (restart) goto retry;
+	}
+	return (olc_leaf *) node;
+}
+
+RC index_btree_olc::lookup(idx_key_t key, itemid_t *& item, uint64_t part_id) {
+	itemid_t * found;
+	bool restart;
+	do {
+		restart = false;
+		uint64_t version;
+		olc_leaf * leaf = find_leaf(key, part_id, version);
+		UInt32 pos = lower_bound(leaf, key);
+		found = NULL;
+		if (pos < leaf->num_keys && leaf->keys[pos] == key)
+			found = leaf->items[pos];
+		check(leaf, version, restart);
+	} while (restart);
+	item = found;
+	return (found == NULL)? ERROR : RCOK;
+}
+
+RC index_btree_olc::index_scan(idx_key_t lo, idx_key_t hi, idx_cursor &cursor, int part_id) {
+	assert(part_id != -1 && (uint64_t)part_id < part_cnt);
+	cursor.key = lo;
+	cursor.hi = hi;
+	cursor.part_id = part_id;
+	cursor.done = (lo > hi);
+	cursor.node = NULL; // the first index_next descends the tree
+	return RCOK;
+}
+
+RC index_btree_olc::index_next(idx_cursor &cursor, itemid_t *& item) {
+	item = NULL;
+	while (!cursor.done) {
+		bool restart = false;
+		if (cursor.node == NULL) {
+			olc_leaf * leaf = find_leaf(cursor.key, cursor.part_id, cursor.version);
+			cursor.pos = lower_bound(leaf, cursor.key);
+			check(leaf, cursor.version, restart);
+			if (restart) continue;
+			cursor.node = leaf;
+		}
+		olc_leaf * leaf = (olc_leaf *) cursor.node;
+		if (cursor.pos >= leaf->num_keys) {
+			olc_leaf * next = leaf->next;
+			check(leaf, cursor.version, restart);
+			if (restart) {
+				cursor.node = NULL;
+				continue;
+			}
+			if (next == NULL) {
+				cursor.done = true;
+				break;
+			}
+			cursor.version = read_lock(next, restart);
+			cursor.node = restart? NULL : next;
+			cursor.pos = 0;
+			continue;
+		}
+		idx_key_t key = leaf->keys[cursor.pos];
+		itemid_t * found = leaf->items[cursor.pos];
+		check(leaf, cursor.version, restart);
+		if (restart) {
+			cursor.node = NULL;
+			continue;
+		}
+		if (key > cursor.hi) {
+			cursor.done = true;
+			break;
+		}
+		cursor.pos ++;
+		if (key == cursor.hi)
+			cursor.done = true;
+		else
+			cursor.key = key + 1;
+		item = found;
+		break;
+	}
+	return RCOK;
+}
+
+RC index_btree_olc::index_insert(idx_key_t key, itemid_t * item, int part_id) {
+	assert(part_id != -1 && (uint64_t)part_id < part_cnt);
+retry:
+	bool restart = false;
+	olc_node * node = roots[part_id];
+	uint64_t version = read_lock(node, restart);
+	if (restart || node != roots[part_id])
+		goto retry;
+	olc_inner * parent = NULL;
+	uint64_t parent_version = 0;
+
+	while (!node->is_leaf) {
+		olc_inner * inner = (olc_inner *) node;
+		// split full inner nodes on the way down, so the parent always has room.
+		if (inner->num_keys == OLC_NODE_KEYS) {
+			if (parent != NULL) {
+				upgrade_lock(parent, parent_version, restart);
+				if (restart) goto retry;
+			}
+			upgrade_lock(inner, version, restart);
+			if (restart) {
+				if (parent != NULL) write_unlock(parent);
+				goto retry;
+			}
+			if (parent == NULL && node != roots[part_id]) {
+				write_unlock(inner);
+				goto retry;
+			}
+			idx_key_t sep;
+			olc_inner * right = split_inner(part_id, inner, sep);
+			if (parent != NULL)
+				insert_inner(parent, sep, right);
+			else
+				make_root(part_id, sep, inner, right);
+			write_unlock(inner);
+			if (parent != NULL) write_unlock(parent);
+			goto retry;
+		}
+		if (parent != NULL) {
+			check(parent, parent_version, restart);
+			if (restart) goto retry;
+		}
+		parent = inner;
+		parent_version = version;
+		node = inner->children[lower_bound(inner, key)];
+		check(inner, version, restart);
+		if (restart) goto retry;
+		version = read_lock(node, restart);
+		if (restart) goto retry;
+	}
+
+	olc_leaf * leaf = (olc_leaf *) node;
+	UInt32 pos = lower_bound(leaf, key);
+	bool exist = (pos < leaf->num_keys && leaf->keys[pos] == key);
+	if (!exist && leaf->num_keys == OLC_NODE_KEYS) {
+		if (parent != NULL) {
+			upgrade_lock(parent, parent_version, restart);
+			if (restart) goto retry;
+		}
+		upgrade_lock(leaf, version, restart);
+		if (restart) {
+			if (parent != NULL) write_unlock(parent);
+			goto retry;
+		}
+		if (parent == NULL && node != roots[part_id]) {
+			write_unlock(leaf);
+			goto retry;
+		}
+		idx_key_t sep;
+		olc_leaf * right = split_leaf(part_id, leaf, sep);
+		if (parent != NULL)
+			insert_inner(parent, sep, right);
+		else
+			make_root(part_id, sep, leaf, right);
+		write_unlock(leaf);
+		if (parent != NULL) write_unlock(parent);
+		goto retry;
+	}
+	upgrade_lock(leaf, version, restart);
+	if (restart) goto retry;
+	if (parent != NULL) {
+		check(parent, parent_version, restart);
+		if (restart) {
+			write_unlock(leaf);
+			goto retry;
+		}
+	}
+	if (exist) {
+		item->next = leaf->items[pos];
+		leaf->items[pos] = item;
+	} else {
+		for (UInt32 i = leaf->num_keys; i > pos; i--) {
+			leaf->keys[i] = leaf->keys[i - 1];
+			leaf->items[i] = leaf->items[i - 1];
+		}
+		leaf->keys[pos] = key;
+		leaf->items[pos] = item;
+		item->next = NULL;
+		leaf->num_keys ++;
+	}
+	write_unlock(leaf);
+	return RCOK;
+}
+
+// The left node keeps the smaller half. `sep` is its largest key.
+olc_leaf * index_btree_olc::split_leaf(uint64_t part_id, olc_leaf * leaf, idx_key_t &sep) {
+	olc_leaf * right = make_leaf(part_id);
+	UInt32 left_cnt = leaf->num_keys - leaf->num_keys / 2;
+	right->num_keys = leaf->num_keys - left_cnt;
+	memcpy(right->keys, leaf->keys + left_cnt, sizeof(idx_key_t) * right->num_keys);
+	memcpy(right->items, leaf->items + left_cnt, sizeof(itemid_t *) * right->num_keys);
+	right->next = leaf->next;
+	leaf->num_keys = left_cnt;
+	sep = leaf->keys[left_cnt - 1];
+	COMPILER_BARRIER
+	leaf->next = right;
+	return right;
+}
+
+// The middle key moves up to the parent.
+olc_inner * index_btree_olc::split_inner(uint64_t part_id, olc_inner * inner, idx_key_t &sep) {
+	olc_inner * right = make_inner(part_id);
+	UInt32 left_cnt = inner->num_keys / 2;
+	right->num_keys = inner->num_keys - left_cnt - 1;
+	memcpy(right->keys, inner->keys + left_cnt + 1, sizeof(idx_key_t) * right->num_keys);
+	memcpy(right->children, inner->children + left_cnt + 1, sizeof(olc_node *) * (right->num_keys + 1));
+	sep = inner->keys[left_cnt];
+	inner->num_keys = left_cnt;
+	return right;
+}
+
+// `child` holds the keys larger than `key`. The caller holds the lock.
+void index_btree_olc::insert_inner(olc_inner * inner, idx_key_t key, olc_node * child) {
+	assert(inner->num_keys < OLC_NODE_KEYS);
+	UInt32 pos = lower_bound(inner, key);
+	for (UInt32 i = inner->num_keys; i > pos; i--) {
+		inner->keys[i] = inner->keys[i - 1];
+		inner->children[i + 1] = inner->children[i];
+	}
+	inner->keys[pos] = key;
+	inner->children[pos + 1] = child;
+	inner->num_keys ++;
+}
+
+void index_btree_olc::make_root(uint64_t part_id, idx_key_t sep, olc_node * left, olc_node * right) {
+	olc_inner * root = make_inner(part_id);
+	root->num_keys = 1;
+	root->keys[0] = sep;
+	root->children[0] = left;
+	root->children[1] = right;
+	COMPILER_BARRIER
+	roots[part_id] = root;
+}
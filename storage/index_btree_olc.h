@@ -0,0 +1,71 @@
+#pragma once
+
+#include "global.h"
+#include "helper.h"
+#include "index_base.h"
+
+// B+tree with optimistic lock coupling. Every node carries a version word;
+// readers only read it before and after looking at the node and restart on a
+// mismatch, so a lookup never writes shared memory. Writers upgrade to the
+// version lock of the nodes they change. Full nodes are split on the way down.
+// A key is stored once per tree. Items with the same key are chained through
+// itemid_t::next, like the hash indexes.
+
+#define OLC_LOCK_BIT		2UL
+// keys per node. Nodes hold BTREE_ORDER - 1 keys as index_btree does.
+#define OLC_NODE_KEYS		(BTREE_ORDER - 1)
+
+struct olc_node {
+	volatile uint64_t 	version;
+	bool 				is_leaf;
+	UInt32 				num_keys;
+	idx_key_t 			keys[OLC_NODE_KEYS];
+};
+
+struct olc_inner : olc_node {
+	olc_node * 			children[OLC_NODE_KEYS + 1];
+};
+
+struct olc_leaf : olc_node {
+	itemid_t * 			items[OLC_NODE_KEYS];
+	olc_leaf * volatile next;
+};
+
+class index_btree_olc : public index_base {
+public:
+	RC			init(uint64_t part_cnt);
+	RC			init(uint64_t part_cnt, table_t * table);
+	bool 		index_exist(idx_key_t key); // check if the key exist.
+	RC 			index_insert(idx_key_t key, itemid_t * item, int part_id = -1);
+	RC	 		index_read(idx_key_t key, itemid_t * &item, int part_id = -1);
+	RC	 		index_read(idx_key_t key, itemid_t * &item,
+					int part_id, int thd_id);
+	// The cursor remembers the leaf and its version. When the leaf changed
+	// under it, the scan descends again from the first key not returned yet.
+	RC 			index_scan(idx_key_t lo, idx_key_t hi, idx_cursor &cursor, int part_id = -1);
+	RC 			index_next(idx_cursor &cursor, itemid_t * &item);
+
+private:
+	RC 			lookup(idx_key_t key, itemid_t * &item, uint64_t part_id);
+	// returns the leaf that may hold `key` and the version it was read at
+	olc_leaf * 	find_leaf(idx_key_t key, uint64_t part_id, uint64_t &version);
+	olc_leaf * 	make_leaf(uint64_t part_id);
+	olc_inner * make_inner(uint64_t part_id);
+
+	// version lock. A failed call sets `restart`.
+	uint64_t 	read_lock(olc_node * node, bool &restart);
+	void 		check(olc_node * node, uint64_t version, bool &restart);
+	void 		upgrade_lock(olc_node * node, uint64_t version, bool &restart);
+	void 		write_unlock(olc_node * node);
+
+	// first position whose key is not smaller than `key`
+	UInt32 		lower_bound(olc_node * node, idx_key_t key);
+	olc_leaf * 	split_leaf(uint64_t part_id, olc_leaf * leaf, idx_key_t &sep);
+	olc_inner * split_inner(uint64_t part_id, olc_inner * inner, idx_key_t &sep);
+	void 		insert_inner(olc_inner * inner, idx_key_t key, olc_node * child);
+	void 		make_root(uint64_t part_id, idx_key_t sep, olc_node * left, olc_node * right);
+
+	// index structures may have part_cnt = 1 or PART_CNT.
+	uint64_t 	part_cnt;
+	olc_node * volatile * roots; // each partition has a different root
+};
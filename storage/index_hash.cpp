@@ -8,7 +8,7 @@ RC IndexHash::init(uint64_t bucket_cnt, int part_cnt) {
 	_bucket_cnt_per_part = bucket_cnt / part_cnt;
 	_buckets = new BucketHeader * [part_cnt];
 	for (int i = 0; i < part_cnt; i++) {
-		_buckets[i] = (BucketHeader *) _mm_malloc(sizeof(BucketHeader) * _bucket_cnt_per_part, 64);
+		_buckets[i] = (BucketHeader *) mem_allocator.alloc_aligned(sizeof(BucketHeader) * _bucket_cnt_per_part, i);
 		for (uint32_t n = 0; n < _bucket_cnt_per_part; n ++)
 			_buckets[i][n].init();
 	}
@@ -64,6 +64,8 @@ RC IndexHash::index_read(idx_key_t key, itemid_t * &item, int part_id) {
 	cur_bkt->read_item(key, item, table->get_table_name());
 	// 3. release the latch
 //	release_latch(cur_bkt);
+	if (item == NULL)
+		rc = ERROR;
 	return rc;
 
 }
@@ -79,6 +81,8 @@ RC IndexHash::index_read(idx_key_t key, itemid_t * &item,
 	cur_bkt->read_item(key, item, table->get_table_name());
 	// 3. release the latch
 //	release_latch(cur_bkt);
+	if (item == NULL)
+		rc = ERROR;
 	return rc;
 }
 
@@ -128,6 +132,6 @@ void BucketHeader::read_item(idx_key_t key, itemid_t * &item, const char * tname
 			break;
 		cur_node = cur_node->next;
 	}
-	M_ASSERT(cur_node->key == key, "Key does not exist!");
-	item = cur_node->items;
+	// a missing key returns NULL. Range scans probe keys that may not exist.
+	item = (cur_node == NULL)? NULL : cur_node->items;
 }
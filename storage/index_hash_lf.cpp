@@ -0,0 +1,212 @@
+#include "global.h"
+#include "index_hash_lf.h"
+#include "mem_alloc.h"
+#include "table.h"
+
+RC IndexHashLF::init(uint64_t bucket_cnt, int part_cnt) {
+	_part_cnt = part_cnt;
+	uint64_t slot_cnt = bucket_cnt / part_cnt;
+	uint64_t capacity = HASH_MIGRATE_CHUNK;
+	while (capacity < slot_cnt)
+		capacity *= 2;
+	_tables = (HashTableLF * volatile *) _mm_malloc(sizeof(HashTableLF *) * part_cnt, 64);
+	for (int i = 0; i < part_cnt; i++)
+		_tables[i] = new_table(capacity, i);
+	return RCOK;
+}
+
+RC
+IndexHashLF::init(int part_cnt, table_t * table, uint64_t bucket_cnt) {
+	init(bucket_cnt, part_cnt);
+	this->table = table;
+	return RCOK;
+}
+
+HashTableLF *
+IndexHashLF::new_table(uint64_t capacity, int part_id) {
+	HashTableLF * table = (HashTableLF *) mem_allocator.alloc_aligned(sizeof(HashTableLF), part_id);
+	table->capacity = capacity;
+	table->shift = 64;
+	for (uint64_t c = capacity; c > 1; c /= 2)
+		table->shift --;
+	table->slots = (HashSlot *) mem_allocator.alloc_aligned(sizeof(HashSlot) * capacity, part_id);
+	for (uint64_t n = 0; n < capacity; n ++) {
+		table->slots[n].key = HASH_EMPTY_KEY;
+		table->slots[n].items = NULL;
+	}
+	table->next = NULL;
+	table->size = 0;
+	table->migrate_idx = 0;
+	table->migrate_done = 0;
+	return table;
+}
+
+bool IndexHashLF::index_exist(idx_key_t key) {
+	itemid_t * item;
+	for (int i = 0; i < _part_cnt; i++)
+		if (lookup(key, item, i) == RCOK)
+			return true;
+	return false;
+}
+
+RC IndexHashLF::index_insert(idx_key_t key, itemid_t * item, int part_id) {
+	assert(key < HASH_MOVED_KEY);
+	assert(part_id != -1 && part_id < _part_cnt);
+	HashTableLF * table = _tables[part_id];
+	while (true) {
+		// inserts are not allowed into a table that is being moved.
+		if (table->next != NULL) {
+			table = help_resize(part_id, table);
+			continue;
+		}
+		bool new_key = false;
+		if (insert_slot(table, key, item, new_key)) {
+			if (new_key && ATOM_ADD_FETCH(table->size, 1) * 4 > table->capacity * 3)
+				start_resize(part_id, table);
+			return RCOK;
+		}
+	}
+}
+
+RC IndexHashLF::index_read(idx_key_t key, itemid_t * &item, int part_id) {
+	return lookup(key, item, part_id);
+}
+
+RC IndexHashLF::index_read(idx_key_t key, itemid_t * &item,
+						int part_id, int thd_id) {
+	return lookup(key, item, part_id);
+}
+
+RC IndexHashLF::lookup(idx_key_t key, itemid_t * &item, int part_id) {
+	assert(part_id != -1 && part_id < _part_cnt);
+	HashTableLF * table = _tables[part_id];
+	// a list frozen in an old table is still the latest one if the
+	// slot has not shown up in the next table yet.
+	itemid_t * frozen = NULL;
+	while (table != NULL) {
+		bool moved = false;
+		HashSlot * slot = find_slot(table, key, moved);
+		if (slot != NULL) {
+			itemid_t * items = slot->items;
+			if (!is_frozen(items) && items != NULL) {
+				item = items;
+				return RCOK;
+			}
+			if (is_frozen(items))
+				frozen = unfreeze(items);
+		} else if (!moved && frozen == NULL)
+			break;
+		table = table->next;
+	}
+	item = frozen;
+	return (item == NULL)? ERROR : RCOK;
+}
+
+bool
+IndexHashLF::insert_slot(HashTableLF * table, idx_key_t key, itemid_t * item, bool &new_key) {
+	uint64_t mask = table->capacity - 1;
+	uint64_t idx = hash(table, key);
+	for (uint64_t probe = 0; probe < table->capacity; probe ++, idx = (idx + 1) & mask) {
+		HashSlot * slot = &table->slots[idx];
+		idx_key_t cur_key = slot->key;
+		if (cur_key == HASH_EMPTY_KEY) {
+			if (ATOM_CAS(slot->key, HASH_EMPTY_KEY, key)) {
+				cur_key = key;
+				new_key = true;
+			} else
+				cur_key = slot->key;
+		}
+		if (cur_key == HASH_MOVED_KEY)
+			return false;
+		if (cur_key != key)
+			continue;
+		// push the item to the list of this key
+		while (true) {
+			itemid_t * head = slot->items;
+			if (is_frozen(head))
+				return false;
+			item->next = head;
+			if (ATOM_CAS(slot->items, head, item))
+				return true;
+		}
+	}
+	// the table is full. Only possible when the resize is behind.
+	return false;
+}
+
+// Linear probing stops at an empty slot. A moved slot was empty when the
+// resize started, so the key can only be in the next table.
+HashSlot *
+IndexHashLF::find_slot(HashTableLF * table, idx_key_t key, bool &moved) {
+	uint64_t mask = table->capacity - 1;
+	uint64_t idx = hash(table, key);
+	for (uint64_t probe = 0; probe < table->capacity; probe ++, idx = (idx + 1) & mask) {
+		idx_key_t cur_key = table->slots[idx].key;
+		if (cur_key == key)
+			return &table->slots[idx];
+		if (cur_key == HASH_EMPTY_KEY)
+			return NULL;
+		if (cur_key == HASH_MOVED_KEY) {
+			moved = true;
+			return NULL;
+		}
+	}
+	moved = (table->next != NULL);
+	return NULL;
+}
+
+void
+IndexHashLF::start_resize(int part_id, HashTableLF * table) {
+	if (table->next != NULL)
+		return;
+	HashTableLF * next = new_table(table->capacity * 2, part_id);
+	if (!ATOM_CAS(table->next, NULL, next)) {
+		mem_allocator.free_aligned(next->slots);
+		mem_allocator.free_aligned(next);
+	}
+	// the table is moved by the next insert to this partition.
+}
+
+// Every inserter that hits a table being resized moves chunks of slots
+// until all chunks are claimed, then waits for the other movers to finish.
+// The old table is never freed since readers may still be in it.
+HashTableLF *
+IndexHashLF::help_resize(int part_id, HashTableLF * table) {
+	HashTableLF * next = table->next;
+	uint64_t chunk_cnt = table->capacity / HASH_MIGRATE_CHUNK;
+	while (true) {
+		uint64_t chunk = ATOM_FETCH_ADD(table->migrate_idx, 1);
+		if (chunk >= chunk_cnt)
+			break;
+		for (uint64_t n = chunk * HASH_MIGRATE_CHUNK; n < (chunk + 1) * HASH_MIGRATE_CHUNK; n++)
+			migrate_slot(&table->slots[n], next);
+		ATOM_ADD_FETCH(table->migrate_done, 1);
+	}
+	while (table->migrate_done < chunk_cnt)
+		PAUSE
+	ATOM_CAS(_tables[part_id], table, next);
+	return next;
+}
+
+void
+IndexHashLF::migrate_slot(HashSlot * slot, HashTableLF * to) {
+	idx_key_t key = slot->key;
+	if (key == HASH_EMPTY_KEY) {
+		if (ATOM_CAS(slot->key, HASH_EMPTY_KEY, HASH_MOVED_KEY))
+			return;
+		key = slot->key;
+	}
+	// freeze the list so that no one can insert into it anymore.
+	itemid_t * items;
+	do {
+		items = slot->items;
+	} while (!ATOM_CAS(slot->items, items, (itemid_t *)((uint64_t)items | HASH_FROZEN_BIT)));
+	// nobody inserts into the next table before the resize is done,
+	// so the key can not be there yet.
+	uint64_t mask = to->capacity - 1;
+	uint64_t idx = hash(to, key);
+	while (!ATOM_CAS(to->slots[idx].key, HASH_EMPTY_KEY, key))
+		idx = (idx + 1) & mask;
+	to->slots[idx].items = items;
+	ATOM_ADD_FETCH(to->size, 1);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "global.h"
+#include "helper.h"
+#include "index_base.h"
+
+// Open-addressing hash index with linear probing. Readers never write shared
+// memory and inserters only CAS the slot they claim. Each partition owns a
+// table that doubles online when it becomes 3/4 full.
+
+// Reserved keys. Real keys must be smaller than HASH_MOVED_KEY.
+#define HASH_EMPTY_KEY		UINT64_MAX
+#define HASH_MOVED_KEY		(UINT64_MAX - 1)
+// A frozen item list has been copied to the next table and accepts no inserts.
+#define HASH_FROZEN_BIT		1UL
+// Number of slots a thread moves at a time during a resize.
+#define HASH_MIGRATE_CHUNK	1024
+
+// 16 bytes, so four slots share a cache line. Items with the same key are
+// chained through itemid_t::next, the same way IndexHash does it.
+struct HashSlot {
+	volatile idx_key_t 	key;
+	itemid_t * volatile items;
+};
+
+// One generation of the table of a partition. During a resize, `next` points
+// to the larger table and all inserters help move the slots over.
+struct HashTableLF {
+	uint64_t 			capacity;
+	uint64_t 			shift;
+	HashSlot * 			slots;
+	HashTableLF * volatile next;
+	char				pad1[CL_SIZE - 32];
+	volatile uint64_t 	size;
+	char				pad2[CL_SIZE - 8];
+	volatile uint64_t 	migrate_idx; // next chunk to claim
+	volatile uint64_t 	migrate_done; // chunks already moved
+};
+
+class IndexHashLF : public index_base
+{
+public:
+	RC 			init(uint64_t bucket_cnt, int part_cnt);
+	RC 			init(int part_cnt,
+					table_t * table,
+					uint64_t bucket_cnt);
+	bool 		index_exist(idx_key_t key); // check if the key exist.
+	RC 			index_insert(idx_key_t key, itemid_t * item, int part_id=-1);
+	// the following call returns a single item
+	RC	 		index_read(idx_key_t key, itemid_t * &item, int part_id=-1);
+	RC	 		index_read(idx_key_t key, itemid_t * &item,
+							int part_id=-1, int thd_id=0);
+private:
+	RC 			lookup(idx_key_t key, itemid_t * &item, int part_id);
+	HashTableLF * 	new_table(uint64_t capacity, int part_id);
+	// returns false if the key has to go to the next table.
+	bool 		insert_slot(HashTableLF * table, idx_key_t key, itemid_t * item, bool &new_key);
+	HashSlot * 	find_slot(HashTableLF * table, idx_key_t key, bool &moved);
+	void 		start_resize(int part_id, HashTableLF * table);
+	HashTableLF * help_resize(int part_id, HashTableLF * table);
+	void 		migrate_slot(HashSlot * slot, HashTableLF * to);
+
+	// Fibonacci hashing. The top bits index the table.
+	uint64_t 	hash(HashTableLF * table, idx_key_t key) {
+		return (key * 0x9E3779B97F4A7C15UL) >> table->shift;
+	}
+	static bool is_frozen(itemid_t * items) { return ((uint64_t)items & HASH_FROZEN_BIT) != 0; }
+	static itemid_t * unfreeze(itemid_t * items) { return (itemid_t *)((uint64_t)items & ~HASH_FROZEN_BIT); }
+
+	HashTableLF * volatile * 	_tables; // the current table of each partition
+	int 						_part_cnt;
+};
@@ -16,19 +16,24 @@
 #include "manager.h"
 
 RC 
-row_t::init(table_t * host_table, uint64_t part_id, uint64_t row_id) {
+row_t::init(table_t * host_table, uint64_t part_id, uint64_t row_id, char * tuple) {
 	_row_id = row_id;
 	_part_id = part_id;
+	_pax = false;
 	this->table = host_table;
 	Catalog * schema = host_table->get_schema();
 	int tuple_size = schema->get_tuple_size();
-	data = (char *) _mm_malloc(sizeof(char) * tuple_size, 64);
+	if (tuple != NULL)
+		data = tuple;
+	else
+		data = (char *) mem_allocator.alloc_aligned(sizeof(char) * tuple_size, part_id);
 	return RCOK;
 }
 void 
 row_t::init(int size) 
 {
-	data = (char *) _mm_malloc(size, 64);
+	data = (char *) mem_allocator.alloc_aligned(size, 0);
+	_pax = false;
 }
 
 RC 
@@ -37,28 +42,54 @@ row_t::switch_schema(table_t * host_table) {
 	return RCOK;
 }
 
-void row_t::init_manager(row_t * row) {
-#if CC_ALG == DL_DETECT || CC_ALG == NO_WAIT || CC_ALG == WAIT_DIE
-    manager = (Row_lock *) mem_allocator.alloc(sizeof(Row_lock), _part_id);
-#elif CC_ALG == TIMESTAMP
-    manager = (Row_ts *) mem_allocator.alloc(sizeof(Row_ts), _part_id);
-#elif CC_ALG == MVCC
-    manager = (Row_mvcc *) _mm_malloc(sizeof(Row_mvcc), 64);
-#elif CC_ALG == HEKATON
-    manager = (Row_hekaton *) _mm_malloc(sizeof(Row_hekaton), 64);
-#elif CC_ALG == OCC
-    manager = (Row_occ *) mem_allocator.alloc(sizeof(Row_occ), _part_id);
-#elif CC_ALG == TICTOC
-	manager = (Row_tictoc *) _mm_malloc(sizeof(Row_tictoc), 64);
-#elif CC_ALG == SILO
-	manager = (Row_silo *) _mm_malloc(sizeof(Row_silo), 64);
-#elif CC_ALG == VLL
-    manager = (Row_vll *) mem_allocator.alloc(sizeof(Row_vll), _part_id);
-#endif
+// the manager follows the row_t and the tuple follows the manager
+static uint64_t get_manager_offset() {
+	return (sizeof(row_t) + 7) & ~7UL;
+}
+
+template<int ALG>
+static uint64_t get_manager_size() {
+	if constexpr (ALG == HSTORE)
+		return 0;
+	else 
+		return sizeof(typename cc_policy<ALG>::Manager);
+}
+
+static uint64_t get_data_offset() {
+	uint64_t size = 0;
+	switch (g_cc_alg) {
+#define MANAGER_SIZE(alg) 	case alg: size = get_manager_size<alg>(); break;
+	CC_EACH(MANAGER_SIZE)
+	default: assert(false);
+	}
+	return (get_manager_offset() + size + 7) & ~7UL;
+}
+
+template<int ALG>
+static void init_manager(row_t * row) {
+	if constexpr (ALG != HSTORE)
+		row->get_manager<ALG>()->init(row);
+}
 
-#if CC_ALG != HSTORE
-	manager->init(this);
-#endif
+uint64_t row_t::get_block_size(uint64_t tuple_size, bool with_tuple) {
+	uint64_t size = get_data_offset();
+	if (with_tuple)
+		size += tuple_size;
+	return (size + CL_SIZE - 1) & ~(CL_SIZE - 1);
+}
+
+RC 
+row_t::init_block(table_t * host_table, uint64_t part_id, uint64_t row_id, char * tuple) {
+	RC rc = init(host_table, part_id, row_id, tuple != NULL? tuple : (char *)this + get_data_offset());
+	_pax = host_table->get_schema()->pax;
+	_hole = false;
+	manager = (char *)this + get_manager_offset();
+	switch (g_cc_alg) {
+#define INIT_MANAGER(alg) 	case alg: init_manager<alg>(this); break;
+	CC_EACH(INIT_MANAGER)
+	default: assert(false);
+	}
+	return rc;
 }
 
 table_t * row_t::get_table() { 
@@ -82,13 +113,11 @@ uint64_t row_t::get_field_cnt() {
 // Set a specified field to a certain value (set value, not reference)
 void row_t::set_value(int id, void * ptr) {
 	int datasize = get_schema()->get_field_size(id);
-	int pos = get_schema()->get_field_index(id);
-	memcpy( &data[pos], ptr, datasize);
+	memcpy( get_value(id), ptr, datasize);
 }
 
 void row_t::set_value(int id, void * ptr, int size) {
-	int pos = get_schema()->get_field_index(id);
-	memcpy( &data[pos], ptr, size);
+	memcpy( get_value(id), ptr, size);
 }
 
 void row_t::set_value(const char * col_name, void * ptr) {
@@ -109,155 +138,204 @@ GET_VALUE(UInt32);
 GET_VALUE(SInt32);
 
 char * row_t::get_value(int id) {
+	if (_pax)
+		return &data[get_schema()->get_pax_offset(id, _row_id & (PAX_PAGE_ROWS - 1))];
 	int pos = get_schema()->get_field_index(id);
 	return &data[pos];
 }
 
 char * row_t::get_value(char * col_name) {
-	uint64_t pos = get_schema()->get_field_index(col_name);
-	return &data[pos];
+	return get_value(get_schema()->get_field_id(col_name));
 }
 
-char * row_t::get_data() { return data; }
+char * row_t::get_data() { 
+	assert(!_pax);
+	return data; 
+}
 
 void row_t::set_data(char * data, uint64_t size) { 
-	memcpy(this->data, data, size);
+	if (!_pax) {
+		memcpy(this->data, data, size);
+		return;
+	}
+	Catalog * schema = get_schema();
+	assert(size == schema->get_tuple_size());
+	for (UInt32 i = 0; i < schema->field_cnt; i++)
+		memcpy(get_value(i), &data[schema->get_field_index(i)], schema->get_field_size(i));
+}
+
+char * row_t::get_tuple(char * buf) {
+	if (!_pax)
+		return data;
+	Catalog * schema = get_schema();
+	for (UInt32 i = 0; i < schema->field_cnt; i++)
+		memcpy(&buf[schema->get_field_index(i)], get_value(i), schema->get_field_size(i));
+	return buf;
 }
 // copy from the src to this
+// A fresh version may not know its table yet, so only `src` is asked.
 void row_t::copy(row_t * src) {
-	set_data(src->get_data(), src->get_tuple_size());
+	if (!src->_pax)
+		set_data(src->data, src->get_tuple_size());
+	else if (!_pax)
+		src->get_tuple(data);
+	else {
+		Catalog * schema = src->get_schema();
+		for (UInt32 i = 0; i < schema->field_cnt; i++)
+			memcpy(get_value(i), src->get_value(i), schema->get_field_size(i));
+	}
 }
-// Allocated by stdlib
+
+void row_t::copy(row_t * src, uint64_t cols) {
+	if (cols == ALL_COLS) {
+		copy(src);
+		return;
+	}
+	Catalog * schema = src->get_schema();
+	assert(schema->field_cnt <= 64);
+	for (; cols != 0; cols &= cols - 1) {
+		UInt32 i = __builtin_ctzll(cols);
+		memcpy(get_value(i), src->get_value(i), schema->get_field_size(i));
+	}
+}
+// Allocated by mem_alloc::alloc_aligned
 void row_t::free_row() {
-	free(data);
+	mem_allocator.free_aligned(data);
 }
 
+template<int ALG>
 RC row_t::get_row(access_t type, txn_man * txn, row_t *& row) {
 	RC rc = RCOK;
-#if CC_ALG == WAIT_DIE || CC_ALG == NO_WAIT || CC_ALG == DL_DETECT
-	uint64_t thd_id = txn->get_thd_id();
-	lock_t lt = (type == RD || type == SCAN)? LOCK_SH : LOCK_EX;
-#if CC_ALG == DL_DETECT
-	uint64_t * txnids;
-	int txncnt; 
-	rc = this->manager->lock_get(lt, txn, txnids, txncnt);	
-#else
-	rc = this->manager->lock_get(lt, txn);
-#endif
+	if constexpr (ALG == WAIT_DIE || ALG == NO_WAIT || ALG == DL_DETECT) {
+		uint64_t thd_id = txn->get_thd_id();
+		lock_t lt = (type == RD || type == SCAN)? LOCK_SH : LOCK_EX;
+		uint64_t * txnids = NULL;
+		int txncnt = 0;
+		rc = get_manager<ALG>()->template lock_get<ALG>(lt, txn, txnids, txncnt);
 
-	if (rc == RCOK) {
-		row = this;
-	} else if (rc == Abort) {} 
-	else if (rc == WAIT) {
-		ASSERT(CC_ALG == WAIT_DIE || CC_ALG == DL_DETECT);
-		uint64_t starttime = get_sys_clock();
-#if CC_ALG == DL_DETECT	
-		bool dep_added = false;
-#endif
-		uint64_t endtime;
-		txn->lock_abort = false;
-		INC_STATS(txn->get_thd_id(), wait_cnt, 1);
-		while (!txn->lock_ready && !txn->lock_abort) 
-		{
-#if CC_ALG == WAIT_DIE 
-			continue;
-#elif CC_ALG == DL_DETECT	
-			uint64_t last_detect = starttime;
-			uint64_t last_try = starttime;
+		if (rc == RCOK) {
+			row = this;
+		} else if (rc == Abort) {} 
+		else if (rc == WAIT) {
+			ASSERT(ALG == WAIT_DIE || ALG == DL_DETECT);
+			uint64_t starttime = get_sys_clock();
+			bool dep_added = false;
+			uint64_t endtime;
+			txn->lock_abort = false;
+			INC_STATS(txn->get_thd_id(), wait_cnt, 1);
+			while (!txn->lock_ready && !txn->lock_abort) 
+			{
+				if constexpr (ALG == WAIT_DIE) 
+					continue;
+				else {
+					uint64_t last_detect = starttime;
+					uint64_t last_try = starttime;
 
-			uint64_t now = get_sys_clock();
-			if (now - starttime > g_timeout ) {
-				txn->lock_abort = true;
-				break;
-			}
-			if (g_no_dl) {
-				PAUSE
-				continue;
-			}
-			int ok = 0;
-			if ((now - last_detect > g_dl_loop_detect) && (now - last_try > DL_LOOP_TRIAL)) {
-				if (!dep_added) {
-					ok = dl_detector.add_dep(txn->get_txn_id(), txnids, txncnt, txn->row_cnt);
-					if (ok == 0)
-						dep_added = true;
-					else if (ok == 16)
-						last_try = now;
-				}
-				if (dep_added) {
-					ok = dl_detector.detect_cycle(txn->get_txn_id());
-					if (ok == 16)  // failed to lock the deadlock detector
-						last_try = now;
-					else if (ok == 0) 
-						last_detect = now;
-					else if (ok == 1) {
-						last_detect = now;
+					uint64_t now = get_sys_clock();
+					if (now - starttime > g_timeout ) {
+						txn->set_abort(ABORT_TIMEOUT, this);
+						txn->lock_abort = true;
+						break;
+					}
+					if (g_no_dl) {
+						PAUSE
+						continue;
+					}
+					if (g_dl_detect_thread) {
+						// the detector thread looks for cycles
+						if (!dep_added) {
+							dl_detector.add_dep(txn->get_txn_id(), txnids, txncnt, txn->row_cnt);
+							dep_added = true;
+						}
+						PAUSE
+						continue;
 					}
+					int ok = 0;
+					if ((now - last_detect > g_dl_loop_detect) && (now - last_try > DL_LOOP_TRIAL)) {
+						if (!dep_added) {
+							ok = dl_detector.add_dep(txn->get_txn_id(), txnids, txncnt, txn->row_cnt);
+							if (ok == 0)
+								dep_added = true;
+							else if (ok == 16)
+								last_try = now;
+						}
+						if (dep_added) {
+							ok = dl_detector.detect_cycle(txn->get_txn_id());
+							if (ok == 16)  // failed to lock the deadlock detector
+								last_try = now;
+							else if (ok == 0) 
+								last_detect = now;
+							else if (ok == 1) {
+								last_detect = now;
+							}
+						}
+					} else 
+						PAUSE
 				}
-			} else 
-				PAUSE
-#endif
+			}
+			// the txn does not wait for anyone any more
+			if (ALG == DL_DETECT && g_dl_detect_thread && dep_added)
+				dl_detector.clear_dep(txn->get_txn_id());
+			if (txn->lock_ready) 
+				rc = RCOK;
+			else if (txn->lock_abort) { 
+				rc = Abort;
+				return_row<ALG>(type, txn, NULL);
+			}
+			endtime = get_sys_clock();
+			INC_TMP_STATS(thd_id, time_wait, endtime - starttime);
+			row = this;
 		}
-		if (txn->lock_ready) 
-			rc = RCOK;
-		else if (txn->lock_abort) { 
-			rc = Abort;
-			return_row(type, txn, NULL);
+		return rc;
+	} else if constexpr (ALG == TIMESTAMP || ALG == MVCC || ALG == HEKATON) {
+		uint64_t thd_id = txn->get_thd_id();
+		// For TIMESTAMP RD, a new copy of the row will be returned (to guarantee repeatable read).
+		// for MVCC RD, the version will be returned instead of a copy
+		// So for MVCC RD-WR, the version should be explicitly copied.
+		//row_t * newr = NULL;
+		if constexpr (ALG == TIMESTAMP) {
+			// TODO. should not call malloc for each row read. Only need to call malloc once 
+			// before simulation starts, like TicToc and Silo.
+			txn->cur_row = (row_t *) mem_allocator.alloc(sizeof(row_t), this->get_part_id());
+			txn->cur_row->init(get_table(), this->get_part_id());
 		}
-		endtime = get_sys_clock();
-		INC_TMP_STATS(thd_id, time_wait, endtime - starttime);
-		row = this;
-	}
-	return rc;
-#elif CC_ALG == TIMESTAMP || CC_ALG == MVCC || CC_ALG == HEKATON 
-	uint64_t thd_id = txn->get_thd_id();
-	// For TIMESTAMP RD, a new copy of the row will be returned (to guarantee repeatable read).
-	// for MVCC RD, the version will be returned instead of a copy
-	// So for MVCC RD-WR, the version should be explicitly copied.
-	//row_t * newr = NULL;
-  #if CC_ALG == TIMESTAMP
-	// TODO. should not call malloc for each row read. Only need to call malloc once 
-	// before simulation starts, like TicToc and Silo.
-	txn->cur_row = (row_t *) mem_allocator.alloc(sizeof(row_t), this->get_part_id());
-	txn->cur_row->init(get_table(), this->get_part_id());
-  #endif
 
-	// TODO need to initialize the table/catalog information.
-	TsType ts_type = (type == RD)? R_REQ : P_REQ; 
-	rc = this->manager->access(txn, ts_type, row);
-	if (rc == RCOK ) {
+		// TODO need to initialize the table/catalog information.
+		TsType ts_type = (type == RD)? R_REQ : P_REQ; 
+		rc = get_manager<ALG>()->access(txn, ts_type, row);
+		if (rc == RCOK ) {
+			row = txn->cur_row;
+		} else if (rc == WAIT) { // I'm a reader waiting for writers
+			uint64_t t1 = get_sys_clock();
+			while (!txn->ts_ready) // Wait until I'm ready
+				PAUSE
+			uint64_t t2 = get_sys_clock();
+			INC_TMP_STATS(thd_id, time_wait, t2 - t1);
+			row = txn->cur_row; // When I'm ready, I get that access and should be same as OK
+		}
+		if (rc != Abort) {
+			row->table = get_table();
+			assert(row->get_schema() == this->get_schema());
+		}
+		return rc;
+	} else if constexpr (ALG == OCC) {
+		// OCC always make a local copy regardless of read or write
+		txn->cur_row = (row_t *) mem_allocator.alloc(sizeof(row_t), get_part_id());
+		txn->cur_row->init(get_table(), get_part_id());
+		rc = get_manager<ALG>()->access(txn, R_REQ);
 		row = txn->cur_row;
-	} else if (rc == WAIT) { // I'm a reader waiting for writers
-		uint64_t t1 = get_sys_clock();
-		while (!txn->ts_ready) // Wait until I'm ready
-			PAUSE
-		uint64_t t2 = get_sys_clock();
-		INC_TMP_STATS(thd_id, time_wait, t2 - t1);
-		row = txn->cur_row; // When I'm ready, I get that access and should be same as OK
-	}
-	if (rc != Abort) {
+		return rc;
+	} else if constexpr (ALG == TICTOC || ALG == SILO) {
+		// like OCC, tictoc also makes a local copy for each read/write
 		row->table = get_table();
-		assert(row->get_schema() == this->get_schema());
+		TsType ts_type = (type == RD)? R_REQ : P_REQ; 
+		rc = get_manager<ALG>()->access(txn, ts_type, row);
+		return rc;
+	} else {
+		// HSTORE, VLL
+		row = this;
+		return rc;
 	}
-	return rc;
-#elif CC_ALG == OCC
-	// OCC always make a local copy regardless of read or write
-	txn->cur_row = (row_t *) mem_allocator.alloc(sizeof(row_t), get_part_id());
-	txn->cur_row->init(get_table(), get_part_id());
-	rc = this->manager->access(txn, R_REQ);
-	row = txn->cur_row;
-	return rc;
-#elif CC_ALG == TICTOC || CC_ALG == SILO
-	// like OCC, tictoc also makes a local copy for each read/write
-	row->table = get_table();
-	TsType ts_type = (type == RD)? R_REQ : P_REQ; 
-	rc = this->manager->access(txn, ts_type, row);
-	return rc;
-#elif CC_ALG == HSTORE || CC_ALG == VLL
-	row = this;
-	return rc;
-#else
-	assert(false);
-#endif
 }
 // Free `row`. If WR succeeded, write content in `row` to `this`.
 // Note that failed WR will become XP
@@ -268,47 +346,49 @@ RC row_t::get_row(access_t type, txn_man * txn, row_t *& row) {
 // delete during history cleanup.
 // For TIMESTAMP, the row will be explicity deleted at the end of access().
 // (cf. row_ts.cpp)
+template<int ALG>
 void row_t::return_row(access_t type, txn_man * txn, row_t * row) {	
-#if CC_ALG == WAIT_DIE || CC_ALG == NO_WAIT || CC_ALG == DL_DETECT
-	assert (row == NULL || row == this || type == XP);
-	if (ROLL_BACK && type == XP) {// recover from previous writes.
-		this->copy(row);
-	}
-	this->manager->lock_release(txn);
-#elif CC_ALG == TIMESTAMP || CC_ALG == MVCC 
-	// for RD or SCAN or XP, the row should be deleted.
-	// because all WR should be companied by a RD
-	// for MVCC RD, the row is not copied, so no need to free. 
-  #if CC_ALG == TIMESTAMP
-	if (type == RD || type == SCAN) { // Since we hold a copy for RD
-		row->free_row();
-		mem_allocator.free(row, sizeof(row_t));
-	}
-  #endif
-	if (type == XP) {
-		this->manager->access(txn, XP_REQ, row);
-	} else if (type == WR) {
-		assert (type == WR && row != NULL);
-		assert (row->get_schema() == this->get_schema());
-		// This is a true write, write commit
-		// For MVCC, interleaving commit might not be a problem since we only allow one prewriter thus interleaving txn will not write a same row
-		RC rc = this->manager->access(txn, W_REQ, row);
-		assert(rc == RCOK);
-	}
-#elif CC_ALG == OCC
-	assert (row != NULL);
-	if (type == WR) // Failed WR should be XP, thus will not be committed
-		manager->write( row, txn->end_ts ); // Note that `this` original row is already locked while `row` is the new row
-	row->free_row(); // Free data buffer
-	mem_allocator.free(row, sizeof(row_t)); // Free meta data
-	return;
-#elif CC_ALG == TICTOC || CC_ALG == SILO
-	assert (row != NULL);
-	return;
-#elif CC_ALG == HSTORE || CC_ALG == VLL
-	return;
-#else 
-	assert(false);
-#endif
+	if constexpr (ALG == WAIT_DIE || ALG == NO_WAIT || ALG == DL_DETECT) {
+		assert (row == NULL || row == this || type == XP);
+		if (ROLL_BACK && type == XP) {// recover from previous writes.
+			this->copy(row);
+		}
+		get_manager<ALG>()->template lock_release<ALG>(txn);
+	} else if constexpr (ALG == TIMESTAMP || ALG == MVCC) {
+		// for RD or SCAN or XP, the row should be deleted.
+		// because all WR should be companied by a RD
+		// for MVCC RD, the row is not copied, so no need to free. 
+		if constexpr (ALG == TIMESTAMP) {
+			if (type == RD || type == SCAN) { // Since we hold a copy for RD
+				row->free_row();
+				mem_allocator.free(row, sizeof(row_t));
+			}
+		}
+		if (type == XP) {
+			get_manager<ALG>()->access(txn, XP_REQ, row);
+		} else if (type == WR) {
+			assert (type == WR && row != NULL);
+			assert (row->get_schema() == this->get_schema());
+			// This is a true write, write commit
+			// For MVCC, interleaving commit might not be a problem since we only allow one prewriter thus interleaving txn will not write a same row
+			RC rc = get_manager<ALG>()->access(txn, W_REQ, row);
+			assert(rc == RCOK);
+		}
+	} else if constexpr (ALG == OCC) {
+		assert (row != NULL);
+		if (type == WR) // Failed WR should be XP, thus will not be committed
+			get_manager<ALG>()->write( row, txn->end_ts ); // Note that `this` original row is already locked while `row` is the new row
+		row->free_row(); // Free data buffer
+		mem_allocator.free(row, sizeof(row_t)); // Free meta data
+	} else if constexpr (ALG == TICTOC || ALG == SILO) {
+		assert (row != NULL);
+	} else if constexpr (ALG == HEKATON)
+		assert(false);
+	// HSTORE, VLL: nothing to return
 }
 
+#define ROW_ACCESS(alg) \
+	template RC row_t::get_row<alg>(access_t, txn_man *, row_t *&); \
+	template void row_t::return_row<alg>(access_t, txn_man *, row_t *);
+CC_EACH(ROW_ACCESS)
+
@@ -2,6 +2,7 @@
 
 #include <cassert>
 #include "global.h"
+#include "cc_policy.h"
 
 #define DECL_SET_VALUE(type) \
 	void set_value(int col_id, type value);
@@ -16,8 +17,7 @@
 
 #define GET_VALUE(type)\
 	void row_t::get_value(int col_id, type & value) {\
-		int pos = get_schema()->get_field_index(col_id);\
-		value = *(type *)&data[pos];\
+		value = *(type *)get_value(col_id);\
 	}
 
 class table_t;
@@ -37,12 +37,17 @@ class row_t
 {
 public:
 
-	RC init(table_t * host_table, uint64_t part_id, uint64_t row_id = 0);
+	// the row keeps its tuple in `tuple` if given, e.g. in an image
+	RC init(table_t * host_table, uint64_t part_id, uint64_t row_id = 0, char * tuple = NULL);
 	// Will simply alloc a buffer
 	void init(int size);
 	RC switch_schema(table_t * host_table);
-	// not every row has a manager
-	void init_manager(row_t * row);
+	// A row of a table is one cache-aligned block holding the row_t, its
+	// manager and the tuple, unless the tuple is given (e.g. in an image).
+	static uint64_t get_block_size(uint64_t tuple_size, bool with_tuple);
+	// builds the row in the block starting at `this`. [PAX] `tuple` is the
+	// page of the row.
+	RC init_block(table_t * host_table, uint64_t part_id, uint64_t row_id, char * tuple);
 
 	table_t * get_table();
 	Catalog * get_schema();
@@ -52,6 +57,9 @@ public:
 	uint64_t get_row_id() { return _row_id; };
 	// Maybe there's no need to use a manager and points back here again?
 	void copy(row_t * src);
+	// only the columns in the mask `cols` (bit i is column i). Of a PAX
+	// row only those are gathered.
+	void copy(row_t * src, uint64_t cols);
 
 	void 		set_primary_key(uint64_t key) { _primary_key = key; };
 	uint64_t 	get_primary_key() {return _primary_key; };
@@ -76,8 +84,15 @@ public:
 	DECL_GET_VALUE(SInt32);
 
 
+	// the whole tuple in row order. A PAX row is scattered / gathered.
 	void set_data(char * data, uint64_t size);
 	char * get_data();
+	// `data` itself, or the tuple gathered into `buf` if the row is in a PAX page
+	char * get_tuple(char * buf);
+	// the row of an insert that aborted, or that recovery did not find in the
+	// log. It keeps its row id but is in no index.
+	void set_hole() { _hole = true; };
+	bool is_hole() { return _hole; };
 
 	void free_row();
 
@@ -85,26 +100,16 @@ public:
 	// Try to access `this` row with priority specified by `type` and transaction specified by `txn`.
 	// Fill the content (can be a copy, or the row itself) you want in the reference `&row`
 	// CC manager corresponding to our protocol will be called
-	RC get_row(access_t type, txn_man * txn, row_t *& row);
-	void return_row(access_t type, txn_man * txn, row_t * row);
+	template<int ALG> RC get_row(access_t type, txn_man * txn, row_t *& row);
+	template<int ALG> void return_row(access_t type, txn_man * txn, row_t * row);
 	
-  #if CC_ALG == DL_DETECT || CC_ALG == NO_WAIT || CC_ALG == WAIT_DIE
-    Row_lock * manager;
-  #elif CC_ALG == TIMESTAMP
-   	Row_ts * manager;
-  #elif CC_ALG == MVCC
-  	Row_mvcc * manager;
-  #elif CC_ALG == HEKATON
-  	Row_hekaton * manager;
-  #elif CC_ALG == OCC
-  	Row_occ * manager; // This row's manager, allocated locally in partition
-  #elif CC_ALG == TICTOC
-  	Row_tictoc * manager;
-  #elif CC_ALG == SILO
-  	Row_silo * manager;
-  #elif CC_ALG == VLL
-  	Row_vll * manager;
-  #endif
+	// the manager of algorithm g_cc_alg, of class cc_policy<ALG>::Manager.
+	// [HSTORE] there is none.
+	void * manager;
+	template<int ALG> 
+	typename cc_policy<ALG>::Manager * get_manager() { 
+		return (typename cc_policy<ALG>::Manager *) manager; 
+	};
 	char * data; // Real data of this row (stdlib?)
 	table_t * table; // Belongs to which table
 private:
@@ -112,4 +117,6 @@ private:
 	uint64_t 		_primary_key;
 	uint64_t		_part_id; // In which partition
 	uint64_t 		_row_id; // Which row I am in this table, never set and never used
+	bool 			_pax; // `data` is the PAX page of the row
+	bool 			_hole;
 };
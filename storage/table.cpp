@@ -5,8 +5,12 @@
 #include "row.h"
 #include "mem_alloc.h"
 
-void table_t::init(Catalog * schema) {
+void table_t::init(Catalog * schema, uint32_t table_id) {
 	this->table_name = schema->table_name;
+	this->table_id = table_id;
+	this->cur_tab_size = 0;
+	row_sets = (RowSet *) _mm_malloc(sizeof(RowSet) * g_part_cnt, CL_SIZE);
+	memset(row_sets, 0, sizeof(RowSet) * g_part_cnt);
 	this->schema = schema;
 }
 
@@ -17,13 +21,99 @@ RC table_t::get_new_row(row_t *& row) {
 }
 // Alloc a new row, return its ptr and ID
 // the row is not stored locally. the pointer must be maintained by index structure.
-RC table_t::get_new_row(row_t *& row, uint64_t part_id, uint64_t &row_id) {
+RC table_t::get_new_row(row_t *& row, uint64_t part_id, uint64_t &row_id, char * tuple) {
 	RC rc = RCOK;
 	cur_tab_size ++;
 	
-	row = (row_t *) _mm_malloc(sizeof(row_t), 64);
-	rc = row->init(this, part_id, row_id); // NOTE: but we haven't assign a row_id?
-	row->init_manager(row);
+	// a PAX row keeps only its header and manager in the block
+	row = (row_t *) alloc_block(part_id, 
+		row_t::get_block_size(schema->get_tuple_size(), tuple == NULL && !schema->pax));
+	row_id = add_row(row, part_id);
+	if (schema->pax) {
+		rc = row->init_block(this, part_id, row_id, get_page(part_id, row_id));
+		if (tuple != NULL)
+			row->set_data(tuple, schema->get_tuple_size());
+	} else 
+		rc = row->init_block(this, part_id, row_id, tuple);
 
 	return rc;
 }
+
+uint64_t table_t::add_row(row_t * row, uint64_t part_id) {
+	uint64_t row_id = ATOM_FETCH_ADD(row_sets[part_id].cnt, 1);
+	*get_slot(row_sets[part_id].chunks, part_id, row_id, true) = row;
+	return row_id;
+}
+
+row_t * table_t::get_row(uint64_t part_id, uint64_t row_id) {
+	assert(row_id < row_sets[part_id].cnt);
+	return (row_t *) *get_slot(row_sets[part_id].chunks, part_id, row_id, false);
+}
+
+char * table_t::get_page(uint64_t part_id, uint64_t row_id) {
+	void ** slot = get_slot(row_sets[part_id].pages, part_id, row_id >> PAX_PAGE_BITS, true);
+	if (*slot == NULL) {
+		char * page = (char *) 
+			mem_allocator.alloc_aligned(PAX_PAGE_ROWS * schema->get_tuple_size(), part_id);
+		if (!ATOM_CAS(*slot, NULL, page))
+			mem_allocator.free_aligned(page);
+	}
+	return (char *) *slot;
+}
+
+void table_t::scan_column(uint64_t part_id, uint64_t col_id, uint64_t start, uint64_t cnt, char * buf) {
+	assert(start + cnt <= row_sets[part_id].cnt);
+	uint64_t size = schema->get_field_size(col_id);
+	if (!schema->pax) {
+		for (uint64_t rid = start; rid < start + cnt; rid++) {
+			memcpy(buf, get_row(part_id, rid)->get_value(col_id), size);
+			buf += size;
+		}
+		return;
+	}
+	// the values of a page are next to each other
+	uint64_t rid = start;
+	while (rid < start + cnt) {
+		uint64_t slot = rid & (PAX_PAGE_ROWS - 1);
+		uint64_t n = min(PAX_PAGE_ROWS - slot, start + cnt - rid);
+		char * page = (char *) *get_slot(row_sets[part_id].pages, part_id, rid >> PAX_PAGE_BITS, false);
+		memcpy(buf, page + schema->get_pax_offset(col_id, slot), n * size);
+		buf += n * size;
+		rid += n;
+	}
+}
+
+char * table_t::alloc_block(uint64_t part_id, uint64_t size) {
+	RowSet * set = &row_sets[part_id];
+	while (true) {
+		RowSegment * seg = set->seg;
+		if (seg != NULL) {
+			uint64_t off = ATOM_FETCH_ADD(seg->used, size);
+			if (off + size <= seg->size)
+				return (char *)seg + off;
+		}
+		// the segment is full. The first thread to notice replaces it.
+		uint64_t seg_size = max(ROW_SEG_SIZE, size + CL_SIZE);
+		RowSegment * new_seg = (RowSegment *) mem_allocator.alloc_aligned(seg_size, part_id);
+		new_seg->size = seg_size;
+		new_seg->used = CL_SIZE;
+		if (!ATOM_CAS(set->seg, seg, new_seg))
+			mem_allocator.free_aligned(new_seg);
+	}
+}
+
+void ** table_t::get_slot(void ** volatile * chunks, uint64_t part_id, uint64_t id, bool alloc) {
+	uint64_t pos = id + (1UL << ROW_SET_BASE_BITS);
+	uint32_t chunk = 63 - __builtin_clzll(pos) - ROW_SET_BASE_BITS;
+	uint64_t chunk_size = 1UL << (chunk + ROW_SET_BASE_BITS);
+	assert(chunk < ROW_SET_CHUNKS);
+	if (alloc && chunks[chunk] == NULL) {
+		// empty, since pages are allocated when their slot is found empty
+		void ** entries = (void **) 
+			mem_allocator.alloc_aligned(sizeof(void *) * chunk_size, part_id);
+		memset(entries, 0, sizeof(void *) * chunk_size);
+		if (!ATOM_CAS(chunks[chunk], NULL, entries))
+			mem_allocator.free_aligned(entries);
+	}
+	return &chunks[chunk][pos - chunk_size];
+}
@@ -7,25 +7,66 @@
 class Catalog;
 class row_t;
 
+// Rows of one partition of a table, in insertion order. The position of a
+// row is its row id. Chunk c holds 2^(c + ROW_SET_BASE_BITS) rows, so
+// appending never moves a row. [PAX] The pages of the tuples are kept in
+// chunks the same way, page p holding the rows of ids p * PAX_PAGE_ROWS on.
+#define ROW_SET_BASE_BITS	6
+#define ROW_SET_CHUNKS		48
+// Rows are bumped off segments of ROW_SEG_SIZE bytes owned by the table,
+// a segment per partition at a time. Rows are never freed.
+#define ROW_SEG_SIZE		(1UL << 21)
+struct RowSegment {
+	uint64_t 			size;
+	volatile uint64_t 	used; // the first cache line is the header
+};
+struct RowSet {
+	volatile uint64_t 	cnt;
+	void ** volatile 	chunks[ROW_SET_CHUNKS];
+	void ** volatile 	pages[ROW_SET_CHUNKS];
+	// the rows themselves are carved out of this segment
+	RowSegment * volatile seg;
+};
+
 class table_t
 {
 public:
-	void init(Catalog * schema);
+	// tables are numbered in the order of the schema file
+	void init(Catalog * schema, uint32_t table_id);
 	// row lookup should be done with index. But index does not have
 	// records for new rows. get_new_row returns the pointer to a 
 	// new row.	
 	RC get_new_row(row_t *& row); // this is equivalent to insert()
-	RC get_new_row(row_t *& row, uint64_t part_id, uint64_t &row_id);
+	RC get_new_row(row_t *& row, uint64_t part_id, uint64_t &row_id, char * tuple = NULL);
 
 	void delete_row(); // TODO delete_row is not supportet yet
 
 	uint64_t get_table_size() { return cur_tab_size; };
 	Catalog * get_schema() { return schema; };
 	const char * get_table_name() { return table_name; };
+	uint32_t get_table_id() { return table_id; };
+	// every row of a partition, for checkpoints and recovery. Only stable
+	// while no row is being added.
+	uint64_t get_row_cnt(uint64_t part_id) { return row_sets[part_id].cnt; };
+	row_t * get_row(uint64_t part_id, uint64_t row_id);
+	// copies column `col_id` of rows [start, start + cnt) of a partition into
+	// `buf`, value after value. Of a PAX table only that column is read.
+	// There is no concurrency control.
+	void scan_column(uint64_t part_id, uint64_t col_id, uint64_t start, uint64_t cnt, char * buf);
 
 	Catalog * 		schema;
 private:
 	const char * 	table_name;
 	uint64_t  		cur_tab_size; // Current number of rows in this table
-	char 			pad[CL_SIZE - sizeof(void *)*3];
+	RowSet * 		row_sets; // one per partition
+	uint32_t 		table_id;
+	char 			pad[CL_SIZE - sizeof(void *)*4 - sizeof(uint32_t)];
+	// reserves the row id of a new row
+	uint64_t 		add_row(row_t * row, uint64_t part_id);
+	// entry `id` of the chunks of a partition, allocating its chunk if asked
+	void ** 		get_slot(void ** volatile * chunks, uint64_t part_id, uint64_t id, bool alloc);
+	// [PAX] the page of row `row_id`
+	char * 			get_page(uint64_t part_id, uint64_t row_id);
+	// a cache-aligned block of `size` bytes from the segment of the partition
+	char * 			alloc_block(uint64_t part_id, uint64_t size);
 };
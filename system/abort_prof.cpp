@@ -0,0 +1,128 @@
+#include "abort_prof.h"
+#include "wl.h"
+#include "table.h"
+#include "row.h"
+#include <algorithm>
+
+static const char * reason_names[ABORT_REASON_CNT] = 
+	{"unknown", "conflict", "wait_die", "deadlock", "timeout", "ts_order", "version", "validate"};
+
+void AbortProf::init(workload * wl) {
+	_tables.resize(wl->tables.size());
+	for (map<string, table_t *>::iterator it = wl->tables.begin(); it != wl->tables.end(); it ++)
+		_tables[it->second->get_table_id()] = it->second;
+	uint64_t row_cnt = _tables.size() * PROF_TOP_K;
+	_prof = (ThdProf **) _mm_malloc(sizeof(ThdProf *) * g_thread_cnt, 64);
+	for (UInt32 i = 0; i < g_thread_cnt; i++) {
+		_prof[i] = (ThdProf *) _mm_malloc(sizeof(ThdProf), 64);
+		memset(_prof[i], 0, sizeof(ThdProf));
+		_prof[i]->rows = (HotRow *) _mm_malloc(sizeof(HotRow) * row_cnt, 64);
+		memset(_prof[i]->rows, 0, sizeof(HotRow) * row_cnt);
+	}
+}
+
+void AbortProf::record(uint64_t thd_id, AbortReason reason, row_t * row, uint64_t wasted) {
+	ThdProf * prof = _prof[thd_id];
+	prof->reason_cnt[reason] ++;
+	prof->reason_wasted[reason] += wasted;
+	if (row == NULL)
+		return;
+	uint64_t key = row->get_primary_key();
+	HotRow * rows = &prof->rows[row->get_table()->get_table_id() * PROF_TOP_K];
+	HotRow * min = &rows[0];
+	HotRow * hot = NULL;
+	for (uint32_t i = 0; i < PROF_TOP_K; i++) {
+		if (rows[i].cnt > 0 && rows[i].key == key) {
+			hot = &rows[i];
+			break;
+		}
+		// an empty slot has wasted 0
+		if (rows[i].wasted < min->wasted)
+			min = &rows[i];
+	}
+	if (hot == NULL) {
+		// evict the coolest row
+		hot = min;
+		hot->key = key;
+		hot->err = hot->wasted;
+		hot->cnt = 0;
+		memset(hot->reason_cnt, 0, sizeof(hot->reason_cnt));
+	}
+	hot->wasted += wasted;
+	hot->cnt ++;
+	hot->reason_cnt[reason] ++;
+}
+
+void AbortProf::print(FILE * outf, const char * line) {
+	printf("%s", line);
+	if (outf != NULL)
+		fprintf(outf, "%s", line);
+}
+
+void AbortProf::print() {
+	FILE * outf = output_file == NULL? NULL : fopen(output_file, "a");
+	char line[512];
+	uint64_t reason_cnt[ABORT_REASON_CNT] = {0};
+	uint64_t reason_wasted[ABORT_REASON_CNT] = {0};
+	uint64_t total_wasted = 0;
+	for (UInt32 tid = 0; tid < g_thread_cnt; tid ++)
+		for (uint32_t r = 0; r < ABORT_REASON_CNT; r ++) {
+			reason_cnt[r] += _prof[tid]->reason_cnt[r];
+			reason_wasted[r] += _prof[tid]->reason_wasted[r];
+			total_wasted += _prof[tid]->reason_wasted[r];
+		}
+	vector<pair<uint64_t, uint32_t> > reasons;
+	for (uint32_t r = 0; r < ABORT_REASON_CNT; r ++)
+		if (reason_cnt[r] > 0)
+			reasons.push_back(make_pair(reason_wasted[r], r));
+	sort(reasons.rbegin(), reasons.rend());
+	for (uint32_t i = 0; i < reasons.size(); i ++) {
+		uint32_t r = reasons[i].second;
+		snprintf(line, sizeof(line), "[abort_reason] reason=%s, abort_cnt=%ld, wasted=%f, share=%f\n",
+			reason_names[r], reason_cnt[r], (double) reason_wasted[r] / 1000000000.0,
+			(double) reason_wasted[r] / total_wasted);
+		print(outf, line);
+	}
+	// The same row may sit in the sketches of several threads. Summing the
+	// entries of a key over all threads keeps the bounds of each one.
+	for (uint32_t t = 0; t < _tables.size(); t ++) {
+		map<uint64_t, HotRow> merged;
+		for (UInt32 tid = 0; tid < g_thread_cnt; tid ++) {
+			HotRow * rows = &_prof[tid]->rows[t * PROF_TOP_K];
+			for (uint32_t i = 0; i < PROF_TOP_K; i++) {
+				if (rows[i].cnt == 0)
+					continue;
+				map<uint64_t, HotRow>::iterator it = merged.find(rows[i].key);
+				if (it == merged.end()) {
+					merged[rows[i].key] = rows[i];
+					continue;
+				}
+				HotRow & hot = it->second;
+				hot.wasted += rows[i].wasted;
+				hot.err += rows[i].err;
+				hot.cnt += rows[i].cnt;
+				for (uint32_t r = 0; r < ABORT_REASON_CNT; r ++)
+					hot.reason_cnt[r] += rows[i].reason_cnt[r];
+			}
+		}
+		vector<HotRow> hot_rows;
+		for (map<uint64_t, HotRow>::iterator it = merged.begin(); it != merged.end(); it ++)
+			hot_rows.push_back(it->second);
+		sort(hot_rows.begin(), hot_rows.end(), more_wasted);
+		for (uint32_t i = 0; i < hot_rows.size() && i < PROF_TOP_K; i ++) {
+			HotRow & hot = hot_rows[i];
+			uint32_t top = 0;
+			for (uint32_t r = 1; r < ABORT_REASON_CNT; r ++)
+				if (hot.reason_cnt[r] > hot.reason_cnt[top])
+					top = r;
+			snprintf(line, sizeof(line), "[hot_row] table=%s, key=%ld, abort_cnt=%ld"
+				", wasted=%f, err=%f, reason=%s\n",
+				_tables[t]->get_table_name(), hot.key, hot.cnt,
+				(double) hot.wasted / 1000000000.0, (double) hot.err / 1000000000.0,
+				reason_names[top]);
+			print(outf, line);
+		}
+	}
+	if (outf != NULL)
+		fclose(outf);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "global.h"
+#include "helper.h"
+
+class workload;
+class table_t;
+class row_t;
+
+// [PROF_ABORT] Attributes every abort to its reason and the row it happened
+// on, weighted by the time the aborted attempt wasted. Each thread keeps,
+// per table, the PROF_TOP_K rows it wasted most time on in a weighted
+// space-saving sketch: a row not in the sketch replaces the entry with the
+// least time and inherits that time as its possible overestimate (`err`).
+// Only the aborting thread touches its sketches, so nothing is shared until
+// the report merges them.
+class AbortProf {
+public:
+	void 		init(workload * wl);
+	// an attempt of `thd_id` aborted after `wasted` ns
+	void 		record(uint64_t thd_id, AbortReason reason, row_t * row, uint64_t wasted);
+	// ranks reasons and rows by wasted time, to stdout and the output file
+	void 		print();
+private:
+	struct HotRow {
+		uint64_t 	key;
+		uint64_t 	wasted;
+		uint64_t 	err;
+		uint64_t 	cnt;
+		uint64_t 	reason_cnt[ABORT_REASON_CNT];
+	};
+	struct ThdProf {
+		uint64_t 	reason_cnt[ABORT_REASON_CNT];
+		uint64_t 	reason_wasted[ABORT_REASON_CNT];
+		// [table_id * PROF_TOP_K + i]
+		HotRow * 	rows;
+	};
+	static bool 	more_wasted(const HotRow & a, const HotRow & b) {
+		return a.wasted > b.wasted;
+	}
+	void 			print(FILE * outf, const char * line);
+
+	vector<table_t *> 	_tables; // by table id
+	ThdProf ** 			_prof;
+};
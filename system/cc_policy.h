@@ -0,0 +1,60 @@
+#pragma once
+
+#include "global.h"
+
+class Row_lock;
+class Row_ts;
+class Row_mvcc;
+class Row_hekaton;
+class Row_occ;
+class Row_tictoc;
+class Row_silo;
+class Row_vll;
+
+// Every concurrency control algorithm is compiled in and g_cc_alg (CC_ALG,
+// -c<ALG>) picks one at runtime. The code on the path of an access is a
+// template over the algorithm, instantiated once per algorithm, so it is
+// bound at compile time. thread_t::run picks the instantiation of the
+// thread loop once, and the loop runs the txns of that instantiation.
+//
+// cc_policy<ALG>::Manager is the class of the manager of each row.
+template<int ALG> struct cc_policy;
+template<> struct cc_policy<NO_WAIT> 	{ typedef Row_lock 		Manager; };
+template<> struct cc_policy<WAIT_DIE> 	{ typedef Row_lock 		Manager; };
+template<> struct cc_policy<DL_DETECT> 	{ typedef Row_lock 		Manager; };
+template<> struct cc_policy<TIMESTAMP> 	{ typedef Row_ts 		Manager; };
+template<> struct cc_policy<MVCC> 		{ typedef Row_mvcc 		Manager; };
+template<> struct cc_policy<HEKATON> 	{ typedef Row_hekaton 	Manager; };
+template<> struct cc_policy<HSTORE> 	{ typedef void 			Manager; };
+template<> struct cc_policy<OCC> 		{ typedef Row_occ 		Manager; };
+template<> struct cc_policy<TICTOC> 	{ typedef Row_tictoc 	Manager; };
+template<> struct cc_policy<SILO> 		{ typedef Row_silo 		Manager; };
+template<> struct cc_policy<VLL> 		{ typedef Row_vll 		Manager; };
+
+// CC_EACH(m) expands m(ALG) for every algorithm, e.g. to instantiate a
+// template for each of them.
+#define CC_EACH(m) \
+	m(NO_WAIT) m(WAIT_DIE) m(DL_DETECT) m(TIMESTAMP) m(MVCC) m(HEKATON) \
+	m(HSTORE) m(OCC) m(TICTOC) m(SILO) m(VLL)
+
+// `return call<ALG>(...)` of the algorithm in g_cc_alg, e.g.
+// CC_DISPATCH(run_loop, ())
+#define CC_CASE(alg, call, args) 	case alg: return call<alg> args;
+#define CC_DISPATCH(call, args) \
+	switch (g_cc_alg) { \
+		CC_CASE(NO_WAIT, call, args) \
+		CC_CASE(WAIT_DIE, call, args) \
+		CC_CASE(DL_DETECT, call, args) \
+		CC_CASE(TIMESTAMP, call, args) \
+		CC_CASE(MVCC, call, args) \
+		CC_CASE(HEKATON, call, args) \
+		CC_CASE(HSTORE, call, args) \
+		CC_CASE(OCC, call, args) \
+		CC_CASE(TICTOC, call, args) \
+		CC_CASE(SILO, call, args) \
+		CC_CASE(VLL, call, args) \
+		default: assert(false); \
+	}
+
+// the algorithm called `name` (-c<ALG>), or 0 if there is none
+UInt32 			cc_alg_by_name(const char * name);
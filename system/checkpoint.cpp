@@ -0,0 +1,492 @@
+#include <algorithm>
+#include "checkpoint.h"
+#include "logger.h"
+#include "wl.h"
+#include "table.h"
+#include "catalog.h"
+#include "row.h"
+#include "index_hash.h"
+#include "index_hash_lf.h"
+#include "index_btree.h"
+#include "index_btree_olc.h"
+// after global.h, whose lock_t clashes with the flock() constants
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+
+#define BILLION 1000000000UL
+
+void Checkpoint::get_path(char * path, const char * name, uint64_t id) {
+	snprintf(path, 1024, "%s/%s_%ld", LOG_DIR, name, id);
+}
+
+void Checkpoint::run_parallel(void (Checkpoint::*job)(uint64_t), uint64_t job_cnt) {
+	_job = job;
+	_job_cnt = job_cnt;
+	_next_job = 0;
+	uint64_t thd_cnt = min((uint64_t) g_init_parallelism, job_cnt);
+	pthread_t p_thds[thd_cnt];
+	for (uint64_t i = 1; i < thd_cnt; i++)
+		pthread_create(&p_thds[i], NULL, run_jobs, this);
+	run_jobs(this);
+	for (uint64_t i = 1; i < thd_cnt; i++)
+		pthread_join(p_thds[i], NULL);
+}
+
+void * Checkpoint::run_jobs(void * This) {
+	Checkpoint * ckpt = (Checkpoint *) This;
+	uint64_t id;
+	while ((id = ATOM_FETCH_ADD(ckpt->_next_job, 1)) < ckpt->_job_cnt)
+		(ckpt->*(ckpt->_job))(id);
+	return NULL;
+}
+
+void Checkpoint::init_tables(workload * wl) {
+	_wl = wl;
+	_tables.assign(wl->tables.size(), NULL);
+	for (map<string, table_t *>::iterator it = wl->tables.begin(); it != wl->tables.end(); it++)
+		_tables[it->second->get_table_id()] = it->second;
+	_indexes.clear();
+	_index_ids.clear();
+	for (map<string, INDEX *>::iterator it = wl->indexes.begin(); it != wl->indexes.end(); it++) {
+		_index_ids[it->second] = _indexes.size();
+		_indexes.push_back(it->second);
+	}
+}
+
+void Checkpoint::write(workload * wl) {
+	uint64_t starttime = get_server_clock();
+	init_tables(wl);
+	_ckpt_id = starttime;
+	mkdir(LOG_DIR, 0755);
+	run_parallel(&Checkpoint::write_part, g_part_cnt);
+	// the renames must be durable before the log they replace is truncated
+	int fd = open(LOG_DIR, O_RDONLY);
+	fsync(fd);
+	close(fd);
+	printf("checkpoint %ld written in %f s\n", _ckpt_id,
+		(double)(get_server_clock() - starttime) / BILLION);
+}
+
+void Checkpoint::write_part(uint64_t part_id) {
+	char path[1024];
+	char tmp_path[1024];
+	get_path(path, "ckpt", part_id);
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	FILE * file = fopen(tmp_path, "w");
+	M_ASSERT(file != NULL, "cannot open %s\n", tmp_path);
+	char * buffer = (char *) malloc(LOG_BUFFER_SIZE);
+	setvbuf(file, buffer, _IOFBF, LOG_BUFFER_SIZE);
+
+	CkptHeader header;
+	header.magic = CKPT_MAGIC;
+	header.ckpt_id = _ckpt_id;
+	header.part_id = part_id;
+	header.part_cnt = g_part_cnt;
+	header.row_cnt = 0;
+	for (uint32_t t = 0; t < _tables.size(); t++)
+		header.row_cnt += _tables[t]->get_row_cnt(part_id);
+	fwrite(&header, sizeof(CkptHeader), 1, file);
+	char pad[8] = {0};
+	char tuple[MAX_TUPLE_SIZE];
+	for (uint32_t t = 0; t < _tables.size(); t++) {
+		table_t * table = _tables[t];
+		for (uint64_t rid = 0; rid < table->get_row_cnt(part_id); rid++) {
+			row_t * row = table->get_row(part_id, rid);
+			LogRedoEntry entry;
+			entry.table_id = t;
+			entry.size = row->is_hole()? 0 : row->get_tuple_size();
+			entry.part_id = part_id;
+			entry.insert = 0;
+			entry.row_id = rid;
+			entry.primary_key = row->get_primary_key();
+			fwrite(&entry, sizeof(LogRedoEntry), 1, file);
+			fwrite(row->get_tuple(tuple), entry.size, 1, file);
+			fwrite(pad, LOG_ALIGN(entry.size) - entry.size, 1, file);
+		}
+	}
+	int ret = fflush(file);
+	if (ret == 0)
+		ret = fdatasync(fileno(file));
+	M_ASSERT(ret == 0, "cannot write %s: %s\n", tmp_path, strerror(errno));
+	fclose(file);
+	free(buffer);
+	rename(tmp_path, path);
+}
+
+void Checkpoint::recover(workload * wl) {
+	uint64_t starttime = get_server_clock();
+	init_tables(wl);
+
+	// every partition file must come from the same snapshot
+	char path[1024];
+	get_path(path, "ckpt", 0);
+	FILE * file = fopen(path, "r");
+	M_ASSERT(file != NULL, "no checkpoint in %s to recover from\n", LOG_DIR);
+	CkptHeader header;
+	size_t cnt = fread(&header, sizeof(CkptHeader), 1, file);
+	M_ASSERT(cnt == 1 && header.magic == CKPT_MAGIC, "%s is not a checkpoint\n", path);
+	fclose(file);
+	M_ASSERT(header.part_cnt == g_part_cnt, "checkpoint has %ld partitions, PART_CNT is %d\n",
+		header.part_cnt, g_part_cnt);
+	_load_id = header.ckpt_id;
+	_rows_loaded = 0;
+	run_parallel(&Checkpoint::load_part, g_part_cnt);
+	uint64_t load_time = get_server_clock() - starttime;
+	printf("loaded %ld rows of checkpoint %ld in %f s (%f rows/s)\n", _rows_loaded, _load_id,
+		(double) load_time / BILLION, _rows_loaded / ((double) load_time / BILLION));
+
+	// the log files of the run that started from this snapshot
+	starttime = get_server_clock();
+	for (uint64_t i = 0; ; i++) {
+		get_path(path, "log", i);
+		int fd = open(path, O_RDONLY);
+		if (fd < 0)
+			break;
+		struct stat st;
+		fstat(fd, &st);
+		char * log = NULL;
+		if (st.st_size > 0)
+			log = (char *) mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		_logs.push_back(log);
+		_log_sizes.push_back(st.st_size);
+	}
+	uint64_t log_cnt = _logs.size();
+	_log_durable.assign(log_cnt, 0);
+	_log_valid.assign(log_cnt, false);
+	_replay = new vector<ReplayEntry> [log_cnt * g_part_cnt];
+	run_parallel(&Checkpoint::scan_log, log_cnt);
+	// an epoch is complete once every logger marked it
+	_durable_epoch = (log_cnt == 0)? 0 : UINT64_MAX;
+	for (uint64_t i = 0; i < log_cnt; i++) {
+		if (!_log_valid[i]) {
+			printf("log_%ld does not start from checkpoint %ld. The log is not replayed.\n",
+				i, _load_id);
+			_durable_epoch = 0;
+		} else if (_log_durable[i] < _durable_epoch)
+			_durable_epoch = _log_durable[i];
+	}
+	_entries_replayed = 0;
+	run_parallel(&Checkpoint::replay_part, g_part_cnt);
+	for (uint64_t i = 0; i < log_cnt; i++)
+		if (_logs[i] != NULL)
+			munmap(_logs[i], _log_sizes[i]);
+	delete [] _replay;
+	uint64_t replay_time = get_server_clock() - starttime;
+	printf("replayed %ld rows up to epoch %ld from %ld log files in %f s\n",
+		_entries_replayed, _durable_epoch, log_cnt, (double) replay_time / BILLION);
+}
+
+void Checkpoint::load_part(uint64_t part_id) {
+	char path[1024];
+	get_path(path, "ckpt", part_id);
+	int fd = open(path, O_RDONLY);
+	M_ASSERT(fd >= 0, "cannot open %s\n", path);
+	struct stat st;
+	fstat(fd, &st);
+	char * data = (char *) mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+	close(fd);
+	M_ASSERT(data != MAP_FAILED, "cannot map %s\n", path);
+	CkptHeader * header = (CkptHeader *) data;
+	M_ASSERT(header->magic == CKPT_MAGIC && header->ckpt_id == _load_id
+		&& header->part_id == part_id, "%s does not belong to checkpoint %ld\n", path, _load_id);
+
+	char * ptr = data + sizeof(CkptHeader);
+	for (uint64_t i = 0; i < header->row_cnt; i++) {
+		LogRedoEntry * entry = (LogRedoEntry *) ptr;
+		table_t * table = _tables[entry->table_id];
+		row_t * row;
+		uint64_t row_id;
+		table->get_new_row(row, part_id, row_id);
+		// rows get their old ids since a partition is loaded in order
+		assert(row_id == entry->row_id);
+		if (entry->size == 0)
+			row->set_hole();
+		else {
+			row->set_primary_key(entry->primary_key);
+			row->set_data(ptr + sizeof(LogRedoEntry), entry->size);
+			_wl->index_row(table, row);
+		}
+		ptr += sizeof(LogRedoEntry) + LOG_ALIGN(entry->size);
+	}
+	ATOM_ADD(_rows_loaded, header->row_cnt);
+	munmap(data, st.st_size);
+}
+
+void Checkpoint::scan_log(uint64_t log_id) {
+	char * log = _logs[log_id];
+	uint64_t size = _log_sizes[log_id];
+	uint64_t pos = 0;
+	uint64_t cmd_cnt = 0;
+	while (pos + sizeof(LogRecord) <= size) {
+		LogRecord * rec = (LogRecord *) (log + pos);
+		// the end of the log, or a record cut off by a crash
+		if (rec->size < sizeof(LogRecord) || pos + rec->size > size)
+			break;
+		if (pos == 0) {
+			if (rec->type != LOG_REC_EPOCH || rec->seq != _load_id)
+				return;
+			_log_valid[log_id] = true;
+		}
+		if (rec->type == LOG_REC_EPOCH)
+			_log_durable[log_id] = rec->epoch;
+		else if (rec->type == LOG_REC_CMD)
+			cmd_cnt ++;
+		else {
+			char * ptr = (char *) (rec + 1);
+			for (uint32_t i = 0; i < rec->entry_cnt; i++) {
+				LogRedoEntry * entry = (LogRedoEntry *) ptr;
+				if (entry->part_id >= g_part_cnt || entry->table_id >= _tables.size())
+					break;
+				ReplayEntry e;
+				e.table_id = entry->table_id;
+				e.row_id = entry->row_id;
+				// the insert of a row comes before its updates, even those of
+				// txns with an older ts (TIMESTAMP, MVCC)
+				e.seq = entry->insert? 0 : rec->seq;
+				e.epoch = rec->epoch;
+				e.entry = entry;
+				_replay[log_id * g_part_cnt + entry->part_id].push_back(e);
+				ptr += sizeof(LogRedoEntry) + LOG_ALIGN(entry->size);
+			}
+		}
+		pos += rec->size;
+	}
+	// replaying a command means running the txn again
+	if (cmd_cnt > 0)
+		printf("log_%ld: skipped %ld command records, only redo records are replayed\n",
+			log_id, cmd_cnt);
+}
+
+void Checkpoint::replay_part(uint64_t part_id) {
+	vector<ReplayEntry> entries;
+	for (uint64_t i = 0; i < _logs.size(); i++) {
+		vector<ReplayEntry> & log = _replay[i * g_part_cnt + part_id];
+		for (uint64_t j = 0; j < log.size(); j++)
+			if (log[j].epoch <= _durable_epoch)
+				entries.push_back(log[j]);
+		vector<ReplayEntry>().swap(log);
+	}
+	// after-images are whole tuples, so only the last one of a row counts
+	std::sort(entries.begin(), entries.end());
+	vector<uint64_t> loaded(_tables.size());
+	for (uint32_t t = 0; t < _tables.size(); t++)
+		loaded[t] = _tables[t]->get_row_cnt(part_id);
+	uint64_t cnt = 0;
+	for (uint64_t i = 0; i < entries.size(); i++) {
+		if (i + 1 < entries.size() && entries[i + 1].table_id == entries[i].table_id
+				&& entries[i + 1].row_id == entries[i].row_id)
+			continue;
+		LogRedoEntry * entry = entries[i].entry;
+		table_t * table = _tables[entry->table_id];
+		if (entry->row_id < loaded[entry->table_id]) {
+			row_t * row = table->get_row(part_id, entry->row_id);
+			row->set_data((char *)(entry + 1), entry->size);
+		} else {
+			// Inserted during the run. Rows come in row id order, so the
+			// ones skipped up to here are holes: their inserts aborted or
+			// are not durable.
+			row_t * row;
+			uint64_t row_id;
+			do {
+				table->get_new_row(row, part_id, row_id);
+				if (row_id < entry->row_id)
+					row->set_hole();
+			} while (row_id < entry->row_id);
+			row->set_primary_key(entry->primary_key);
+			row->set_data((char *)(entry + 1), entry->size);
+			_wl->index_row(table, row);
+		}
+		cnt ++;
+	}
+	ATOM_ADD(_entries_replayed, cnt);
+}
+
+void Checkpoint::start_image_dump() {
+	_index_log = new vector<IndexRecord> [g_part_cnt];
+	_index_log_latches = new pthread_mutex_t [g_part_cnt];
+	for (uint32_t i = 0; i < g_part_cnt; i++)
+		pthread_mutex_init(&_index_log_latches[i], NULL);
+}
+
+void Checkpoint::record_index(INDEX * index, uint64_t key, row_t * row, uint64_t index_part) {
+	IndexRecord rec;
+	rec.index = index;
+	rec.key = key;
+	rec.row = row;
+	rec.index_part = index_part;
+	uint64_t part_id = row->get_part_id();
+	pthread_mutex_lock(&_index_log_latches[part_id]);
+	_index_log[part_id].push_back(rec);
+	pthread_mutex_unlock(&_index_log_latches[part_id]);
+}
+
+void Checkpoint::dump_image(workload * wl, const char * path) {
+	uint64_t starttime = get_server_clock();
+	init_tables(wl);
+	uint64_t table_cnt = _tables.size();
+	uint64_t meta_size = sizeof(ImageHeader) + sizeof(ImageTable) * table_cnt * g_part_cnt
+		+ sizeof(ImageIndex) * g_part_cnt;
+	_image = (char *) calloc(1, meta_size);
+	_image_header = (ImageHeader *) _image;
+	_image_header->magic = IMAGE_MAGIC;
+	_image_header->workload = WORKLOAD;
+	_image_header->scale = (WORKLOAD == YCSB)? g_synth_table_size : g_num_wh;
+	_image_header->part_cnt = g_part_cnt;
+	_image_header->table_cnt = table_cnt;
+	_image_header->index_cnt = _indexes.size();
+	_image_header->central_index = CENTRAL_INDEX;
+	// each partition is one contiguous range of the file
+	ImageTable * tabs = (ImageTable *) (_image_header + 1);
+	ImageIndex * idxs = (ImageIndex *) (tabs + table_cnt * g_part_cnt);
+	uint64_t off = meta_size;
+	uint64_t row_cnt = 0;
+	for (uint32_t p = 0; p < g_part_cnt; p++) {
+		for (uint32_t t = 0; t < table_cnt; t++) {
+			ImageTable * tab = &tabs[t * g_part_cnt + p];
+			tab->row_cnt = _tables[t]->get_row_cnt(p);
+			tab->tuple_size = _tables[t]->get_schema()->get_tuple_size();
+			tab->stride = (tab->tuple_size + CL_SIZE - 1) / CL_SIZE * CL_SIZE;
+			tab->data_off = (off + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+			tab->key_off = tab->data_off + tab->row_cnt * tab->stride;
+			off = tab->key_off + tab->row_cnt * sizeof(uint64_t);
+			row_cnt += tab->row_cnt;
+		}
+		idxs[p].entry_cnt = _index_log[p].size();
+		idxs[p].entry_off = off;
+		off += idxs[p].entry_cnt * sizeof(ImageIndexEntry);
+	}
+	_image_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	M_ASSERT(_image_fd >= 0, "cannot open %s\n", path);
+	int ret = ftruncate(_image_fd, off);
+	if (ret == 0)
+		ret = (pwrite(_image_fd, _image, meta_size, 0) == (ssize_t) meta_size)? 0 : -1;
+	M_ASSERT(ret == 0, "cannot write %s: %s\n", path, strerror(errno));
+	run_parallel(&Checkpoint::write_image_part, g_part_cnt);
+	ret = fdatasync(_image_fd);
+	M_ASSERT(ret == 0, "cannot write %s: %s\n", path, strerror(errno));
+	close(_image_fd);
+	free(_image);
+	printf("image %s of %ld rows (%ld MB) written in %f s\n", path, row_cnt, off / 1024 / 1024,
+		(double)(get_server_clock() - starttime) / BILLION);
+}
+
+void Checkpoint::write_image(const char * buffer, uint64_t len, uint64_t off) {
+	ssize_t ret = pwrite(_image_fd, buffer, len, off);
+	M_ASSERT(ret == (ssize_t) len, "cannot write the image: %s\n", strerror(errno));
+}
+
+void Checkpoint::write_image_part(uint64_t part_id) {
+	ImageTable * tabs = (ImageTable *) (_image_header + 1);
+	ImageIndex * idx = (ImageIndex *) (tabs + _tables.size() * g_part_cnt) + part_id;
+	char * buffer = (char *) malloc(LOG_BUFFER_SIZE);
+	uint64_t len = 0;
+	char pad[CL_SIZE] = {0};
+	char tuple[MAX_TUPLE_SIZE];
+	for (uint32_t t = 0; t < _tables.size(); t++) {
+		ImageTable * tab = &tabs[t * g_part_cnt + part_id];
+		uint64_t off = tab->data_off;
+		for (uint64_t rid = 0; rid < tab->row_cnt; rid++) {
+			if (len + tab->stride > LOG_BUFFER_SIZE) {
+				write_image(buffer, len, off);
+				off += len;
+				len = 0;
+			}
+			memcpy(buffer + len, _tables[t]->get_row(part_id, rid)->get_tuple(tuple), tab->tuple_size);
+			memcpy(buffer + len + tab->tuple_size, pad, tab->stride - tab->tuple_size);
+			len += tab->stride;
+		}
+		for (uint64_t rid = 0; rid < tab->row_cnt; rid++) {
+			if (len + sizeof(uint64_t) > LOG_BUFFER_SIZE) {
+				write_image(buffer, len, off);
+				off += len;
+				len = 0;
+			}
+			*(uint64_t *)(buffer + len) = _tables[t]->get_row(part_id, rid)->get_primary_key();
+			len += sizeof(uint64_t);
+		}
+		write_image(buffer, len, off);
+		len = 0;
+	}
+	// the log is in insertion order, so equal keys keep their order
+	vector<IndexRecord> & log = _index_log[part_id];
+	uint64_t off = idx->entry_off;
+	for (uint64_t i = 0; i < log.size(); i++) {
+		if (len + sizeof(ImageIndexEntry) > LOG_BUFFER_SIZE) {
+			write_image(buffer, len, off);
+			off += len;
+			len = 0;
+		}
+		ImageIndexEntry * entry = (ImageIndexEntry *) (buffer + len);
+		entry->key = log[i].key;
+		entry->row_id = log[i].row->get_row_id();
+		entry->index_id = _index_ids[log[i].index];
+		entry->index_part = log[i].index_part;
+		len += sizeof(ImageIndexEntry);
+	}
+	write_image(buffer, len, off);
+	free(buffer);
+}
+
+void Checkpoint::load_image(workload * wl, const char * path) {
+	uint64_t starttime = get_server_clock();
+	init_tables(wl);
+	int fd = open(path, O_RDONLY);
+	M_ASSERT(fd >= 0, "cannot open image %s\n", path);
+	struct stat st;
+	fstat(fd, &st);
+	// private and writable: txns update the tuples in place, copy-on-write
+	_image = (char *) mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	M_ASSERT(_image != MAP_FAILED, "cannot map %s\n", path);
+	_image_header = (ImageHeader *) _image;
+	M_ASSERT(_image_header->magic == IMAGE_MAGIC, "%s is not an image\n", path);
+	M_ASSERT(_image_header->workload == WORKLOAD
+		&& _image_header->scale == ((WORKLOAD == YCSB)? g_synth_table_size : g_num_wh)
+		&& _image_header->part_cnt == g_part_cnt
+		&& _image_header->table_cnt == _tables.size()
+		&& _image_header->index_cnt == _indexes.size()
+		&& _image_header->central_index == CENTRAL_INDEX,
+		"%s was dumped with another workload, table size or PART_CNT\n", path);
+	ImageTable * tabs = (ImageTable *) (_image_header + 1);
+	for (uint32_t t = 0; t < _tables.size(); t++)
+		M_ASSERT(tabs[t * g_part_cnt].tuple_size == _tables[t]->get_schema()->get_tuple_size(),
+			"%s was dumped with another schema of %s\n", path, _tables[t]->get_table_name());
+	_rows_loaded = 0;
+	_index_loaded = 0;
+	run_parallel(&Checkpoint::load_image_part, g_part_cnt);
+	uint64_t load_time = get_server_clock() - starttime;
+	printf("loaded %ld rows and %ld index entries of image %s in %f s (%f rows/s)\n",
+		_rows_loaded, _index_loaded, path, (double) load_time / BILLION,
+		_rows_loaded / ((double) load_time / BILLION));
+}
+
+void Checkpoint::load_image_part(uint64_t part_id) {
+	ImageTable * tabs = (ImageTable *) (_image_header + 1);
+	ImageIndex * idx = (ImageIndex *) (tabs + _tables.size() * g_part_cnt) + part_id;
+	uint64_t row_cnt = 0;
+	for (uint32_t t = 0; t < _tables.size(); t++) {
+		ImageTable * tab = &tabs[t * g_part_cnt + part_id];
+		table_t * table = _tables[t];
+		char * data = _image + tab->data_off;
+		uint64_t * keys = (uint64_t *) (_image + tab->key_off);
+		for (uint64_t i = 0; i < tab->row_cnt; i++) {
+			row_t * row;
+			uint64_t row_id;
+			table->get_new_row(row, part_id, row_id, data + i * tab->stride);
+			assert(row_id == i);
+			row->set_primary_key(keys[i]);
+		}
+		row_cnt += tab->row_cnt;
+	}
+	ImageIndexEntry * entries = (ImageIndexEntry *) (_image + idx->entry_off);
+	for (uint64_t i = 0; i < idx->entry_cnt; i++) {
+		INDEX * index = _indexes[entries[i].index_id];
+		row_t * row = index->table->get_row(part_id, entries[i].row_id);
+		_wl->index_insert(index, entries[i].key, row, entries[i].index_part);
+	}
+	ATOM_ADD(_rows_loaded, row_cnt);
+	ATOM_ADD(_index_loaded, idx->entry_cnt);
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "global.h"
+#include "helper.h"
+
+class workload;
+class table_t;
+class row_t;
+class IndexHash;
+class IndexHashLF;
+class index_btree;
+class index_btree_olc;
+struct LogRedoEntry;
+
+// Snapshot of every table, one file per partition (LOG_DIR/ckpt_<part>),
+// taken at startup before any txn runs. The redo log of the run that
+// follows is tagged with the id of the snapshot. Recovery loads the
+// partitions in parallel, rebuilding the indexes as rows come in, and then
+// replays the durable epochs of the log, again one thread per partition.
+//
+// An image (--dump-image) holds the same tables in a layout that is used in
+// place: the tuples of each partition of a table lie in one array, and the
+// index keys are stored next to them. Loading an image (--image) maps the
+// file copy-on-write, points the rows at their tuples and inserts the stored
+// keys, so no tuple is generated, copied or even read until a txn touches it.
+
+#define CKPT_MAGIC			0x54504b4331786264UL
+#define IMAGE_MAGIC			0x45474d4931786264UL
+
+struct CkptHeader {
+	uint64_t 	magic;
+	uint64_t 	ckpt_id;
+	uint64_t 	part_id;
+	uint64_t 	part_cnt;
+	uint64_t 	row_cnt; // LogRedoEntry and tuple of each row follow
+};
+
+struct ImageHeader {
+	uint64_t 	magic;
+	uint64_t 	workload;
+	uint64_t 	scale; // SYNTH_TABLE_SIZE or NUM_WH, which the queries follow
+	uint64_t 	part_cnt;
+	uint64_t 	table_cnt;
+	uint64_t 	index_cnt;
+	uint64_t 	central_index;
+	// followed by ImageTable[table_cnt * part_cnt] and ImageIndex[part_cnt]
+};
+
+// the rows of one partition of a table
+struct ImageTable {
+	uint64_t 	row_cnt;
+	uint64_t 	tuple_size;
+	uint64_t 	stride; // bytes between tuples
+	uint64_t 	data_off; // tuples, page aligned
+	uint64_t 	key_off; // primary keys
+};
+
+// index entries of the rows of one partition
+struct ImageIndex {
+	uint64_t 	entry_cnt;
+	uint64_t 	entry_off;
+};
+
+struct ImageIndexEntry {
+	uint64_t 	key;
+	uint64_t 	row_id;
+	uint32_t 	index_id; // in the order of workload::indexes
+	uint32_t 	index_part;
+};
+
+class Checkpoint {
+public:
+	// snapshots all tables of `wl`. No txn may run.
+	void 		write(workload * wl);
+	// loads the snapshot and the redo log instead of generating the tables
+	void 		recover(workload * wl);
+	// the snapshot the tables equal at the start of the run, 0 if none
+	uint64_t 	get_ckpt_id() { return _ckpt_id; }
+
+	// records the index inserts of the load from now on, for dump_image()
+	void 		start_image_dump();
+	bool 		is_dumping_image() { return _index_log != NULL; }
+	void 		record_index(INDEX * index, uint64_t key, row_t * row, uint64_t index_part);
+	void 		dump_image(workload * wl, const char * path);
+	// builds the tables and indexes of `wl` on top of the image at `path`
+	void 		load_image(workload * wl, const char * path);
+private:
+	struct IndexRecord {
+		INDEX * 	index;
+		uint64_t 	key;
+		row_t * 	row;
+		uint64_t 	index_part;
+	};
+	struct ReplayEntry {
+		uint32_t 			table_id;
+		uint64_t 			row_id;
+		uint64_t 			seq;
+		uint64_t 			epoch;
+		LogRedoEntry * 		entry;
+		bool operator<(const ReplayEntry & e) const {
+			if (table_id != e.table_id)
+				return table_id < e.table_id;
+			if (row_id != e.row_id)
+				return row_id < e.row_id;
+			return seq < e.seq;
+		}
+	};
+	// runs job(0 .. job_cnt - 1) on up to g_init_parallelism threads
+	void 			run_parallel(void (Checkpoint::*job)(uint64_t), uint64_t job_cnt);
+	static void * 	run_jobs(void * This);
+	void 			write_part(uint64_t part_id);
+	void 			load_part(uint64_t part_id);
+	// collects the redo entries of log `log_id` per partition
+	void 			scan_log(uint64_t log_id);
+	void 			replay_part(uint64_t part_id);
+	void 			get_path(char * path, const char * name, uint64_t id);
+	void 			init_tables(workload * wl);
+	void 			write_image(const char * buffer, uint64_t len, uint64_t off);
+	void 			write_image_part(uint64_t part_id);
+	void 			load_image_part(uint64_t part_id);
+
+	workload * 				_wl;
+	vector<table_t *> 		_tables; // by table id
+	vector<INDEX *> 		_indexes; // by index id
+	uint64_t 				_ckpt_id;
+	// recovery
+	uint64_t 				_load_id;
+	volatile uint64_t 		_rows_loaded;
+	vector<char *> 			_logs;
+	vector<uint64_t> 		_log_sizes;
+	vector<uint64_t> 		_log_durable; // last epoch marker of each log
+	vector<char> 			_log_valid; // starts from the loaded snapshot
+	uint64_t 				_durable_epoch;
+	// [log_id * g_part_cnt + part_id]
+	vector<ReplayEntry> * 	_replay;
+	volatile uint64_t 		_entries_replayed;
+	// images. The index inserts are logged per partition of the row.
+	vector<IndexRecord> * 	_index_log;
+	pthread_mutex_t * 		_index_log_latches;
+	map<INDEX *, uint32_t> 	_index_ids;
+	int 					_image_fd;
+	char * 					_image;
+	ImageHeader * 			_image_header;
+	volatile uint64_t 		_index_loaded;
+	// job queue of run_parallel
+	void 					(Checkpoint::*_job)(uint64_t);
+	uint64_t 				_job_cnt;
+	volatile uint64_t 		_next_job;
+};
@@ -0,0 +1,67 @@
+#include "epoch_gc.h"
+
+void EpochGC::init() {
+	_epoch = (uint64_t *) _mm_malloc(CL_SIZE, CL_SIZE);
+	*_epoch = 1;
+	_thds = (ThdEpoch **) _mm_malloc(sizeof(ThdEpoch *) * g_thread_cnt, 64);
+	for (UInt32 i = 0; i < g_thread_cnt; i++) {
+		_thds[i] = (ThdEpoch *) _mm_malloc(sizeof(ThdEpoch), CL_SIZE);
+		_thds[i]->epoch = EPOCH_QUIESCENT;
+		_thds[i]->limbo = NULL;
+		_thds[i]->limbo_cnt = 0;
+	}
+}
+
+void EpochGC::enter(uint64_t thd_id) {
+	_thds[thd_id]->epoch = *_epoch;
+	// the pinned epoch must be visible before any shared pointer is read
+	__sync_synchronize();
+}
+
+void EpochGC::exit(uint64_t thd_id) {
+	COMPILER_BARRIER
+	_thds[thd_id]->epoch = EPOCH_QUIESCENT;
+	if (_thds[thd_id]->limbo_cnt >= GC_BATCH_SIZE)
+		collect(thd_id);
+}
+
+void EpochGC::retire(uint64_t thd_id, gc_node * node, void (*free_fn)(gc_node *)) {
+	ThdEpoch * thd = _thds[thd_id];
+	node->gc_epoch = *_epoch;
+	node->gc_free = free_fn;
+	node->gc_next = thd->limbo;
+	thd->limbo = node;
+	thd->limbo_cnt ++;
+}
+
+void EpochGC::collect(uint64_t thd_id) {
+	uint64_t min_epoch = EPOCH_QUIESCENT;
+	for (UInt32 i = 0; i < g_thread_cnt; i++) {
+		uint64_t e = _thds[i]->epoch;
+		if (e < min_epoch)
+			min_epoch = e;
+	}
+	uint64_t epoch = *_epoch;
+	if (min_epoch >= epoch)
+		ATOM_CAS(*_epoch, epoch, epoch + 1);
+
+	// entries retired before min_epoch are safe. The list is sorted by
+	// epoch, newest first, so they form a suffix.
+	ThdEpoch * thd = _thds[thd_id];
+	gc_node * prev = NULL;
+	gc_node * node = thd->limbo;
+	while (node != NULL && node->gc_epoch >= min_epoch) {
+		prev = node;
+		node = node->gc_next;
+	}
+	if (prev == NULL)
+		thd->limbo = NULL;
+	else
+		prev->gc_next = NULL;
+	while (node != NULL) {
+		gc_node * next = node->gc_next;
+		node->gc_free(node);
+		thd->limbo_cnt --;
+		node = next;
+	}
+}
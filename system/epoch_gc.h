@@ -0,0 +1,41 @@
+#pragma once
+
+#include "global.h"
+#include "helper.h"
+
+// Epoch-based memory reclamation. A worker pins the global epoch for the
+// whole txn. An object that is unlinked and retired in epoch e is freed once
+// no worker is pinned at e or earlier, so a reader never finds the memory
+// behind a pointer it still holds reused. Readers only write their own slot.
+
+#define EPOCH_QUIESCENT		UINT64_MAX
+
+// Anything handed to retire() starts with this header.
+struct gc_node {
+	gc_node * 			gc_next;
+	uint64_t 			gc_epoch;
+	void 				(*gc_free)(gc_node * node);
+};
+
+class EpochGC {
+public:
+	void 		init();
+	// pin / unpin the current epoch around a txn
+	void 		enter(uint64_t thd_id);
+	void 		exit(uint64_t thd_id);
+	// `node` must be unreachable for txns that start from now on.
+	void 		retire(uint64_t thd_id, gc_node * node, void (*free_fn)(gc_node *));
+private:
+	// advances the global epoch if every worker has caught up, then frees
+	// the limbo entries no pinned worker can see.
+	void 		collect(uint64_t thd_id);
+
+	struct ThdEpoch {
+		volatile uint64_t 	epoch; // EPOCH_QUIESCENT outside of a txn
+		gc_node * 			limbo; // newest first
+		uint64_t 			limbo_cnt;
+		char 				pad[CL_SIZE - sizeof(uint64_t) * 3];
+	};
+	volatile uint64_t * _epoch;
+	ThdEpoch ** 		_thds;
+};
@@ -7,6 +7,11 @@
 #include "plock.h"
 #include "occ.h"
 #include "vll.h"
+#include "epoch_gc.h"
+#include "logger.h"
+#include "checkpoint.h"
+#include "sampler.h"
+#include "abort_prof.h"
 
 mem_alloc mem_allocator;
 Stats stats;
@@ -15,9 +20,12 @@ Manager * glob_manager;
 Query_queue * query_queue;
 Plock part_lock_man;
 OptCC occ_man;
-#if CC_ALG == VLL
+EpochGC epoch_gc;
+LogManager log_manager;
+Checkpoint ckpt_man;
+Sampler sampler;
+AbortProf abort_prof;
 VLLMan vll_man;
-#endif 
 
 bool volatile warmup_finish = false;
 bool volatile enable_thread_mem_pool = false;
@@ -33,19 +41,30 @@ bool g_key_order = KEY_ORDER;
 bool g_no_dl = NO_DL;
 ts_t g_timeout = TIMEOUT;
 ts_t g_dl_loop_detect = DL_LOOP_DETECT;
+bool g_dl_detect_thread = DL_DETECT_THREAD;
 bool g_ts_batch_alloc = TS_BATCH_ALLOC;
 UInt32 g_ts_batch_num = TS_BATCH_NUM;
+bool g_read_only_snapshot = READ_ONLY_SNAPSHOT;
+bool g_log_redo = LOG_REDO;
+bool g_log_command = LOG_COMMAND;
+UInt32 g_log_thread_cnt = LOG_THREAD_CNT;
+bool g_checkpoint = CHECKPOINT;
+bool g_recover = RECOVER;
 
 bool g_part_alloc = PART_ALLOC;
 bool g_mem_pad = MEM_PAD;
 UInt32 g_cc_alg = CC_ALG; // Which concurrency control algorithm
 ts_t g_query_intvl = QUERY_INTVL;
+double g_arrival_rate = ARRIVAL_RATE;
+bool g_arrival_poisson = ARRIVAL_POISSON;
 UInt32 g_part_per_txn = PART_PER_TXN;
 double g_perc_multi_part = PERC_MULTI_PART;
 double g_read_perc = READ_PERC;
 double g_write_perc = WRITE_PERC;
 double g_zipf_theta = ZIPF_THETA;
 bool g_prt_lat_distr = PRT_LAT_DISTR;
+UInt32 g_sample_interval = SAMPLE_INTERVAL;
+bool g_prof_abort = PROF_ABORT;
 UInt32 g_part_cnt = PART_CNT;
 UInt32 g_virtual_part_cnt = VIRTUAL_PART_CNT; // Just our imaginary partition when generating data
 UInt32 g_thread_cnt = THREAD_CNT; // Number of threads to do txn
@@ -56,6 +75,9 @@ UInt32 g_init_parallelism = INIT_PARALLELISM;
 
 UInt32 g_num_wh = NUM_WH; // Num of warehouses, for TPCC
 double g_perc_payment = PERC_PAYMENT; // Percentage of payment transactions
+double g_perc_order_status = PERC_ORDER_STATUS;
+double g_perc_delivery = PERC_DELIVERY;
+double g_perc_stock_level = PERC_STOCK_LEVEL;
 bool g_wh_update = WH_UPDATE;
 char * output_file = NULL;
 
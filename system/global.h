@@ -11,6 +11,7 @@
 #include <string.h>
 #include <typeinfo>
 #include <list>
+#include <deque>
 #include <mm_malloc.h>
 #include <map>
 #include <set>
@@ -39,6 +40,11 @@ class Query_queue;
 class Plock;
 class OptCC;
 class VLLMan;
+class EpochGC;
+class LogManager;
+class Checkpoint;
+class Sampler;
+class AbortProf;
 
 typedef uint32_t UInt32;
 typedef int32_t SInt32;
@@ -57,9 +63,12 @@ extern Manager * glob_manager;
 extern Query_queue * query_queue;
 extern Plock part_lock_man;
 extern OptCC occ_man;
-#if CC_ALG == VLL
+extern EpochGC epoch_gc;
+extern LogManager log_manager;
+extern Checkpoint ckpt_man;
+extern Sampler sampler;
+extern AbortProf abort_prof;
 extern VLLMan vll_man;
-#endif
 
 extern bool volatile warmup_finish;
 extern bool volatile enable_thread_mem_pool;
@@ -74,6 +83,8 @@ extern carbon_barrier_t enable_barrier;
 extern bool g_part_alloc;
 extern bool g_mem_pad;
 extern bool g_prt_lat_distr;
+extern UInt32 g_sample_interval;
+extern bool g_prof_abort;
 extern UInt32 g_part_cnt;
 extern UInt32 g_virtual_part_cnt;
 extern UInt32 g_thread_cnt;
@@ -84,14 +95,23 @@ extern bool g_key_order;
 extern bool g_no_dl;
 extern ts_t g_timeout;
 extern ts_t g_dl_loop_detect;
+extern bool g_dl_detect_thread;
 extern bool g_ts_batch_alloc;
 extern UInt32 g_ts_batch_num;
+extern bool g_read_only_snapshot;
+extern bool g_log_redo;
+extern bool g_log_command;
+extern UInt32 g_log_thread_cnt;
+extern bool g_checkpoint;
+extern bool g_recover;
 
 extern map<string, string> g_params;
 
 // YCSB
 extern UInt32 g_cc_alg;
 extern ts_t g_query_intvl;
+extern double g_arrival_rate;
+extern bool g_arrival_poisson;
 extern UInt32 g_part_per_txn;
 extern double g_perc_multi_part;
 extern double g_read_perc;
@@ -105,6 +125,9 @@ extern UInt32 g_init_parallelism;
 // TPCC
 extern UInt32 g_num_wh;
 extern double g_perc_payment;
+extern double g_perc_order_status;
+extern double g_perc_delivery;
+extern double g_perc_stock_level;
 extern bool g_wh_update;
 extern char * output_file;
 extern UInt32 g_max_items;
@@ -138,6 +161,9 @@ enum access_t {RD, WR, XP, SCAN};
 enum lock_t {LOCK_EX, LOCK_SH, LOCK_NONE };
 /* TIMESTAMP where P=prewrite or pending? XP=cancelled or aborted P? */
 enum TsType {R_REQ, W_REQ, P_REQ, XP_REQ}; 
+/* why a txn aborted, for the abort profiler */
+enum AbortReason {ABORT_NONE, ABORT_CONFLICT, ABORT_WAIT_DIE, ABORT_DEADLOCK, ABORT_TIMEOUT, 
+	ABORT_TS_ORDER, ABORT_VERSION, ABORT_VALIDATE, ABORT_REASON_CNT};
 
 
 #define MSG(str, args...) { \
@@ -148,6 +174,10 @@ enum TsType {R_REQ, W_REQ, P_REQ, XP_REQ};
 // index structure for specific purposes. (e.g. non-primary key access should use hash)
 #if (INDEX_STRUCT == IDX_BTREE)
 #define INDEX		index_btree
+#elif (INDEX_STRUCT == IDX_BTREE_OLC)
+#define INDEX		index_btree_olc
+#elif (INDEX_STRUCT == IDX_HASH_LF)
+#define INDEX		IndexHashLF
 #else  // IDX_HASH
 #define INDEX		IndexHash
 #endif
@@ -158,4 +188,6 @@ enum TsType {R_REQ, W_REQ, P_REQ, XP_REQ};
 #ifndef UINT64_MAX
 #define UINT64_MAX 		18446744073709551615UL
 #endif // UINT64_MAX
+// the column mask of every column (row_t::copy)
+#define ALL_COLS 		UINT64_MAX
 
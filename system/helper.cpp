@@ -30,6 +30,9 @@ int get_thdid_from_txnid(uint64_t txnid) {
 }
 
 uint64_t get_part_id(void * addr) {
+	int64_t part_id = mem_allocator.get_part_id(addr);
+	if (part_id != -1)
+		return part_id;
 	return ((uint64_t)addr / PAGE_SIZE) % g_part_cnt; 
 }
 
@@ -0,0 +1,327 @@
+#include "logger.h"
+#include "manager.h"
+#include "txn.h"
+#include "row.h"
+#include "table.h"
+#include "query.h"
+// after global.h, whose lock_t clashes with the flock() constants
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <errno.h>
+
+void LogManager::init(uint64_t ckpt_id) {
+	assert((LOG_BUFFER_SIZE & (LOG_BUFFER_SIZE - 1)) == 0);
+	if (g_cc_alg == HSTORE && g_log_redo) {
+		// HSTORE writes rows in place without an access list
+		printf("HSTORE has no write set to redo log. Using command logging.\n");
+		g_log_redo = false;
+		g_log_command = true;
+	}
+	if (g_log_thread_cnt > g_thread_cnt)
+		g_log_thread_cnt = g_thread_cnt;
+	_durable_epoch = 0;
+	_stop = false;
+	_buffers = (LogBuffer **) _mm_malloc(sizeof(LogBuffer *) * g_thread_cnt, 64);
+	for (UInt32 i = 0; i < g_thread_cnt; i++) {
+		_buffers[i] = (LogBuffer *) _mm_malloc(sizeof(LogBuffer), CL_SIZE);
+		_buffers[i]->data = (char *) _mm_malloc(LOG_BUFFER_SIZE, PAGE_SIZE);
+		_buffers[i]->head = 0;
+		_buffers[i]->tail = 0;
+		_buffers[i]->epoch = LOG_IDLE_EPOCH;
+		_buffers[i]->pend_head = 0;
+		_buffers[i]->pend_tail = 0;
+	}
+	mkdir(LOG_DIR, 0755);
+	_loggers = (Logger **) _mm_malloc(sizeof(Logger *) * g_log_thread_cnt, 64);
+	for (UInt32 i = 0; i < g_log_thread_cnt; i++) {
+		Logger * lg = (Logger *) _mm_malloc(sizeof(Logger), CL_SIZE);
+		lg->man = this;
+		lg->id = i;
+		char path[1024];
+		snprintf(path, sizeof(path), "%s/log_%d", LOG_DIR, i);
+		// O_DIRECT is refused by some file systems (e.g. tmpfs)
+		lg->direct = true;
+		lg->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+		if (lg->fd < 0 && errno == EINVAL) {
+			lg->direct = false;
+			lg->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		}
+		M_ASSERT(lg->fd >= 0, "cannot open log file %s\n", path);
+		lg->stage = (char *) _mm_malloc(LOG_BUFFER_SIZE, PAGE_SIZE);
+		lg->stage_len = 0;
+		lg->file_off = 0;
+		lg->durable = 0;
+		LogRecord marker;
+		memset(&marker, 0, sizeof(LogRecord));
+		marker.size = sizeof(LogRecord);
+		marker.type = LOG_REC_EPOCH;
+		marker.seq = ckpt_id;
+		stage(lg, (char *) &marker, sizeof(LogRecord));
+		_loggers[i] = lg;
+	}
+}
+
+void LogManager::start() {
+	for (UInt32 i = 0; i < g_log_thread_cnt; i++)
+		pthread_create(&_loggers[i]->thd, NULL, run_logger, _loggers[i]);
+}
+
+void LogManager::stop() {
+	_stop = true;
+	for (UInt32 i = 0; i < g_log_thread_cnt; i++) {
+		pthread_join(_loggers[i]->thd, NULL);
+		close(_loggers[i]->fd);
+	}
+	// everything is durable now
+	for (UInt32 i = 0; i < g_thread_cnt; i++)
+		ack(i);
+}
+
+void * LogManager::run_logger(void * logger) {
+	Logger * lg = (Logger *) logger;
+	lg->man->run(lg);
+	return NULL;
+}
+
+void LogManager::run(Logger * lg) {
+	while (!_stop) {
+		// logger 0 also drives the global epoch
+		if (lg->id == 0)
+			glob_manager->update_epoch();
+		flush(lg, false);
+		usleep(LOG_BATCH_TIME * 1000 / 10);
+	}
+	flush(lg, true);
+}
+
+void LogManager::log_txn(txn_man * txn, ts_t seq) {
+	uint64_t starttime = get_sys_clock();
+	uint64_t thd_id = txn->get_thd_id();
+	LogBuffer * buf = _buffers[thd_id];
+	// publish a lower bound of our epoch before reading it, so that a logger
+	// never declares the epoch durable while our record is in flight.
+	buf->epoch = glob_manager->get_epoch();
+	__sync_synchronize();
+	uint64_t epoch = glob_manager->get_epoch();
+
+	LogRecord rec;
+	rec.size = sizeof(LogRecord);
+	rec.epoch = epoch;
+	rec.seq = seq;
+	rec.txn_id = txn->get_txn_id();
+	rec.entry_cnt = 0;
+	rec.thd_id = thd_id;
+	uint32_t cmd_size = 0;
+	if (g_log_redo) {
+		rec.type = LOG_REC_REDO;
+		for (int rid = 0; rid < txn->row_cnt; rid ++) {
+			if (txn->accesses[rid]->type != WR)
+				continue;
+			rec.size += sizeof(LogRedoEntry) + LOG_ALIGN(txn->accesses[rid]->orig_row->get_tuple_size());
+			rec.entry_cnt ++;
+		}
+		for (uint64_t i = 0; i < txn->insert_cnt; i ++) {
+			rec.size += sizeof(LogRedoEntry) + LOG_ALIGN(txn->insert_rows[i]->get_tuple_size());
+			rec.entry_cnt ++;
+		}
+	} else {
+		rec.type = LOG_REC_CMD;
+		if (txn->cur_query != NULL)
+			cmd_size = txn->cur_query->get_cmd_size();
+		rec.size += LOG_ALIGN(cmd_size);
+	}
+	// read-only txns leave nothing to replay. HSTORE has no write set, so
+	// all of its txns are logged.
+	if (txn->wr_cnt > 0 || txn->insert_cnt > 0 || g_cc_alg == HSTORE) {
+		assert(rec.size <= LOG_BUFFER_SIZE);
+		uint64_t pos = buf->head;
+		while (pos + rec.size - buf->tail > LOG_BUFFER_SIZE)
+			PAUSE
+		append(buf, pos, &rec, sizeof(LogRecord));
+		pos += sizeof(LogRecord);
+		if (g_log_redo) {
+			for (int rid = 0; rid < txn->row_cnt; rid ++) {
+				if (txn->accesses[rid]->type != WR)
+					continue;
+				row_t * row = txn->accesses[rid]->orig_row;
+				LogRedoEntry entry;
+				entry.table_id = row->get_table()->get_table_id();
+				entry.size = row->get_tuple_size();
+				entry.part_id = row->get_part_id();
+				entry.insert = 0;
+				entry.row_id = row->get_row_id();
+				entry.primary_key = row->get_primary_key();
+				append(buf, pos, &entry, sizeof(LogRedoEntry));
+				pos += sizeof(LogRedoEntry);
+				char tuple[MAX_TUPLE_SIZE];
+				append(buf, pos, txn->accesses[rid]->data->get_tuple(tuple), entry.size);
+				pos += LOG_ALIGN(entry.size);
+			}
+			for (uint64_t i = 0; i < txn->insert_cnt; i ++) {
+				row_t * row = txn->insert_rows[i];
+				LogRedoEntry entry;
+				entry.table_id = row->get_table()->get_table_id();
+				entry.size = row->get_tuple_size();
+				entry.part_id = row->get_part_id();
+				entry.insert = 1;
+				entry.row_id = row->get_row_id();
+				entry.primary_key = row->get_primary_key();
+				append(buf, pos, &entry, sizeof(LogRedoEntry));
+				pos += sizeof(LogRedoEntry);
+				char tuple[MAX_TUPLE_SIZE];
+				append(buf, pos, row->get_tuple(tuple), entry.size);
+				pos += LOG_ALIGN(entry.size);
+			}
+		} else {
+			char cmd[cmd_size];
+			if (cmd_size > 0)
+				txn->cur_query->write_cmd(cmd);
+			append(buf, pos, cmd, cmd_size);
+			pos += LOG_ALIGN(cmd_size);
+		}
+		// the record must be in the ring before the logger sees the new head
+		COMPILER_BARRIER
+		buf->head = pos;
+		INC_STATS(thd_id, log_bytes, rec.size);
+	}
+	COMPILER_BARRIER
+	buf->epoch = LOG_IDLE_EPOCH;
+
+	add_pending(thd_id, epoch, get_sys_clock());
+	ack(thd_id);
+	INC_STATS(thd_id, time_log, get_sys_clock() - starttime);
+}
+
+void LogManager::append(LogBuffer * buf, uint64_t pos, const void * src, uint64_t size) {
+	uint64_t off = pos % LOG_BUFFER_SIZE;
+	uint64_t n = min(size, LOG_BUFFER_SIZE - off);
+	memcpy(buf->data + off, src, n);
+	if (n < size)
+		memcpy(buf->data, (const char *)src + n, size - n);
+}
+
+void LogManager::add_pending(uint64_t thd_id, uint64_t epoch, ts_t time) {
+	LogBuffer * buf = _buffers[thd_id];
+	uint32_t last = (buf->pend_tail + LOG_PENDING_EPOCHS - 1) % LOG_PENDING_EPOCHS;
+	if (buf->pend_head == buf->pend_tail || buf->pend_epoch[last] != epoch) {
+		// the loggers are LOG_PENDING_EPOCHS epochs behind, wait for them
+		while ((buf->pend_tail + 1) % LOG_PENDING_EPOCHS == buf->pend_head) {
+			usleep(LOG_BATCH_TIME * 1000 / 10);
+			ack(thd_id);
+		}
+		last = buf->pend_tail;
+		buf->pend_epoch[last] = epoch;
+		buf->pend_cnt[last] = 0;
+		buf->pend_time[last] = 0;
+		buf->pend_tail = (last + 1) % LOG_PENDING_EPOCHS;
+	}
+	buf->pend_cnt[last] ++;
+	buf->pend_time[last] += time;
+}
+
+void LogManager::ack(uint64_t thd_id) {
+	LogBuffer * buf = _buffers[thd_id];
+	uint64_t durable = _durable_epoch;
+	ts_t now = get_sys_clock();
+	while (buf->pend_head != buf->pend_tail
+		&& buf->pend_epoch[buf->pend_head] <= durable)
+	{
+		uint32_t i = buf->pend_head;
+		INC_STATS(thd_id, log_ack_cnt, buf->pend_cnt[i]);
+		INC_STATS(thd_id, log_ack_time, now * buf->pend_cnt[i] - buf->pend_time[i]);
+		buf->pend_head = (i + 1) % LOG_PENDING_EPOCHS;
+	}
+}
+
+void LogManager::flush(Logger * lg, bool last) {
+	// a worker outside of log_txn commits its next txn in the current
+	// epoch or later. One inside may still add to the epoch it published.
+	uint64_t min_epoch = last? LOG_IDLE_EPOCH : glob_manager->get_epoch();
+	__sync_synchronize();
+	for (UInt32 i = lg->id; i < g_thread_cnt; i += g_log_thread_cnt) {
+		uint64_t epoch = _buffers[i]->epoch;
+		if (epoch < min_epoch)
+			min_epoch = epoch;
+	}
+	__sync_synchronize();
+	// every record of an epoch below min_epoch is in the rings now
+	for (UInt32 i = lg->id; i < g_thread_cnt; i += g_log_thread_cnt) {
+		LogBuffer * buf = _buffers[i];
+		uint64_t head = buf->head;
+		uint64_t tail = buf->tail;
+		if (head == tail)
+			continue;
+		uint64_t off = tail % LOG_BUFFER_SIZE;
+		uint64_t n = min(head - tail, LOG_BUFFER_SIZE - off);
+		stage(lg, buf->data + off, n);
+		if (n < head - tail)
+			stage(lg, buf->data, head - tail - n);
+		COMPILER_BARRIER
+		buf->tail = head;
+	}
+	uint64_t durable = (min_epoch == LOG_IDLE_EPOCH)?
+		glob_manager->get_epoch() : min_epoch - 1;
+	if (durable <= lg->durable)
+		return;
+	// the marker is written only after the records it covers are on disk
+	write_stage(lg);
+	sync(lg);
+	LogRecord marker;
+	memset(&marker, 0, sizeof(LogRecord));
+	marker.size = sizeof(LogRecord);
+	marker.type = LOG_REC_EPOCH;
+	marker.epoch = durable;
+	stage(lg, (char *) &marker, sizeof(LogRecord));
+	write_stage(lg);
+	sync(lg);
+	lg->durable = durable;
+
+	// the system is durable up to the slowest logger
+	uint64_t min_durable = durable;
+	for (UInt32 i = 0; i < g_log_thread_cnt; i++)
+		if (_loggers[i]->durable < min_durable)
+			min_durable = _loggers[i]->durable;
+	uint64_t old = _durable_epoch;
+	while (old < min_durable && !ATOM_CAS(_durable_epoch, old, min_durable))
+		old = _durable_epoch;
+}
+
+void LogManager::stage(Logger * lg, const char * src, uint64_t size) {
+	while (size > 0) {
+		uint64_t n = min(size, LOG_BUFFER_SIZE - lg->stage_len);
+		memcpy(lg->stage + lg->stage_len, src, n);
+		lg->stage_len += n;
+		src += n;
+		size -= n;
+		if (lg->stage_len == LOG_BUFFER_SIZE)
+			write_stage(lg);
+	}
+}
+
+void LogManager::write_stage(Logger * lg) {
+	// O_DIRECT writes whole blocks. The partial last block stays in the
+	// stage and is written again, at the same offset, with the next batch.
+	uint64_t len = (lg->stage_len + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+	memset(lg->stage + lg->stage_len, 0, len - lg->stage_len);
+	uint64_t done = 0;
+	while (done < len) {
+		ssize_t ret = pwrite(lg->fd, lg->stage + done, len - done, lg->file_off + done);
+		if (ret < 0 && errno == EINVAL && lg->direct) {
+			// the file system took O_DIRECT at open but refuses the write
+			fcntl(lg->fd, F_SETFL, fcntl(lg->fd, F_GETFL) & ~O_DIRECT);
+			lg->direct = false;
+			continue;
+		}
+		M_ASSERT(ret > 0, "log write failed: %s\n", strerror(errno));
+		done += ret;
+	}
+	uint64_t full = lg->stage_len & ~(PAGE_SIZE - 1);
+	memmove(lg->stage, lg->stage + full, lg->stage_len - full);
+	lg->stage_len -= full;
+	lg->file_off += full;
+}
+
+void LogManager::sync(Logger * lg) {
+	int ret = fdatasync(lg->fd);
+	M_ASSERT(ret == 0, "log fdatasync failed: %s\n", strerror(errno));
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "global.h"
+#include "helper.h"
+
+class txn_man;
+
+// Epoch-based group commit, as in Silo. A committing worker appends its
+// record to its own ring buffer, tagged with the global epoch read at the
+// serialization point of the txn. Logger threads drain the rings of their
+// workers into one file each and persist whole epochs with one fdatasync.
+// A txn of epoch e is acknowledged once every logger has persisted e.
+// Workers never wait on each other or on a lock to log.
+
+enum LogRecType { LOG_REC_REDO = 1, LOG_REC_CMD, LOG_REC_EPOCH };
+
+// Header of every record. Records are padded to 8 bytes. A record with size
+// 0 marks the end of the file.
+struct LogRecord {
+	uint32_t 	size; // bytes including this header
+	uint32_t 	type;
+	// [LOG_REC_EPOCH] every epoch up to this one is complete in all files
+	uint64_t 	epoch;
+	// commit order of the txn. Txns writing the same row have increasing seq.
+	// The first record of a file is an epoch 0 marker whose seq is the id of
+	// the checkpoint the log starts from, 0 if there is none.
+	uint64_t 	seq;
+	uint64_t 	txn_id;
+	uint32_t 	entry_cnt; // [LOG_REC_REDO] rows written
+	uint32_t 	thd_id;
+};
+
+// [LOG_REC_REDO] after-image of one row. `size` bytes of tuple follow.
+// Checkpoints store rows in the same format, a hole without a tuple.
+struct LogRedoEntry {
+	uint32_t 	table_id;
+	uint32_t 	size;
+	uint32_t 	part_id;
+	uint32_t 	insert; // the image the row was inserted with
+	uint64_t 	row_id; // position of the row in its partition of the table
+	uint64_t 	primary_key;
+};
+
+#define LOG_IDLE_EPOCH		UINT64_MAX
+// epochs a worker may have committed in that are not durable yet
+#define LOG_PENDING_EPOCHS	64
+#define LOG_ALIGN(size)		(((size) + 7) & ~7UL)
+
+class LogManager {
+public:
+	void 		init(uint64_t ckpt_id);
+	// spawn the logger threads / flush what is left and join them
+	void 		start();
+	void 		stop();
+	// appends the commit record of `txn`. Called at the serialization point,
+	// while the write set of the txn is still protected.
+	void 		log_txn(txn_man * txn, ts_t seq);
+	// every epoch up to this one is on disk
+	uint64_t 	get_durable_epoch() { return _durable_epoch; }
+private:
+	// the ring of one worker. `head` and `epoch` are written by the worker,
+	// `tail` by its logger.
+	struct LogBuffer {
+		char * 				data;
+		volatile uint64_t 	head; // bytes published
+		volatile uint64_t 	epoch; // LOG_IDLE_EPOCH outside of log_txn
+		char 				pad1[CL_SIZE - sizeof(uint64_t) * 3];
+		volatile uint64_t 	tail; // bytes drained
+		char 				pad2[CL_SIZE - sizeof(uint64_t)];
+		// committed txns per epoch, waiting for the epoch to be durable
+		uint64_t 			pend_epoch[LOG_PENDING_EPOCHS];
+		uint64_t 			pend_cnt[LOG_PENDING_EPOCHS];
+		uint64_t 			pend_time[LOG_PENDING_EPOCHS]; // sum of commit times
+		uint32_t 			pend_head;
+		uint32_t 			pend_tail;
+	};
+	struct Logger {
+		LogManager * 		man;
+		uint32_t 			id;
+		int 				fd;
+		bool 				direct; // fd is opened with O_DIRECT
+		pthread_t 			thd;
+		// the unwritten end of the file, starting at the block at file_off
+		char * 				stage;
+		uint64_t 			stage_len;
+		uint64_t 			file_off;
+		volatile uint64_t 	durable;
+	};
+	static void * 	run_logger(void * logger);
+	void 			run(Logger * lg);
+	// drains the rings of `lg` and persists the epochs all its workers
+	// are done with. On the last call every worker has exited.
+	void 			flush(Logger * lg, bool last);
+	void 			stage(Logger * lg, const char * src, uint64_t size);
+	void 			write_stage(Logger * lg);
+	void 			sync(Logger * lg);
+	// copies into the ring of `buf` at byte `pos`, wrapping around its end
+	void 			append(LogBuffer * buf, uint64_t pos, const void * src, uint64_t size);
+	// counts a commit of `epoch` / retires the txns whose epoch is durable
+	void 			add_pending(uint64_t thd_id, uint64_t epoch, ts_t time);
+	void 			ack(uint64_t thd_id);
+
+	LogBuffer ** 		_buffers;
+	Logger ** 			_loggers;
+	volatile uint64_t 	_durable_epoch;
+	volatile bool 		_stop;
+};
@@ -9,6 +9,11 @@
 #include "plock.h"
 #include "occ.h"
 #include "vll.h"
+#include "epoch_gc.h"
+#include "logger.h"
+#include "checkpoint.h"
+#include "sampler.h"
+#include "abort_prof.h"
 
 void * f(void *);
 
@@ -27,6 +32,8 @@ int main(int argc, char* argv[])
 	glob_manager->init();
 	if (g_cc_alg == DL_DETECT) 
 		dl_detector.init();
+	if (g_cc_alg == MVCC || g_cc_alg == HEKATON || g_cc_alg == SILO)
+		epoch_gc.init();
 	printf("mem_allocator initialized!\n");
 	workload * m_wl;
 	switch (WORKLOAD) {
@@ -41,8 +48,16 @@ int main(int argc, char* argv[])
 		default:
 			assert(false);
 	}
+	if (g_params["dump-image"] != "")
+		ckpt_man.start_image_dump();
 	m_wl->init();
 	printf("workload initialized!\n");
+	if (g_prof_abort)
+		abort_prof.init(m_wl);
+	if (g_params["dump-image"] != "") {
+		ckpt_man.dump_image(m_wl, g_params["dump-image"].c_str());
+		return 0;
+	}
 	
 	uint64_t thd_cnt = g_thread_cnt;
 	pthread_t p_thds[thd_cnt - 1];
@@ -56,16 +71,23 @@ int main(int argc, char* argv[])
 		query_queue->init(m_wl);
 	pthread_barrier_init( &warmup_bar, NULL, g_thread_cnt );
 	printf("query_queue initialized!\n");
-#if CC_ALG == HSTORE
-	part_lock_man.init();
-#elif CC_ALG == OCC
-	occ_man.init();
-#elif CC_ALG == VLL
-	vll_man.init();
-#endif
+	if (g_cc_alg == HSTORE)
+		part_lock_man.init();
+	else if (g_cc_alg == OCC)
+		occ_man.init();
+	else if (g_cc_alg == VLL)
+		vll_man.init();
 	// Master thread init all TCBs, same m_wl for all
 	for (uint32_t i = 0; i < thd_cnt; i++) 
 		m_thds[i]->init(i, m_wl);
+	bool logging = g_log_redo || g_log_command;
+	// the log starts over, so a recovered state must be saved first
+	if (g_checkpoint || (g_recover && logging))
+		ckpt_man.write(m_wl);
+	if (logging) {
+		log_manager.init(ckpt_man.get_ckpt_id());
+		log_manager.start();
+	}
 
 	if (WARMUP > 0){
 		printf("WARMUP start!\n");
@@ -85,7 +107,11 @@ int main(int argc, char* argv[])
 #endif
 	pthread_barrier_init( &warmup_bar, NULL, g_thread_cnt );
 
+	if (g_cc_alg == DL_DETECT && g_dl_detect_thread && !g_no_dl)
+		dl_detector.start();
 	// spawn and run txns again.
+	if (g_sample_interval > 0 && STATS_ENABLE)
+		sampler.start(g_params["sample-file"].c_str());
 	int64_t starttime = get_server_clock();
 	for (uint32_t i = 0; i < thd_cnt - 1; i++) {
 		uint64_t vid = i;
@@ -95,11 +121,19 @@ int main(int argc, char* argv[])
 	for (uint32_t i = 0; i < thd_cnt - 1; i++) 
 		pthread_join(p_thds[i], NULL);
 	int64_t endtime = get_server_clock();
+	if (g_sample_interval > 0 && STATS_ENABLE)
+		sampler.stop();
+	if (g_cc_alg == DL_DETECT && g_dl_detect_thread && !g_no_dl)
+		dl_detector.stop();
+	if (logging)
+		log_manager.stop();
 	
 	if (WORKLOAD != TEST) {
 		printf("PASS! SimTime = %ld\n", endtime - starttime);
 		if (STATS_ENABLE)
 			stats.print();
+		if (g_prof_abort)
+			abort_prof.print();
 	} else {
 		((TestWorkload *)m_wl)->summarize();
 	}
@@ -6,23 +6,25 @@
 void Manager::init() {
 	timestamp = (uint64_t *) _mm_malloc(sizeof(uint64_t), 64); // NOTE: Why alloc on heap instead of BSS?
 	*timestamp = 1;
-	_last_min_ts_time = 0;
-	_min_ts = 0;
 	_epoch = (uint64_t *) _mm_malloc(sizeof(uint64_t), 64);
 	_last_epoch_update_time = (ts_t *) _mm_malloc(sizeof(uint64_t), 64);
-	_epoch = 0;
-	_last_epoch_update_time = 0;
-	all_ts = (ts_t volatile **) _mm_malloc(sizeof(ts_t *) * g_thread_cnt, 64); // Store address of each thd's txn ts
-	for (uint32_t i = 0; i < g_thread_cnt; i++) 
-		all_ts[i] = (ts_t *) _mm_malloc(sizeof(ts_t), 64);
+	*_epoch = 1; // epoch 0 is durable before anything is logged
+	*_last_epoch_update_time = 0;
+	_active_ts.init(g_thread_cnt);
+	_snapshot_ts.init(g_thread_cnt);
 
 	_all_txns = new txn_man * [g_thread_cnt];
-	for (UInt32 i = 0; i < g_thread_cnt; i++) { // Store addr of each thd's txn manager
-		*all_ts[i] = UINT64_MAX; // NOTE: How do we handle overflow?
+	for (UInt32 i = 0; i < g_thread_cnt; i++) // Store addr of each thd's txn manager
 		_all_txns[i] = NULL;
-	}
 	for (UInt32 i = 0; i < BUCKET_CNT; i++)
 		pthread_mutex_init( &mutexes[i], NULL );
+	_clocks = (LocalClock *) _mm_malloc(sizeof(LocalClock) * g_thread_cnt, CL_SIZE);
+	for (UInt32 i = 0; i < g_thread_cnt; i++) {
+		_clocks[i].clock = 0;
+		_clocks[i].offset = 0;
+		_clocks[i].last_sync = 0;
+		_clocks[i].peer = i;
+	}
 }
 
 uint64_t 
@@ -53,6 +55,9 @@ Manager::get_ts(uint64_t thread_id) { // Default: no batch, using CAS
 	case TS_CLOCK :
 		time = get_sys_clock() * g_thread_cnt + thread_id;
 		break;
+	case TS_LOCAL_CLOCK :
+		time = get_local_ts(thread_id, starttime);
+		break;
 	default :
 		assert(false);
 	}
@@ -60,25 +65,35 @@ Manager::get_ts(uint64_t thread_id) { // Default: no batch, using CAS
 	return time;
 }
 
-ts_t Manager::get_min_ts(uint64_t tid) {
-	uint64_t now = get_sys_clock();
-	uint64_t last_time = _last_min_ts_time; 
-	if (tid == 0 && now - last_time > MIN_TS_INTVL) // Let thread 0 maintain the minimum ts
-	{ 
-		ts_t min = UINT64_MAX;
-    		for (UInt32 i = 0; i < g_thread_cnt; i++) // NOTE: it might be ok to read an outdated ts so we won't lock? Thus `_min_ts` might also be outdated
-			if (*all_ts[i] < min)
-		    	    	min = *all_ts[i];
-		if (min > _min_ts)
-			_min_ts = min;
+ts_t Manager::get_local_ts(uint64_t thread_id, ts_t now) {
+	LocalClock * c = &_clocks[thread_id];
+	ts_t clock = now + c->offset;
+	if (clock <= c->clock)
+		clock = c->clock + 1;
+	if (now - c->last_sync > TS_SYNC_INTVL && g_thread_cnt > 1) {
+		c->last_sync = now;
+		c->peer = (c->peer + 1) % g_thread_cnt;
+		if (c->peer == thread_id)
+			c->peer = (c->peer + 1) % g_thread_cnt;
+		ts_t peer_clock = _clocks[c->peer].clock;
+		if (peer_clock > clock) {
+			c->offset += peer_clock - clock;
+			clock = peer_clock;
+		}
 	}
-	return _min_ts;
+	c->clock = clock;
+	// ties between threads go to the lower thread id
+	return clock * g_thread_cnt + thread_id;
 }
 
-void Manager::add_ts(uint64_t thd_id, ts_t ts) {
-	assert( ts >= *all_ts[thd_id] || 
-		*all_ts[thd_id] == UINT64_MAX);
-	*all_ts[thd_id] = ts;
+ts_t Manager::add_ts(uint64_t thd_id, ts_t ts) {
+	_active_ts.publish(thd_id, ts);
+	// A thread publishes a new ts only after its last txn is done, and ts
+	// grow per thread, so no txn below the mark runs any more. The mark
+	// only grows, like the leaves.
+	ts_t snapshot = _active_ts.get();
+	_snapshot_ts.publish(thd_id, snapshot);
+	return snapshot;
 }
 // Each thread registers its txn in global structure
 void Manager::set_txn_man(txn_man * txn) {
@@ -106,8 +121,9 @@ void
 Manager::update_epoch()
 {
 	ts_t time = get_sys_clock();
-	if (time - *_last_epoch_update_time > LOG_BATCH_TIME * 1000 * 1000) {
-		*_epoch = *_epoch + 1;
-		*_last_epoch_update_time = time;
-	}
+	ts_t last = *_last_epoch_update_time;
+	// whoever moves the update time advances the epoch
+	if (time - last > LOG_BATCH_TIME * 1000 * 1000
+			&& ATOM_CAS(*_last_epoch_update_time, last, time))
+		ATOM_ADD(*_epoch, 1);
 }
@@ -2,6 +2,7 @@
 
 #include "helper.h"
 #include "global.h"
+#include "watermark.h"
 
 class row_t;
 class txn_man;
@@ -13,10 +14,11 @@ public:
 	ts_t			get_ts(uint64_t thread_id);
 
 	// Each thread will call this to register their `ts` in global manager
-	// For MVCC. To calculate the min active ts in the system
-	void 			add_ts(uint64_t thd_id, ts_t ts);
-	// Returns (an estimation of) minimum (registered) ts of running txn
-	ts_t 			get_min_ts(uint64_t tid = 0);
+	// For MVCC. To calculate the min active ts in the system. Returns a
+	// snapshot ts: every txn with a smaller ts is done.
+	ts_t 			add_ts(uint64_t thd_id, ts_t ts);
+	// Returns a lower bound of the oldest snapshot a running txn can read
+	ts_t 			get_min_ts(uint64_t tid = 0) { return _snapshot_ts.get(); }
 
 	// HACK! the following mutexes are used to model a centralized
 	// lock/timestamp manager. 
@@ -30,19 +32,33 @@ public:
 	uint64_t 		get_epoch() { return *_epoch; };
 	void 	 		update_epoch();
 private:
-	// for SILO
+	// [TS_LOCAL_CLOCK] the clock of one thread, as in Cicada. Timestamps are
+	// the local clock times g_thread_cnt plus the thread id, so they are
+	// unique without any shared write. Every TS_SYNC_INTVL a thread reads
+	// the clock of one other thread, round robin, and jumps ahead to it if
+	// it lags behind, which bounds the skew between the clocks.
+	struct LocalClock {
+		volatile ts_t 	clock; // last time handed out
+		ts_t 			offset; // added to get_sys_clock()
+		ts_t 			last_sync;
+		uint32_t 		peer;
+		char 			pad[CL_SIZE - sizeof(ts_t) * 3 - sizeof(uint32_t)];
+	};
+	ts_t 			get_local_ts(uint64_t thread_id, ts_t now);
+	LocalClock * 	_clocks;
+	// for SILO and logging. Advanced every LOG_BATCH_TIME ms by logger 0, or
+	// by the SILO workers when nothing is logged.
 	volatile uint64_t * _epoch;		
-	ts_t * 			_last_epoch_update_time;
+	volatile ts_t * _last_epoch_update_time;
 
 	pthread_mutex_t ts_mutex;
 	uint64_t *		timestamp; // NOTE: Why alloc on heap instead of BSS?
 	pthread_mutex_t mutexes[BUCKET_CNT]; // NOTE: Why fixed?
 	uint64_t 		hash(row_t * row);
-	// All timestamps registered my threads
-	// NOTE: volatile means both the value and the pointers can change
-	ts_t volatile * volatile * volatile all_ts;
+	// All timestamps registered my threads, for MVCC and HEKATON
+	Watermark 		_active_ts;
+	// the snapshot ts each thread got from add_ts. Versions a running txn
+	// may read are newer than its mark.
+	Watermark 		_snapshot_ts;
 	txn_man ** 		_all_txns;
-	// for MVCC 
-	volatile ts_t	_last_min_ts_time; // Last walltime when we maintain `_min_ts`. But why not updated? Always 0?
-	ts_t			_min_ts; // Min ts of all running txn, only updated when necessary
 };
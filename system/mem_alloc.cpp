@@ -1,138 +1,222 @@
 #include "mem_alloc.h"
 #include "helper.h"
 #include "global.h"
+#include <sys/mman.h>
+#include <numa.h>
+
+// slab caches of the calling thread, NULL if it is not registered
+static __thread SlabCache * tls_caches = NULL;
+static __thread UInt32 tls_thd_id = 0;
 
 // Assume the data is strided across the L2 slices, stride granularity 
 // is the size of a page
 void mem_alloc::init(uint64_t part_cnt, uint64_t bytes_per_part) {
-	if (g_thread_cnt < g_init_parallelism) // Compute number of buckets
-		_bucket_cnt = g_init_parallelism * 4 + 1;
-	else
-		_bucket_cnt = g_thread_cnt * 4 + 1;
-	pid_arena = new std::pair<pthread_t, int>[_bucket_cnt]; // Map threadID to bucketID (memory pool)
-	for (int i = 0; i < _bucket_cnt; i ++)
-		pid_arena[i] = std::make_pair(0, 0); // Init: not owned by anyone
-
-	if (THREAD_ALLOC) {
-		assert( !g_part_alloc );
+	_caches = NULL;
+	_slab_base = NULL;
+	_slab_used = 0;
+	_part_arenas = NULL;
+	_part_base = NULL;
+	if (THREAD_ALLOC)
 		init_thread_arena();
+	if (g_part_alloc)
+		init_part_arena(part_cnt, bytes_per_part);
+}
+
+void mem_alloc::init_part_arena(uint64_t part_cnt, uint64_t bytes_per_part) {
+	_part_cnt = part_cnt;
+	_bytes_per_part = (bytes_per_part + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+	// One reservation for all partitions. Pages are only backed when touched.
+	_part_base = (char *) mmap(NULL, _part_cnt * _bytes_per_part, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	M_ASSERT(_part_base != MAP_FAILED, "cannot reserve %ld bytes for partitions\n",
+		_part_cnt * _bytes_per_part);
+	// Consecutive partitions go to the same node, like consecutive threads
+	// share a socket.
+	int node_cnt = (numa_available() < 0)? 1 : numa_num_configured_nodes();
+	_part_arenas = (PartArena *) _mm_malloc(sizeof(PartArena) * _part_cnt, CL_SIZE);
+	for (uint64_t i = 0; i < _part_cnt; i++) {
+		char * base = _part_base + i * _bytes_per_part;
+		if (node_cnt > 1)
+			numa_tonode_memory(base, _bytes_per_part, i * node_cnt / _part_cnt);
+		_part_arenas[i].init(base, _bytes_per_part);
 	}
 }
 
 void 
-Arena::init(int arena_id, int size) {
-	_buffer = NULL;
-	_arena_id = arena_id;
-	_size_in_buffer = 0;
-	_head = NULL;
-	_block_size = size;
+PartArena::init(char * base, uint64_t size) {
+	_base = base;
+	_size = size;
+	_used = 0;
+}
+
+void * 
+PartArena::alloc(uint64_t size) {
+	// blocks of a cache line or more start on a line of their own
+	uint64_t align = (size >= CL_SIZE)? CL_SIZE : MEM_ALLIGN;
+	uint64_t used, start;
+	do {
+		used = _used;
+		start = (used + align - 1) & ~(align - 1);
+		if (start + size > _size)
+			return NULL;
+	} while (!ATOM_CAS(_used, used, start + size));
+	return _base + start;
+}
+
+void 
+SlabCache::init() {
+	_local = NULL;
+	_remote = NULL;
 }
 
 void *
-Arena::alloc() {
-	FreeBlock * block;
-	if (_head == NULL) {
-		// not in the list. allocate from the buffer
-		int size = (_block_size + sizeof(FreeBlock) + (MEM_ALLIGN - 1)) & ~(MEM_ALLIGN-1);
-		if (_size_in_buffer < size) {
-			_buffer = (char *) malloc(_block_size * 40960);
-			_size_in_buffer = _block_size * 40960; // * 8;
-		}
-		block = (FreeBlock *)_buffer;
-		block->size = _block_size;
-		_size_in_buffer -= size;
-		_buffer = _buffer + size;
-	} else {
-		block = _head;
-		_head = _head->next;
+SlabCache::alloc() {
+	if (_local == NULL && _remote != NULL) {
+		// take over everything other threads have given back
+		FreeBlock * head;
+		do {
+			head = _remote;
+		} while (!ATOM_CAS(_remote, head, NULL));
+		_local = head;
+	}
+	if (_local != NULL) {
+		FreeBlock * block = _local;
+		_local = block->next;
+		return block;
+	}
+	return NULL;
+}
+
+void 
+SlabCache::refill(char * slab) {
+	UInt32 size = BlockSizes[ ((SlabHeader *) slab)->size_id ];
+	// Blocks are laid out from the end of the slab, so a block of CL_SIZE or
+	// more is cache-line aligned. Lowest address comes out first.
+	FreeBlock * prev = _local;
+	for (char * p = slab + SLAB_SIZE - size; p >= slab + sizeof(SlabHeader); p -= size) {
+		((FreeBlock *) p)->next = prev;
+		prev = (FreeBlock *) p;
 	}
-	return (void *) ((char *)block + sizeof(FreeBlock));
+	_local = prev;
 }
 
 void
-Arena::free(void * ptr) {
-	FreeBlock * block = (FreeBlock *)((UInt64)ptr - sizeof(FreeBlock));
-	block->next = _head;
-	_head = block;
+SlabCache::free_local(void * ptr) {
+	FreeBlock * block = (FreeBlock *) ptr;
+	block->next = _local;
+	_local = block;
+}
+
+void
+SlabCache::free_remote(void * ptr) {
+	FreeBlock * block = (FreeBlock *) ptr;
+	FreeBlock * head;
+	do {
+		head = _remote;
+		block->next = head;
+	} while (!ATOM_CAS(_remote, head, block));
 }
 
 void mem_alloc::init_thread_arena() {
-	UInt32 buf_cnt = g_thread_cnt;
-	if (buf_cnt < g_init_parallelism)
-		buf_cnt = g_init_parallelism;
-	_arenas = new Arena * [buf_cnt];
-	for (UInt32 i = 0; i < buf_cnt; i++) {
-		_arenas[i] = new Arena[SizeNum];
+	_cache_cnt = g_thread_cnt;
+	if (_cache_cnt < g_init_parallelism)
+		_cache_cnt = g_init_parallelism;
+	_caches = new SlabCache * [_cache_cnt];
+	for (UInt32 i = 0; i < _cache_cnt; i++) {
+		_caches[i] = (SlabCache *) _mm_malloc(sizeof(SlabCache) * SizeNum, CL_SIZE);
 		for (int n = 0; n < SizeNum; n++) {
-			assert(sizeof(Arena) == 128);
-			_arenas[i][n].init(i, BlockSizes[n]);
+			assert(sizeof(SlabCache) == CL_SIZE);
+			_caches[i][n].init();
 		}
 	}
+	// Only reserve the address space. Slabs are made accessible as they are
+	// handed out, so untouched space costs nothing.
+	char * base = (char *) mmap(NULL, THREAD_HEAP_SIZE + SLAB_SIZE, PROT_NONE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	M_ASSERT(base != MAP_FAILED, "cannot reserve %ld bytes for slabs\n", THREAD_HEAP_SIZE);
+	_slab_base = (char *) (((uint64_t)base + SLAB_SIZE - 1) & ~(SLAB_SIZE - 1));
 }
 
 void mem_alloc::register_thread(int thd_id) {
 	if (THREAD_ALLOC) {
-		pthread_mutex_lock( &map_lock );
-		pthread_t pid = pthread_self();
-		int entry = pid % _bucket_cnt;
-		while (pid_arena[ entry ].first != 0) {
-			printf("conflict at entry %d (pid=%ld)\n", entry, pid);
-			entry = (entry + 1) % _bucket_cnt;
-		}
-		pid_arena[ entry ].first = pid;
-		pid_arena[ entry ].second = thd_id;
-		pthread_mutex_unlock( &map_lock );
+		assert((UInt32)thd_id < _cache_cnt);
+		tls_caches = _caches[thd_id];
+		tls_thd_id = thd_id;
 	}
 }
 
 void mem_alloc::unregister() {
-	if (THREAD_ALLOC) {
-		pthread_mutex_lock( &map_lock );
-		for (int i = 0; i < _bucket_cnt; i ++) {
-			pid_arena[i].first = 0;
-			pid_arena[i].second = 0;
-		}
-		pthread_mutex_unlock( &map_lock );
-	}
-}
-
-int 
-mem_alloc::get_arena_id() {
-	int arena_id; 
-#if NOGRAPHITE
-	pthread_t pid = pthread_self();
-	int entry = pid % _bucket_cnt;
-	while (pid_arena[entry].first != pid) {
-		if (pid_arena[entry].first == 0)
-			break;
-		entry = (entry + 1) % _bucket_cnt;
-	}
-	arena_id = pid_arena[entry].second;
-#else 
-	arena_id = CarbonGetTileId();
-#endif
-	return arena_id;
+	tls_caches = NULL;
 }
 
 int 
-mem_alloc::get_size_id(UInt32 size) {
+mem_alloc::get_size_id(UInt64 size) {
 	for (int i = 0; i < SizeNum; i++) {
 		if (size <= BlockSizes[i]) 
 			return i;
 	}
-    printf("size = %d\n", size);
-	assert( false );
+	return -1;
+}
+
+void * 
+mem_alloc::thread_alloc(uint64_t size) {
+	uint64_t starttime = get_sys_clock();
+	void * ptr = slab_alloc(size);
+	if (warmup_finish)
+		INC_STATS(tls_thd_id, time_alloc, get_sys_clock() - starttime);
+	return ptr;
 }
 
+// NULL if the size is too large or the slab space is used up
+void * 
+mem_alloc::slab_alloc(uint64_t size) {
+	int size_id = get_size_id(size);
+	if (size_id == -1)
+		return NULL;
+	void * ptr = tls_caches[size_id].alloc();
+	if (ptr != NULL)
+		return ptr;
+	uint64_t offset = ATOM_FETCH_ADD(_slab_used, SLAB_SIZE);
+	if (offset + SLAB_SIZE > THREAD_HEAP_SIZE) {
+		ATOM_SUB(_slab_used, SLAB_SIZE);
+		return NULL;
+	}
+	char * slab = _slab_base + offset;
+	int ret = mprotect(slab, SLAB_SIZE, PROT_READ | PROT_WRITE);
+	M_ASSERT(ret == 0, "cannot map slab at %p\n", slab);
+	((SlabHeader *) slab)->size_id = size_id;
+	((SlabHeader *) slab)->owner = tls_thd_id;
+	tls_caches[size_id].refill(slab);
+	return tls_caches[size_id].alloc();
+}
+
+void 
+mem_alloc::slab_free(void * ptr) {
+	SlabHeader * slab = (SlabHeader *) ((uint64_t)ptr & ~(SLAB_SIZE - 1));
+	SlabCache * cache = &_caches[slab->owner][slab->size_id];
+	if (tls_caches != NULL && cache == &tls_caches[slab->size_id])
+		cache->free_local(ptr);
+	else 
+		cache->free_remote(ptr);
+}
+
+int64_t 
+mem_alloc::get_part_id(void * ptr) {
+	if (_part_base == NULL 
+		|| (char *)ptr < _part_base 
+		|| (char *)ptr >= _part_base + _part_cnt * _bytes_per_part)
+		return -1;
+	return ((char *)ptr - _part_base) / _bytes_per_part;
+}
 
 void mem_alloc::free(void * ptr, uint64_t size) {
 	if (NO_FREE) {} 
-	else if (THREAD_ALLOC) {
-		int arena_id = get_arena_id();
-		FreeBlock * block = (FreeBlock *)((UInt64)ptr - sizeof(FreeBlock));
-		int size = block->size;
-		int size_id = get_size_id(size);
-		_arenas[arena_id][size_id].free(ptr);
+	else if (get_part_id(ptr) != -1) {} // partition memory is never reused
+	else if (in_slab(ptr)) {
+		uint64_t starttime = get_sys_clock();
+		slab_free(ptr);
+		if (warmup_finish && tls_caches != NULL)
+			INC_STATS(tls_thd_id, time_alloc, get_sys_clock() - starttime);
 	} else {
 		std::free(ptr);
 	}
@@ -144,16 +228,40 @@ void mem_alloc::free(void * ptr, uint64_t size) {
 // cause trouble)
 void * mem_alloc::alloc(uint64_t size, uint64_t part_id) {
 	void * ptr;
-    if (size > BlockSizes[SizeNum - 1])
-        ptr = malloc(size);
-	else if (THREAD_ALLOC && (warmup_finish || enable_thread_mem_pool)) {
-		int arena_id = get_arena_id();
-		int size_id = get_size_id(size);
-		ptr = _arenas[arena_id][size_id].alloc();
-	} else {
-		ptr = malloc(size);
+	// partitions hold what is loaded before the measured run. What txns
+	// allocate while they run is short-lived and goes to the slabs.
+	if (g_part_alloc && !warmup_finish) {
+		ptr = _part_arenas[part_id % _part_cnt].alloc(size);
+		if (ptr != NULL)
+			return ptr;
+		// the partition is full, fall back to the shared heap
 	}
-	return ptr;
+	if (THREAD_ALLOC && tls_caches != NULL) {
+		ptr = thread_alloc(size);
+		if (ptr != NULL)
+			return ptr;
+	}
+	return malloc(size);
 }
 
+void * mem_alloc::alloc_aligned(uint64_t size, uint64_t part_id) {
+	if (g_part_alloc && !warmup_finish) {
+		void * ptr = _part_arenas[part_id % _part_cnt].alloc((size + CL_SIZE - 1) & ~(CL_SIZE - 1));
+		if (ptr != NULL)
+			return ptr;
+	}
+	// blocks of CL_SIZE and up are cache-line aligned inside a slab
+	if (THREAD_ALLOC && tls_caches != NULL) {
+		void * ptr = thread_alloc(size < CL_SIZE? CL_SIZE : size);
+		if (ptr != NULL)
+			return ptr;
+	}
+	return _mm_malloc(size, CL_SIZE);
+}
 
+void mem_alloc::free_aligned(void * ptr) {
+	if (get_part_id(ptr) != -1 || in_slab(ptr))
+		free(ptr, 0);
+	else
+		_mm_free(ptr);
+}
@@ -4,45 +4,96 @@
 #include "global.h"
 #include <map>
 
-const int SizeNum = 4;
-const UInt32 BlockSizes[] = {32, 64, 256, 1024};
+const int SizeNum = 8;
+const UInt32 BlockSizes[] = {16, 32, 64, 128, 256, 512, 1024, 2048};
+
+// [THREAD_ALLOC] Memory is handed out in slabs of SLAB_SIZE bytes, aligned to
+// SLAB_SIZE, so the slab of a block is found by masking its address.
+#define SLAB_SIZE			(1UL << 16)
 
 typedef struct free_block {
-    int size;
     struct free_block* next;
 } FreeBlock;
 
-class Arena {
+// First cache line of every slab. All blocks of a slab have the same size
+// and go back to the thread that carved the slab.
+struct SlabHeader {
+	uint32_t 	size_id;
+	uint32_t 	owner;
+	char 		_pad[CL_SIZE - sizeof(uint32_t) * 2];
+};
+
+// One size class of a thread. Only the owner allocates from it. Blocks freed
+// by other threads are pushed onto `_remote` and picked up by the owner when
+// its own list runs dry.
+class SlabCache {
 public:
-	void init(int arena_id, int size);
+	void init();
 	void * alloc();
-	void free(void * ptr);
+	void free_local(void * ptr);
+	void free_remote(void * ptr);
+	// carve a new slab into blocks
+	void refill(char * slab);
 private:
-	char * 		_buffer;
-	int 		_size_in_buffer;
-	int 		_arena_id;
-	int 		_block_size;
-	FreeBlock * _head;
-	char 		_pad[128 - sizeof(int)*3 - sizeof(void *)*2 - 8];
+	FreeBlock * 			_local;
+	FreeBlock * volatile 	_remote;
+	char 					_pad[CL_SIZE - sizeof(void *) * 2];
+};
+
+// [PART_ALLOC] Each partition owns a region of memory bound to one NUMA node.
+// Blocks are bumped off the region and never reused.
+class PartArena {
+public:
+	void init(char * base, uint64_t size);
+	// NULL if the region is full
+	void * alloc(uint64_t size);
+private:
+	char * 				_base;
+	uint64_t 			_size;
+	volatile uint64_t 	_used;
+	char 				_pad[CL_SIZE - sizeof(uint64_t) * 3];
 };
 
 class mem_alloc {
 public:
     void init(uint64_t part_cnt, uint64_t bytes_per_part);
+	// binds the calling thread to slab caches `thd_id`. At most one live
+	// thread may be registered with an id at a time.
     void register_thread(int thd_id);
+	// unbinds the calling thread
     void unregister();
     void * alloc(uint64_t size, uint64_t part_id);
     void free(void * block, uint64_t size);
-	int get_arena_id();
+	// cache-line aligned, from the partition's region when PART_ALLOC is on
+	void * alloc_aligned(uint64_t size, uint64_t part_id);
+	void free_aligned(void * ptr);
+	// partition whose region holds `ptr`, -1 if it is not in any
+	int64_t get_part_id(void * ptr);
+	// bytes of slabs handed out to threads
+	uint64_t get_slab_bytes() { return _slab_used; }
 private:
     void init_thread_arena();
-	int get_size_id(UInt32 size);
-	
-	// each thread has several arenas for different block size
-	Arena ** _arenas;
-	int _bucket_cnt;
-    std::pair<pthread_t, int>* pid_arena;//                     max_arena_id;
-    pthread_mutex_t         map_lock; // only used for pid_to_arena update
+	void init_part_arena(uint64_t part_cnt, uint64_t bytes_per_part);
+	int get_size_id(UInt64 size);
+	bool in_slab(void * ptr) {
+		return (char *)ptr >= _slab_base && (char *)ptr < _slab_base + _slab_used;
+	}
+	// times the slab allocator into Stats
+	void * thread_alloc(uint64_t size);
+	void * slab_alloc(uint64_t size);
+	void slab_free(void * ptr);
+
+	// each thread has one cache per block size
+	SlabCache ** _caches;
+	UInt32 		_cache_cnt;
+	// address space the slabs are carved from
+	char * 		_slab_base;
+	volatile uint64_t _slab_used;
+
+	PartArena * _part_arenas;
+	char * 		_part_base;
+	uint64_t 	_part_cnt;
+	uint64_t 	_bytes_per_part;
 };
 
 #endif
@@ -1,13 +1,43 @@
 #include "global.h"
 #include "helper.h"
+#include "cc_policy.h"
+
+struct cc_name {
+	const char * 	name;
+	UInt32 			alg;
+};
+
+static const cc_name cc_names[] = {
+	{"NO_WAIT", NO_WAIT}, {"WAIT_DIE", WAIT_DIE}, {"DL_DETECT", DL_DETECT},
+	{"TIMESTAMP", TIMESTAMP}, {"MVCC", MVCC}, {"HSTORE", HSTORE}, {"OCC", OCC},
+	{"TICTOC", TICTOC}, {"SILO", SILO}, {"VLL", VLL}, {"HEKATON", HEKATON}
+};
+
+UInt32 cc_alg_by_name(const char * name) {
+	for (UInt32 i = 0; i < sizeof(cc_names) / sizeof(cc_names[0]); i++)
+		if (strcmp(name, cc_names[i].name) == 0) {
+			// the VLL txn crashes for now
+			if (cc_names[i].alg == VLL) {
+				printf("CC_ALG VLL is not supported at this moment\n");
+				exit(-1);
+			}
+			return cc_names[i].alg;
+		}
+	return 0;
+}
 
 void print_usage() {
 	printf("[usage]:\n");
 	printf("\t-pINT       ; PART_CNT\n");
 	printf("\t-vINT       ; VIRTUAL_PART_CNT\n");
 	printf("\t-tINT       ; THREAD_CNT\n");
+	printf("\t-cSTRING    ; CC_ALG\n");
 	printf("\t-qINT       ; QUERY_INTVL\n");
+	printf("\t-OrFLOAT    ; ARRIVAL_RATE\n");
+	printf("\t-OpINT      ; ARRIVAL_POISSON\n");
 	printf("\t-dINT       ; PRT_LAT_DISTR\n");
+	printf("\t-SiINT      ; SAMPLE_INTERVAL (in ms)\n");
+	printf("\t-PaINT      ; PROF_ABORT\n");
 	printf("\t-aINT       ; PART_ALLOC (0 or 1)\n");
 	printf("\t-mINT       ; MEM_PAD (0 or 1)\n");
 	printf("\t-GaINT      ; ABORT_PENALTY (in ms)\n");
@@ -17,9 +47,20 @@ void print_usage() {
 	printf("\t-GnINT      ; NO_DL\n");
 	printf("\t-GoINT      ; TIMEOUT\n");
 	printf("\t-GlINT      ; DL_LOOP_DETECT\n");
+	printf("\t-GdINT      ; DL_DETECT_THREAD\n");
 	
 	printf("\t-GbINT      ; TS_BATCH_ALLOC\n");
 	printf("\t-GuINT      ; TS_BATCH_NUM\n");
+	printf("\t-GrINT      ; READ_ONLY_SNAPSHOT\n");
+	printf("\t-LrINT      ; LOG_REDO\n");
+	printf("\t-LcINT      ; LOG_COMMAND\n");
+	printf("\t-LtINT      ; LOG_THREAD_CNT\n");
+	printf("\t-CkINT      ; CHECKPOINT\n");
+	printf("\t-CrINT      ; RECOVER\n");
+	
+	printf("\t--dump-image=PATH ; write the loaded tables and indexes to PATH and exit\n");
+	printf("\t--image=PATH      ; load the tables and indexes from the image at PATH\n");
+	printf("\t--sample-file=PATH ; SAMPLE_FILE\n");
 	
 	printf("\t-o STRING   ; output file\n\n");
 	printf("  [YCSB]:\n");
@@ -34,6 +75,9 @@ void print_usage() {
 	printf("  [TPCC]:\n");
 	printf("\t-nINT       ; NUM_WH\n");
 	printf("\t-TpFLOAT    ; PERC_PAYMENT\n");
+	printf("\t-ToFLOAT    ; PERC_ORDER_STATUS\n");
+	printf("\t-TdFLOAT    ; PERC_DELIVERY\n");
+	printf("\t-TsFLOAT    ; PERC_STOCK_LEVEL\n");
 	printf("\t-TuINT      ; WH_UPDATE\n");
 	printf("  [TEST]:\n");
 	printf("\t-Ar         ; Test READ_WRITE\n");
@@ -46,6 +90,9 @@ void parser(int argc, char * argv[]) {
 	g_params["validation_lock"] = VALIDATION_LOCK;
 	g_params["pre_abort"] = PRE_ABORT;
 	g_params["atomic_timestamp"] = ATOMIC_TIMESTAMP;
+	g_params["dump-image"] = "";
+	g_params["image"] = "";
+	g_params["sample-file"] = SAMPLE_FILE;
 
 	for (int i = 1; i < argc; i++) {
 		assert(argv[i][0] == '-');
@@ -55,6 +102,13 @@ void parser(int argc, char * argv[]) {
 			g_mem_pad = atoi( &argv[i][2] );
 		else if (argv[i][1] == 'q')
 			g_query_intvl = atoi( &argv[i][2] );
+		else if (argv[i][1] == 'c' && isalpha(argv[i][2])) {
+			g_cc_alg = cc_alg_by_name( &argv[i][2] );
+			if (g_cc_alg == 0) {
+				printf("unknown CC_ALG %s\n", &argv[i][2]);
+				exit(-1);
+			}
+		}
 		else if (argv[i][1] == 'c')
 			g_part_per_txn = atoi( &argv[i][2] );
 		else if (argv[i][1] == 'e')
@@ -96,13 +150,46 @@ void parser(int argc, char * argv[]) {
 				g_timeout = atol( &argv[i][3] );
 			else if (argv[i][2] == 'l')
 				g_dl_loop_detect = atoi( &argv[i][3] );
+			else if (argv[i][2] == 'd')
+				g_dl_detect_thread = atoi( &argv[i][3] );
 			else if (argv[i][2] == 'b')
 				g_ts_batch_alloc = atoi( &argv[i][3] );
 			else if (argv[i][2] == 'u')
 				g_ts_batch_num = atoi( &argv[i][3] );
+			else if (argv[i][2] == 'r')
+				g_read_only_snapshot = atoi( &argv[i][3] );
+		} else if (argv[i][1] == 'L') {
+			if (argv[i][2] == 'r')
+				g_log_redo = atoi( &argv[i][3] );
+			else if (argv[i][2] == 'c')
+				g_log_command = atoi( &argv[i][3] );
+			else if (argv[i][2] == 't')
+				g_log_thread_cnt = atoi( &argv[i][3] );
+		} else if (argv[i][1] == 'O') {
+			if (argv[i][2] == 'r')
+				g_arrival_rate = atof( &argv[i][3] );
+			else if (argv[i][2] == 'p')
+				g_arrival_poisson = atoi( &argv[i][3] );
+		} else if (argv[i][1] == 'C') {
+			if (argv[i][2] == 'k')
+				g_checkpoint = atoi( &argv[i][3] );
+			else if (argv[i][2] == 'r')
+				g_recover = atoi( &argv[i][3] );
+		} else if (argv[i][1] == 'P') {
+			if (argv[i][2] == 'a')
+				g_prof_abort = atoi( &argv[i][3] );
+		} else if (argv[i][1] == 'S') {
+			if (argv[i][2] == 'i')
+				g_sample_interval = atoi( &argv[i][3] );
 		} else if (argv[i][1] == 'T') {
 			if (argv[i][2] == 'p')
 				g_perc_payment = atof( &argv[i][3] );
+			if (argv[i][2] == 'o')
+				g_perc_order_status = atof( &argv[i][3] );
+			if (argv[i][2] == 'd')
+				g_perc_delivery = atof( &argv[i][3] );
+			if (argv[i][2] == 's')
+				g_perc_stock_level = atof( &argv[i][3] );
 			if (argv[i][2] == 'u')
 				g_wh_update = atoi( &argv[i][3] );
 		} else if (argv[i][1] == 'A') {
@@ -133,4 +220,17 @@ void parser(int argc, char * argv[]) {
 	}
 	if (g_thread_cnt < g_init_parallelism)
 		g_init_parallelism = g_thread_cnt;
+	// OCC validates a row by comparing its wts with the start_ts of the
+	// reader, which needs one total order of all timestamps
+	if (g_cc_alg == OCC && (g_ts_alloc == TS_CLOCK || g_ts_alloc == TS_LOCAL_CLOCK)) {
+		printf("OCC needs TS_MUTEX or TS_CAS timestamps (-Gt)\n");
+		exit(-1);
+	}
+	// the default of config.h is not looked up by name
+	if (g_cc_alg == VLL) {
+		printf("CC_ALG VLL is not supported at this moment\n");
+		exit(-1);
+	}
+	if (g_cc_alg == TIMESTAMP)
+		printf("warning: TIMESTAMP does not work at this moment, it can hang under contention\n");
 }
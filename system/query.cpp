@@ -48,6 +48,11 @@ Query_queue::get_next_query(uint64_t thd_id) {
 	return query;
 }
 
+void 
+Query_queue::release_query(uint64_t thd_id, base_query * query) {
+	all_queries[thd_id]->release_query(query);
+}
+
 void *
 Query_queue::threadInitQuery(void * This) { // Each thread access this same query queue
 	Query_queue * query_queue = (Query_queue *)This;
@@ -66,20 +71,22 @@ Query_queue::threadInitQuery(void * This) { // Each thread access this same quer
 
 void 
 Query_thd::init(workload * h_wl, int thread_id) {
-	uint64_t request_cnt; // Number of txn a thread will process
-	q_idx = 0;
-	request_cnt = WARMUP / g_thread_cnt + MAX_TXN_PER_PART + 4; // NOTE: Where does this 4 come from? Maybe just for reservation? (since get_next_query can reads until NULL)
+	_thd_id = thread_id;
+	_pool_size = QUERY_POOL_SIZE;
 #if ABORT_BUFFER_ENABLE
-    request_cnt += ABORT_BUFFER_SIZE;
+	// every query in the abort buffer holds on to its slot
+	_pool_size += ABORT_BUFFER_SIZE;
 #endif
 #if WORKLOAD == YCSB	
 	queries = (ycsb_query *) 
-		mem_allocator.alloc(sizeof(ycsb_query) * request_cnt, thread_id);
+		mem_allocator.alloc(sizeof(ycsb_query) * _pool_size, thread_id);
 	srand48_r(thread_id + 1, &buffer);
 #elif WORKLOAD == TPCC
-	queries = (tpcc_query *) _mm_malloc(sizeof(tpcc_query) * request_cnt, 64);
+	queries = (tpcc_query *) _mm_malloc(sizeof(tpcc_query) * _pool_size, 64);
 #endif
-	for (UInt32 qid = 0; qid < request_cnt; qid ++) {
+	_free = new base_query * [_pool_size];
+	_ready = new base_query * [_pool_size];
+	for (UInt32 qid = 0; qid < _pool_size; qid ++) {
 #if WORKLOAD == YCSB	
 		new(&queries[qid]) ycsb_query();
 		queries[qid].init(thread_id, h_wl, this);
@@ -87,11 +94,39 @@ Query_thd::init(workload * h_wl, int thread_id) {
 		new(&queries[qid]) tpcc_query();
 		queries[qid].init(thread_id, h_wl);
 #endif
+		_free[qid] = &queries[qid];
 	}
+	_free_cnt = _pool_size;
+	_ready_head = 0;
+	_ready_cnt = 0;
+	refill();
 }
 
 base_query * 
 Query_thd::get_next_query() {
-	base_query * query = &queries[q_idx++];
+	if (_ready_cnt == 0)
+		refill();
+	base_query * query = _ready[_ready_head];
+	_ready_head = (_ready_head + 1) % _pool_size;
+	_ready_cnt --;
 	return query;
 }
+
+void 
+Query_thd::release_query(base_query * query) {
+	assert(_free_cnt < _pool_size);
+	_free[_free_cnt ++] = query;
+}
+
+// Queries are generated in the order they are handed out, so a thread runs
+// the same sequence of txns whatever the pool size.
+void 
+Query_thd::refill() {
+	assert(_free_cnt > 0);
+	while (_free_cnt > 0) {
+		base_query * query = _free[-- _free_cnt];
+		query->gen(_thd_id);
+		_ready[(_ready_head + _ready_cnt) % _pool_size] = query;
+		_ready_cnt ++;
+	}
+}
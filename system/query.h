@@ -9,27 +9,54 @@ class tpcc_query;
 
 class base_query {
 public:
+	// allocates the buffers of the query
 	virtual void init(uint64_t thd_id, workload * h_wl) = 0;
+	// fills the query with the next txn of thread `thd_id`
+	virtual void gen(uint64_t thd_id) = 0;
+	// [LOG_COMMAND] the txn input as it is written to the log
+	virtual uint32_t get_cmd_size() { return 0; }
+	virtual void write_cmd(char * buf) {}
+	// the latency histogram the txn is counted in
+	virtual uint32_t get_txn_type() { return 0; }
+	// the txn writes no row. Set by gen() before the txn starts.
+	bool read_only;
 	uint64_t waiting_time;
+	// when the txn arrived. Its latency is measured from here.
+	ts_t arrival_time;
+	// start of the first attempt, 0 before
+	ts_t start_time;
 	uint64_t part_num; // How many partitions we will access
 	uint64_t * part_to_access; // Partitions this query will (actually, means no repetition sampling) access
 };
 
-// All the queries (txns) for a particular thread.
+// All the queries (txns) for a particular thread. They are generated in
+// order, a batch at a time whenever none is left, into a fixed pool of
+// QUERY_POOL_SIZE queries (plus one per abort buffer slot). A query returns
+// to the pool once its txn commits, so the memory does not grow with the
+// length of the run.
 class Query_thd {
 public:
-	// Compute queries (in this workload) assigned to this thread
-	// Each thread will receive a fixed number of txn: `WARMUP / g_thread_cnt + MAX_TXN_PER_PART + 4`
 	void init(workload * h_wl, int thread_id);
 	base_query * get_next_query(); 
-	int q_idx; // Which query this thread is processing
+	// the txn of `query` committed, its slot can be generated into again
+	void release_query(base_query * query);
+	drand48_data buffer;
+private:
+	void refill();
 #if WORKLOAD == YCSB
-	ycsb_query * queries; // All queries (txn) belongs to this thread
+	ycsb_query * queries; // The pool of this thread
 #else 
-	tpcc_query * queries; // All queries (txn) belongs to this thread
+	tpcc_query * queries; // The pool of this thread
 #endif
-	char pad[CL_SIZE - sizeof(void *) - sizeof(int)];
-	drand48_data buffer;
+	uint32_t _pool_size;
+	uint32_t _thd_id;
+	// queries not in use
+	base_query ** _free;
+	uint32_t _free_cnt;
+	// generated queries in the order they are handed out
+	base_query ** _ready;
+	uint32_t _ready_head;
+	uint32_t _ready_cnt;
 };
 
 // TODO we assume a separate task queue for each thread in order to avoid 
@@ -41,6 +68,7 @@ public:
 	void init(workload * h_wl);
 	void init_per_thread(int thread_id);
 	base_query * get_next_query(uint64_t thd_id); 
+	void release_query(uint64_t thd_id, base_query * query);
 	
 private:
 	static void * threadInitQuery(void * This);
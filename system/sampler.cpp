@@ -0,0 +1,89 @@
+#include "sampler.h"
+#include "stats.h"
+
+void Sampler::start(const char * path) {
+	_file = fopen(path, "w");
+	M_ASSERT(_file != NULL, "cannot open sample file %s\n", path);
+	// per interval. Times are summed over the workers, in seconds.
+	fprintf(_file, "time,txn_cnt,abort_cnt,throughput,run_time,time_wait,time_index\n");
+	_stop = false;
+	_start_time = get_sys_clock();
+	_last_time = _start_time;
+	memset(&_last, 0, sizeof(Sample));
+	pthread_create(&_thd, NULL, run_sampler, this);
+}
+
+void Sampler::stop() {
+	_stop = true;
+	pthread_join(_thd, NULL);
+	sample();
+	fclose(_file);
+}
+
+void * Sampler::run_sampler(void * This) {
+	((Sampler *) This)->run();
+	return NULL;
+}
+
+void Sampler::run() {
+	ts_t intvl = (ts_t) g_sample_interval * 1000000;
+	ts_t next = _start_time + intvl;
+	while (!_stop) {
+		ts_t now = get_sys_clock();
+		if (now < next) {
+			// naps of at most 10 ms, so stop() does not wait for a whole interval
+			ts_t nap = next - now < 10000000? next - now : 10000000;
+			usleep(nap / 1000);
+			continue;
+		}
+		sample();
+		// a late wakeup skips the missed ticks instead of sampling empty ones
+		while (next <= now)
+			next += intvl;
+	}
+}
+
+void Sampler::read(Sample & s) {
+	memset(&s, 0, sizeof(Sample));
+	for (UInt32 tid = 0; tid < g_thread_cnt; tid ++) {
+		Stats_thd * st = stats._stats[tid];
+		uint64_t seq;
+		Sample t;
+		do {
+			while ((seq = st->seq) & 1)
+				PAUSE
+			COMPILER_BARRIER
+			t.txn_cnt = st->txn_cnt;
+			t.abort_cnt = st->abort_cnt;
+			t.run_time = st->run_time;
+			t.time_wait = st->time_wait;
+			t.time_index = st->time_index;
+			COMPILER_BARRIER
+		} while (st->seq != seq);
+		s.txn_cnt += t.txn_cnt;
+		s.abort_cnt += t.abort_cnt;
+		s.run_time += t.run_time;
+		s.time_wait += t.time_wait;
+		s.time_index += t.time_index;
+	}
+}
+
+void Sampler::sample() {
+	Sample cur;
+	read(cur);
+	ts_t now = get_sys_clock();
+	double intvl = (double) (now - _last_time) / 1000000000.0;
+	uint64_t txn_cnt = cur.txn_cnt - _last.txn_cnt;
+	fprintf(_file, "%f,%ld,%ld,%f,%f,%f,%f\n",
+		(double) (now - _start_time) / 1000000000.0,
+		txn_cnt,
+		cur.abort_cnt - _last.abort_cnt,
+		intvl > 0? txn_cnt / intvl : 0,
+		(cur.run_time - _last.run_time) / 1000000000.0,
+		(cur.time_wait - _last.time_wait) / 1000000000.0,
+		(cur.time_index - _last.time_index) / 1000000000.0
+	);
+	fflush(_file);
+	_last = cur;
+	_last_time = now;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "global.h"
+#include "helper.h"
+
+// Time series of the run. A thread wakes up every g_sample_interval ms,
+// snapshots the counters of every worker and appends what changed since the
+// last sample as one CSV line. It never blocks a worker: a worker brackets
+// its end-of-txn stats update with a sequence counter (Stats::begin_update)
+// and the sampler rereads a worker whose counter moved meanwhile.
+class Sampler {
+public:
+	// opens `path` and spawns the thread. Called after the warmup.
+	void 		start(const char * path);
+	// takes a last sample up to now and joins the thread
+	void 		stop();
+private:
+	struct Sample {
+		uint64_t 	txn_cnt;
+		uint64_t 	abort_cnt;
+		double 		run_time;
+		double 		time_wait;
+		double 		time_index;
+	};
+	static void * 	run_sampler(void * This);
+	void 			run();
+	// sums the counters of all workers into `s`
+	void 			read(Sample & s);
+	void 			sample();
+
+	FILE * 				_file;
+	pthread_t 			_thd;
+	volatile bool 		_stop;
+	ts_t 				_start_time;
+	ts_t 				_last_time;
+	Sample 				_last;
+};
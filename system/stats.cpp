@@ -5,12 +5,60 @@
 
 #define BILLION 1000000000UL
 
+void LatHist::clear() {
+	memset(cnt, 0, sizeof(cnt));
+	sum = 0;
+	max = 0;
+}
+
+void LatHist::merge(LatHist * hist) {
+	for (uint32_t b = 0; b < LAT_HIST_BUCKETS; b ++)
+		cnt[b] += hist->cnt[b];
+	sum += hist->sum;
+	if (hist->max > max)
+		max = hist->max;
+}
+
+uint64_t LatHist::get_cnt() {
+	uint64_t total = 0;
+	for (uint32_t b = 0; b < LAT_HIST_BUCKETS; b ++)
+		total += cnt[b];
+	return total;
+}
+
+uint64_t LatHist::get_lower(uint32_t b) {
+	uint64_t shift = b >> LAT_HIST_SUB_BITS;
+	if (shift > 0)
+		shift --;
+	return (b - (shift << LAT_HIST_SUB_BITS)) << shift;
+}
+
+uint64_t LatHist::get_percentile(double q) {
+	uint64_t rank = (uint64_t) ceil(q * get_cnt());
+	uint64_t seen = 0;
+	for (uint32_t b = 0; b < LAT_HIST_BUCKETS; b ++) {
+		seen += cnt[b];
+		if (seen >= rank && seen > 0) {
+			if (b + 1 == LAT_HIST_BUCKETS)
+				return max;
+			uint64_t upper = get_lower(b + 1) - 1;
+			return upper < max? upper : max;
+		}
+	}
+	return 0;
+}
+
 void Stats_thd::init(uint64_t thd_id) {
+	lat_hists = NULL;
+	seq = 0;
 	clear();
 	all_debug1 = (uint64_t *)
 		_mm_malloc(sizeof(uint64_t) * MAX_TXN_PER_PART, 64);
 	all_debug2 = (uint64_t *)
 		_mm_malloc(sizeof(uint64_t) * MAX_TXN_PER_PART, 64);
+	lat_hists = (LatHist *)
+		_mm_malloc(sizeof(LatHist) * LAT_TXN_TYPES * LAT_TYPE_CNT, 64);
+	clear();
 }
 
 void Stats_thd::clear() {
@@ -29,7 +77,21 @@ void Stats_thd::clear() {
 	time_wait = 0;
 	time_ts_alloc = 0;
 	latency = 0;
+	arrival_latency = 0;
 	time_query = 0;
+	time_alloc = 0;
+	time_log = 0;
+	log_bytes = 0;
+	log_ack_cnt = 0;
+	log_ack_time = 0;
+	ro_txn_cnt = 0;
+	ro_abort_cnt = 0;
+	ro_run_time = 0;
+	mv_renew_cnt = 0;
+	// not allocated yet on the call from init()
+	if (lat_hists != NULL)
+		for (uint32_t i = 0; i < LAT_TXN_TYPES * LAT_TYPE_CNT; i ++)
+			lat_hists[i].clear();
 }
 
 void Stats_tmp::init() {
@@ -103,6 +165,20 @@ void Stats::abort(uint64_t thd_id) {
 		tmp_stats[thd_id]->init();
 }
 
+void Stats::begin_update(uint64_t thd_id) {
+	if (STATS_ENABLE) {
+		_stats[thd_id]->seq ++;
+		COMPILER_BARRIER
+	}
+}
+
+void Stats::end_update(uint64_t thd_id) {
+	if (STATS_ENABLE) {
+		COMPILER_BARRIER
+		_stats[thd_id]->seq ++;
+	}
+}
+
 void Stats::print() {
 	
 	uint64_t total_txn_cnt = 0;
@@ -121,6 +197,16 @@ void Stats::print() {
 	double total_time_ts_alloc = 0;
 	double total_latency = 0;
 	double total_time_query = 0;
+	double total_time_alloc = 0;
+	double total_time_log = 0;
+	uint64_t total_log_bytes = 0;
+	uint64_t total_log_ack_cnt = 0;
+	double total_log_ack_time = 0;
+	double total_arrival_latency = 0;
+	uint64_t total_ro_txn_cnt = 0;
+	uint64_t total_ro_abort_cnt = 0;
+	double total_ro_run_time = 0;
+	uint64_t total_mv_renew_cnt = 0;
 	for (uint64_t tid = 0; tid < g_thread_cnt; tid ++) {
 		total_txn_cnt += _stats[tid]->txn_cnt;
 		total_abort_cnt += _stats[tid]->abort_cnt;
@@ -138,6 +224,16 @@ void Stats::print() {
 		total_time_ts_alloc += _stats[tid]->time_ts_alloc;
 		total_latency += _stats[tid]->latency;
 		total_time_query += _stats[tid]->time_query;
+		total_time_alloc += _stats[tid]->time_alloc;
+		total_time_log += _stats[tid]->time_log;
+		total_log_bytes += _stats[tid]->log_bytes;
+		total_log_ack_cnt += _stats[tid]->log_ack_cnt;
+		total_log_ack_time += _stats[tid]->log_ack_time;
+		total_arrival_latency += _stats[tid]->arrival_latency;
+		total_ro_txn_cnt += _stats[tid]->ro_txn_cnt;
+		total_ro_abort_cnt += _stats[tid]->ro_abort_cnt;
+		total_ro_run_time += _stats[tid]->ro_run_time;
+		total_mv_renew_cnt += _stats[tid]->mv_renew_cnt;
 		
 		printf("[tid=%ld] txn_cnt=%ld,abort_cnt=%ld\n", 
 			tid,
@@ -145,6 +241,9 @@ void Stats::print() {
 			_stats[tid]->abort_cnt
 		);
 	}
+	// time from commit until the epoch of the txn is durable
+	double log_latency = total_log_ack_cnt == 0? 0 :
+		total_log_ack_time / BILLION / total_log_ack_cnt;
 	FILE * outf;
 	if (output_file != NULL) {
 		outf = fopen(output_file, "w");
@@ -152,7 +251,9 @@ void Stats::print() {
 			", run_time=%f, time_wait=%f, time_ts_alloc=%f"
 			", time_man=%f, time_index=%f, time_abort=%f, time_cleanup=%f, latency=%f"
 			", deadlock_cnt=%ld, cycle_detect=%ld, dl_detect_time=%f, dl_wait_time=%f"
-			", time_query=%f, debug1=%f, debug2=%f, debug3=%f, debug4=%f, debug5=%f\n",
+			", time_query=%f, debug1=%f, debug2=%f, debug3=%f, debug4=%f, debug5=%f"
+			", time_alloc=%f, alloc_mem=%ld, time_log=%f, log_bytes=%ld, log_latency=%f"
+			", arrival_latency=%f\n",
 			total_txn_cnt, 
 			total_abort_cnt,
 			total_run_time / BILLION,
@@ -172,7 +273,13 @@ void Stats::print() {
 			total_debug2, // / BILLION,
 			total_debug3, // / BILLION,
 			total_debug4, // / BILLION,
-			total_debug5 / BILLION
+			total_debug5 / BILLION,
+			total_time_alloc / BILLION,
+			mem_allocator.get_slab_bytes(),
+			total_time_log / BILLION,
+			total_log_bytes,
+			log_latency,
+			total_arrival_latency / BILLION / total_txn_cnt
 		);
 		fclose(outf);
 	}
@@ -180,7 +287,9 @@ void Stats::print() {
 		", run_time=%f, time_wait=%f, time_ts_alloc=%f"
 		", time_man=%f, time_index=%f, time_abort=%f, time_cleanup=%f, latency=%f"
 		", deadlock_cnt=%ld, cycle_detect=%ld, dl_detect_time=%f, dl_wait_time=%f"
-		", time_query=%f, debug1=%f, debug2=%f, debug3=%f, debug4=%f, debug5=%f\n", 
+		", time_query=%f, debug1=%f, debug2=%f, debug3=%f, debug4=%f, debug5=%f"
+		", time_alloc=%f, alloc_mem=%ld, time_log=%f, log_bytes=%ld, log_latency=%f"
+			", arrival_latency=%f\n", 
 		total_txn_cnt, 
 		total_abort_cnt,
 		total_run_time / BILLION,
@@ -200,12 +309,89 @@ void Stats::print() {
 		total_debug2, // / BILLION,
 		total_debug3, // / BILLION,
 		total_debug4, // / BILLION,
-		total_debug5  // / BILLION 
+		total_debug5,  // / BILLION 
+		total_time_alloc / BILLION,
+		mem_allocator.get_slab_bytes(),
+		total_time_log / BILLION,
+		total_log_bytes,
+		log_latency,
+		total_arrival_latency / BILLION / total_txn_cnt
 	);
+	outf = output_file == NULL? NULL : fopen(output_file, "a");
+	// run_time is that of the committed and the aborted attempts
+	char line[256];
+	snprintf(line, sizeof(line), "[read_only] txn_cnt=%ld, abort_cnt=%ld"
+		", run_time=%f, snapshot=%s\n",
+		total_ro_txn_cnt,
+		total_ro_abort_cnt,
+		total_ro_run_time / BILLION,
+		(g_cc_alg == MVCC || g_cc_alg == HEKATON || g_cc_alg == SILO) && g_read_only_snapshot? "true" : "false"
+	);
+	printf("%s", line);
+	if (outf != NULL)
+		fprintf(outf, "%s", line);
+	if (g_cc_alg == TICTOC) {
+		// the reads that would have aborted the txn with one version per row
+		snprintf(line, sizeof(line), "[tictoc_mv] versions=%d, renew_cnt=%ld"
+			", abort_rate=%f\n",
+			TICTOC_MV? TICTOC_MV_VERSIONS + 1 : 1,
+			total_mv_renew_cnt,
+			(double) total_abort_cnt / (total_txn_cnt + total_abort_cnt)
+		);
+		printf("%s", line);
+		if (outf != NULL)
+			fprintf(outf, "%s", line);
+	}
+	print_lat_hist(outf);
+	if (outf != NULL)
+		fclose(outf);
 	if (g_prt_lat_distr)
 		print_lat_distr();
 }
 
+void Stats::print_lat_hist(FILE * outf) {
+#if WORKLOAD == TPCC
+	const char * txn_names[LAT_TXN_TYPES] = 
+		{"all", "payment", "new_order", "order_status", "delivery", "stock_level"};
+#else
+	const char * txn_names[LAT_TXN_TYPES] = {"all"};
+#endif
+	const char * lat_names[LAT_TYPE_CNT] = {"queue", "retry", "commit"};
+	LatHist * hist = (LatHist *) _mm_malloc(sizeof(LatHist), 64);
+	for (uint32_t type = 0; type < LAT_TXN_TYPES; type ++) {
+		for (uint32_t lat = 0; lat < LAT_TYPE_CNT; lat ++) {
+			hist->clear();
+			for (uint64_t tid = 0; tid < g_thread_cnt; tid ++)
+				hist->merge(&_stats[tid]->lat_hists[type * LAT_TYPE_CNT + lat]);
+			uint64_t cnt = hist->get_cnt();
+			if (cnt == 0)
+				continue;
+			char line[512];
+			snprintf(line, sizeof(line), "[latency] txn=%s, lat=%s, cnt=%ld"
+				", mean=%.9f, p50=%.9f, p90=%.9f, p99=%.9f, p999=%.9f, max=%.9f\n",
+				txn_names[type], lat_names[lat], cnt,
+				(double) hist->sum / BILLION / cnt,
+				(double) hist->get_percentile(0.5) / BILLION,
+				(double) hist->get_percentile(0.9) / BILLION,
+				(double) hist->get_percentile(0.99) / BILLION,
+				(double) hist->get_percentile(0.999) / BILLION,
+				(double) hist->max / BILLION
+			);
+			printf("%s", line);
+			if (outf == NULL)
+				continue;
+			fprintf(outf, "%s", line);
+			// the non-empty buckets as lower bound (ns):count
+			fprintf(outf, "[lat_hist] txn=%s, lat=%s ", txn_names[type], lat_names[lat]);
+			for (uint32_t b = 0; b < LAT_HIST_BUCKETS; b ++)
+				if (hist->cnt[b] > 0)
+					fprintf(outf, "%ld:%ld,", LatHist::get_lower(b), hist->cnt[b]);
+			fprintf(outf, "\n");
+		}
+	}
+	_mm_free(hist);
+}
+
 void Stats::print_lat_distr() {
 	FILE * outf;
 	if (output_file != NULL) {
@@ -1,5 +1,43 @@
 #pragma once 
 
+// Log-linear latency histogram, as in HdrHistogram. Values below
+// 2^(LAT_HIST_SUB_BITS+1) have a bucket each; above that every power of two
+// is split into 2^LAT_HIST_SUB_BITS buckets, so a value is off by at most
+// 1/2^LAT_HIST_SUB_BITS (3%) of itself. Recording is a few instructions and
+// needs no lock: every thread has its own histograms, merged at the end.
+#define LAT_HIST_SUB_BITS	5
+#define LAT_HIST_BUCKETS	((65 - LAT_HIST_SUB_BITS) << LAT_HIST_SUB_BITS)
+
+class LatHist {
+public:
+	void clear();
+	void add(uint64_t value) {
+		uint64_t shift = 63 - __builtin_clzl(value | (1UL << LAT_HIST_SUB_BITS)) 
+			- LAT_HIST_SUB_BITS;
+		cnt[(shift << LAT_HIST_SUB_BITS) + (value >> shift)] ++;
+		sum += value;
+		if (value > max)
+			max = value;
+	}
+	void merge(LatHist * hist);
+	uint64_t get_cnt();
+	// smallest value of bucket `b`
+	static uint64_t get_lower(uint32_t b);
+	// upper bound of the bucket holding the q-quantile, 0 < q <= 1
+	uint64_t get_percentile(double q);
+
+	uint64_t cnt[LAT_HIST_BUCKETS];
+	uint64_t sum;
+	uint64_t max;
+};
+
+// [queue] arrival to the start of the first attempt
+// [retry] start of the first attempt to the start of the committing one
+// [commit] arrival to commit
+enum LatType { LAT_QUEUE, LAT_RETRY, LAT_COMMIT, LAT_TYPE_CNT };
+// indexed by TPCCTxnType. YCSB txns all have type 0.
+#define LAT_TXN_TYPES		(TPCC_STOCK_LEVEL + 1)
+
 class Stats_thd {
 public:
 	void init(uint64_t thd_id);
@@ -16,6 +54,18 @@ public:
 	double time_cleanup;
 	uint64_t time_ts_alloc;
 	double time_query;
+	double time_alloc;
+	double time_log;
+	uint64_t log_bytes;
+	// committed txns whose epoch became durable, and their wait for it
+	uint64_t log_ack_cnt;
+	double log_ack_time;
+	// txns whose query is read-only, also counted in the totals above
+	uint64_t ro_txn_cnt;
+	uint64_t ro_abort_cnt;
+	double ro_run_time;
+	// [TICTOC_MV] reads that committed on a version replaced since
+	uint64_t mv_renew_cnt;
 	uint64_t wait_cnt;
 	uint64_t debug1;
 	uint64_t debug2;
@@ -24,6 +74,12 @@ public:
 	uint64_t debug5;
 	
 	uint64_t latency;
+	// from the arrival of each committed txn to its commit
+	double arrival_latency;
+	// of committed txns, [txn_type * LAT_TYPE_CNT + lat_type]
+	LatHist * lat_hists;
+	// odd while the thread updates the counters at the end of a txn
+	volatile uint64_t seq;
 	uint64_t * all_debug1;
 	uint64_t * all_debug2;
 	char _pad[CL_SIZE];
@@ -59,6 +115,15 @@ public:
 	void add_debug(uint64_t thd_id, uint64_t value, uint32_t select);
 	void commit(uint64_t thd_id);
 	void abort(uint64_t thd_id);
+	// bracket the stats updates of a finished txn, for the Sampler
+	void begin_update(uint64_t thd_id);
+	void end_update(uint64_t thd_id);
+	void add_latency(uint64_t thd_id, uint32_t txn_type, LatType lat_type, uint64_t ns) {
+		if (STATS_ENABLE)
+			_stats[thd_id]->lat_hists[txn_type * LAT_TYPE_CNT + lat_type].add(ns);
+	}
 	void print();
 	void print_lat_distr();
+	// percentiles of the latency histograms of all threads
+	void print_lat_hist(FILE * outf);
 };
@@ -11,7 +11,12 @@
 #include "ycsb_query.h"
 #include "tpcc_query.h"
 #include "mem_alloc.h"
+#include "epoch_gc.h"
 #include "test.h"
+#include "ycsb.h"
+#include "tpcc.h"
+#include "abort_prof.h"
+#include "row_silo.h"
 
 void thread_t::init(uint64_t thd_id, workload * workload) {
 	_thd_id = thd_id;
@@ -23,6 +28,8 @@ void thread_t::init(uint64_t thd_id, workload * workload) {
 		_abort_buffer[i].query = NULL;
 	_abort_buffer_empty_slots = _abort_buffer_size;
 	_abort_buffer_enable = (g_params["abort_buffer_enable"] == "true");
+	if (g_arrival_rate > 0)
+		_arrival_intvl = 1000000000.0 * g_thread_cnt / g_arrival_rate;
 }
 
 uint64_t thread_t::get_thd_id() { return _thd_id; }
@@ -32,6 +39,21 @@ uint64_t thread_t::get_cur_cid() { return _cur_cid; }
 void thread_t::set_cur_cid(uint64_t cid) {_cur_cid = cid; }
 
 RC thread_t::run() {
+	// the loop of the algorithm, so every access in it is bound at compile time
+	CC_DISPATCH(run_loop, ())
+	return ERROR;
+}
+
+template<int ALG>
+static RC run_txn(txn_man * txn, base_query * query) {
+	if (WORKLOAD == YCSB)
+		return ((ycsb_txn_man *) txn)->run_txn<ALG>(query);
+	else 
+		return ((tpcc_txn_man *) txn)->run_txn<ALG>(query);
+}
+
+template<int ALG>
+RC thread_t::run_loop() {
 #if !NOGRAPHITE
 	_thd_id = CarbonGetTileId();
 #endif
@@ -55,9 +77,11 @@ RC thread_t::run() {
 	base_query * m_query = NULL;
 	uint64_t thd_txn_id = 0; // ID inside this thread
 	UInt64 txn_cnt = 0;
+	_next_arrival = get_sys_clock();
 
 	while (true) {
 		ts_t starttime = get_sys_clock();
+		ts_t attempt_start = 0;
 		if (WORKLOAD != TEST) {
 			int trial = 0; // Trials we are willing to make on checking abort buffer
 			if (_abort_buffer_enable) { // Now clear this buffer
@@ -84,17 +108,31 @@ RC thread_t::run() {
 					}
 					else if (m_query == NULL) { // No aborted txn found, check a normal one
 						m_query = query_queue->get_next_query( _thd_id );
-					#if CC_ALG == WAIT_DIE
-						m_txn->set_ts(get_next_ts());
-					#endif
+						m_query->arrival_time = get_arrival();
+						m_query->start_time = 0;
+						if (ALG == WAIT_DIE)
+							m_txn->set_ts(get_next_ts());
 					}
 					if (m_query != NULL) // Found an aborted or normal query
 						break;
 				}
 			} else {
-				if (rc == RCOK) // NOTE: what if next query is NULL? Check `txn_cnt`, can guarantee finish condition
+				if (rc == RCOK) { // NOTE: what if next query is NULL? Check `txn_cnt`, can guarantee finish condition
 					m_query = query_queue->get_next_query( _thd_id ); // Each thread gets its own next query
+					m_query->arrival_time = get_arrival();
+					m_query->start_time = 0;
+				}
+			}
+			// open loop: a txn does not start before it arrives. The idle
+			// time is not part of any stat but the latency from arrival.
+			if (m_query->arrival_time > get_sys_clock()) {
+				ts_t idle_start = get_sys_clock();
+				wait_arrival(m_query->arrival_time);
+				starttime += get_sys_clock() - idle_start;
 			}
+			attempt_start = get_sys_clock();
+			if (m_query->start_time == 0)
+				m_query->start_time = attempt_start;
 		}
 		INC_STATS(_thd_id, time_query, get_sys_clock() - starttime);
 		m_txn->abort_cnt = 0;
@@ -104,44 +142,71 @@ RC thread_t::run() {
 		m_txn->set_txn_id(get_thd_id() + thd_txn_id * g_thread_cnt); // Each txn with (ID modulo cnt=4) = thd_id will belong to me
 		thd_txn_id ++;
 
-		if ((CC_ALG == HSTORE && !HSTORE_LOCAL_TS)
-				|| CC_ALG == MVCC 
-				|| CC_ALG == HEKATON
-				|| CC_ALG == TIMESTAMP) 
+		if ((ALG == HSTORE && !HSTORE_LOCAL_TS)
+				|| ALG == MVCC 
+				|| ALG == HEKATON
+				|| ALG == TIMESTAMP) 
 			m_txn->set_ts(get_next_ts());
 
+		m_txn->cur_query = m_query;
+		m_txn->reset_abort();
 		rc = RCOK;
-#if CC_ALG == HSTORE
-		if (WORKLOAD == TEST) {
-			uint64_t part_to_access[1] = {0};
-			rc = part_lock_man.lock(m_txn, &part_to_access[0], 1);
-		} else 
-			rc = part_lock_man.lock(m_txn, m_query->part_to_access, m_query->part_num);
-#elif CC_ALG == VLL
-		vll_man.vllMainLoop(m_txn, m_query);
-#elif CC_ALG == MVCC || CC_ALG == HEKATON
-		glob_manager->add_ts(get_thd_id(), m_txn->get_ts());
-#elif CC_ALG == OCC
-		// In the original OCC paper, start_ts only reads the current ts without advancing it.
-		// But we advance the global ts here to simplify the implementation. However, the final
-		// results should be the same.
-		m_txn->start_ts = get_next_ts(); // Default: no batch, using CAS
-#endif
-		if (rc == RCOK) 
-		{
-#if CC_ALG != VLL
-			if (WORKLOAD == TEST)
-				rc = runTest(m_txn);
-			else 
-				rc = m_txn->run_txn(m_query); // Now run our txn and get running code
-#endif
-#if CC_ALG == HSTORE
+		if constexpr (ALG == HSTORE) {
 			if (WORKLOAD == TEST) {
 				uint64_t part_to_access[1] = {0};
-				part_lock_man.unlock(m_txn, &part_to_access[0], 1);
+				rc = part_lock_man.lock(m_txn, &part_to_access[0], 1);
 			} else 
-				part_lock_man.unlock(m_txn, m_query->part_to_access, m_query->part_num);
-#endif
+				rc = part_lock_man.lock(m_txn, m_query->part_to_access, m_query->part_num);
+		} else if constexpr (ALG == VLL)
+			vll_man.vllMainLoop(m_txn, m_query);
+		else if constexpr (ALG == MVCC || ALG == HEKATON) {
+			ts_t snapshot = glob_manager->add_ts(get_thd_id(), m_txn->get_ts());
+			// 0 until every thread has started a txn
+			m_txn->read_snapshot = g_read_only_snapshot && WORKLOAD != TEST
+				&& m_query->read_only && snapshot > 0;
+			if (m_txn->read_snapshot)
+				m_txn->set_ts(snapshot);
+			epoch_gc.enter(get_thd_id()); // Versions we read stay allocated until exit()
+		} else if constexpr (ALG == SILO) {
+			if (g_read_only_snapshot) {
+				if (!g_log_redo && !g_log_command)
+					glob_manager->update_epoch();
+				// a txn commits in the epoch it starts in or a later one, so
+				// every txn of an epoch below the mark is done
+				ts_t snapshot = glob_manager->add_ts(get_thd_id(), glob_manager->get_epoch());
+				m_txn->read_snapshot = WORKLOAD != TEST && m_query->read_only && snapshot > 0;
+				if (m_txn->read_snapshot)
+					m_txn->set_ts(SNAPSHOT_BEFORE(snapshot));
+				m_txn->prune_versions();
+				epoch_gc.enter(get_thd_id());
+			}
+		} else if constexpr (ALG == OCC) {
+			// In the original OCC paper, start_ts only reads the current ts without advancing it.
+			// But we advance the global ts here to simplify the implementation. However, the final
+			// results should be the same.
+			m_txn->start_ts = get_next_ts(); // Default: no batch, using CAS
+		}
+		if (rc == RCOK) 
+		{
+			if constexpr (ALG != VLL) {
+				if (WORKLOAD == TEST)
+					rc = runTest<ALG>(m_txn);
+				else 
+					rc = run_txn<ALG>(m_txn, m_query); // Now run our txn and get running code
+			}
+			if constexpr (ALG == HSTORE) {
+				if (WORKLOAD == TEST) {
+					uint64_t part_to_access[1] = {0};
+					part_lock_man.unlock(m_txn, &part_to_access[0], 1);
+				} else 
+					part_lock_man.unlock(m_txn, m_query->part_to_access, m_query->part_num);
+			}
+		}
+		if constexpr (ALG == MVCC || ALG == HEKATON)
+			epoch_gc.exit(get_thd_id());
+		else if constexpr (ALG == SILO) {
+			if (g_read_only_snapshot)
+				epoch_gc.exit(get_thd_id());
 		}
 		if (rc == Abort) {
 			uint64_t penalty = 0; // Nanosecond
@@ -167,19 +232,42 @@ RC thread_t::run() {
 
 		ts_t endtime = get_sys_clock();
 		uint64_t timespan = endtime - starttime;
+		stats.begin_update(get_thd_id());
 		INC_STATS(get_thd_id(), run_time, timespan);
 		INC_STATS(get_thd_id(), latency, timespan);
 		//stats.add_lat(get_thd_id(), timespan);
 		if (rc == RCOK) {
+			if (WORKLOAD != TEST) {
+				INC_STATS(get_thd_id(), arrival_latency, endtime - m_query->arrival_time);
+				uint32_t type = m_query->get_txn_type();
+				stats.add_latency(get_thd_id(), type, LAT_QUEUE, 
+					m_query->start_time - m_query->arrival_time);
+				stats.add_latency(get_thd_id(), type, LAT_RETRY, 
+					attempt_start - m_query->start_time);
+				stats.add_latency(get_thd_id(), type, LAT_COMMIT, 
+					endtime - m_query->arrival_time);
+				if (m_query->read_only) {
+					INC_STATS(get_thd_id(), ro_txn_cnt, 1);
+					INC_STATS(get_thd_id(), ro_run_time, timespan);
+				}
+				query_queue->release_query(_thd_id, m_query);
+			}
 			INC_STATS(get_thd_id(), txn_cnt, 1);
 			stats.commit(get_thd_id());
 			txn_cnt ++;
 		} else if (rc == Abort) {
 			INC_STATS(get_thd_id(), time_abort, timespan);
 			INC_STATS(get_thd_id(), abort_cnt, 1);
+			if (WORKLOAD != TEST && m_query->read_only) {
+				INC_STATS(get_thd_id(), ro_abort_cnt, 1);
+				INC_STATS(get_thd_id(), ro_run_time, timespan);
+			}
+			if (g_prof_abort && warmup_finish)
+				abort_prof.record(get_thd_id(), m_txn->abort_reason, m_txn->abort_row, timespan);
 			stats.abort(get_thd_id());
 			m_txn->abort_cnt ++;
 		}
+		stats.end_update(get_thd_id());
 
 		if (rc == FINISH)
 			return rc;
@@ -202,6 +290,33 @@ RC thread_t::run() {
 }
 
 
+ts_t
+thread_t::get_arrival() {
+	if (g_arrival_rate == 0)
+		return get_sys_clock();
+	ts_t arrival = _next_arrival;
+	double intvl = _arrival_intvl;
+	if (g_arrival_poisson) {
+		double r;
+		drand48_r(&buffer, &r);
+		intvl = -log(1 - r) * _arrival_intvl;
+	}
+	_next_arrival += (ts_t) intvl;
+	return arrival;
+}
+
+void
+thread_t::wait_arrival(ts_t arrival) {
+	ts_t now;
+	while ((now = get_sys_clock()) < arrival) {
+		// sleep through most of a long wait and spin through the rest
+		if (arrival - now > 100000)
+			usleep((arrival - now) / 2000);
+		else
+			PAUSE
+	}
+}
+
 ts_t
 thread_t::get_next_ts() {
 	if (g_ts_batch_alloc) {
@@ -218,20 +333,20 @@ thread_t::get_next_ts() {
 	}
 }
 
+template<int ALG>
 RC thread_t::runTest(txn_man * txn)
 {
 	RC rc = RCOK;
 	if (g_test_case == READ_WRITE) {
-		rc = ((TestTxnMan *)txn)->run_txn(g_test_case, 0);
-#if CC_ALG == OCC
-		txn->start_ts = get_next_ts(); 
-#endif
-		rc = ((TestTxnMan *)txn)->run_txn(g_test_case, 1);
+		rc = ((TestTxnMan *)txn)->run_txn<ALG>(g_test_case, 0);
+		if (ALG == OCC)
+			txn->start_ts = get_next_ts(); 
+		rc = ((TestTxnMan *)txn)->run_txn<ALG>(g_test_case, 1);
 		printf("READ_WRITE TEST PASSED\n");
 		return FINISH;
 	}
 	else if (g_test_case == CONFLICT) {
-		rc = ((TestTxnMan *)txn)->run_txn(g_test_case, 0);
+		rc = ((TestTxnMan *)txn)->run_txn<ALG>(g_test_case, 0);
 		if (rc == RCOK)
 			return FINISH;
 		else 
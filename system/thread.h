@@ -24,15 +24,25 @@ public:
 	// conversion is done within the function.
 	RC 			run();
 private:
+	// the thread loop of algorithm ALG, picked by run()
+	template<int ALG>
+	RC 			run_loop();
 	uint64_t 	_host_cid;
 	uint64_t 	_cur_cid;
 	ts_t 		_curr_ts;
 	// Alloc ts for a certain thread
 	ts_t 		get_next_ts();
 
+	template<int ALG>
 	RC	 		runTest(txn_man * txn);
 	drand48_data buffer;
 
+	// [ARRIVAL_RATE] the arrival time of the next txn of this thread
+	ts_t 		get_arrival();
+	void 		wait_arrival(ts_t arrival);
+	ts_t 		_next_arrival;
+	double 		_arrival_intvl; // mean ns between two arrivals
+
 	// A restart buffer for aborted txns.
 	struct AbortBufferEntry	{
 		ts_t ready_time; // Next time to be ready
@@ -8,7 +8,13 @@
 #include "table.h"
 #include "catalog.h"
 #include "index_btree.h"
+#include "index_btree_olc.h"
 #include "index_hash.h"
+#include "index_hash_lf.h"
+#include "row_mvcc.h"
+#include "row_hekaton.h"
+#include "row_silo.h"
+#include "logger.h"
 
 void txn_man::init(thread_t * h_thd, workload * h_wl, uint64_t thd_id) {
 	this->h_thd = h_thd;
@@ -16,29 +22,32 @@ void txn_man::init(thread_t * h_thd, workload * h_wl, uint64_t thd_id) {
 	pthread_mutex_init(&txn_lock, NULL);
 	lock_ready = false;
 	ready_part = 0;
+	read_snapshot = false;
 	row_cnt = 0;
 	wr_cnt = 0;
 	insert_cnt = 0;
+	read_cols = ALL_COLS;
+	cur_query = NULL;
+	reset_abort();
 	accesses = (Access **) _mm_malloc(sizeof(Access *) * MAX_ROW_PER_TXN, 64);
 	for (int i = 0; i < MAX_ROW_PER_TXN; i++)
 		accesses[i] = NULL;
 	num_accesses_alloc = 0;
-#if CC_ALG == TICTOC || CC_ALG == SILO
-	_pre_abort = (g_params["pre_abort"] == "true");
-	if (g_params["validation_lock"] == "no-wait")
-		_validation_no_wait = true;
-	else if (g_params["validation_lock"] == "waiting")
-		_validation_no_wait = false;
-	else 
-		assert(false);
-#endif
-#if CC_ALG == TICTOC
-	_max_wts = 0;
-	_write_copy_ptr = (g_params["write_copy_form"] == "ptr");
-	_atomic_timestamp = (g_params["atomic_timestamp"] == "true");
-#elif CC_ALG == SILO
+	if (g_cc_alg == TICTOC || g_cc_alg == SILO) {
+		_pre_abort = (g_params["pre_abort"] == "true");
+		if (g_params["validation_lock"] == "no-wait")
+			_validation_no_wait = true;
+		else if (g_params["validation_lock"] == "waiting")
+			_validation_no_wait = false;
+		else 
+			assert(false);
+	}
+	if (g_cc_alg == TICTOC) {
+		_max_wts = 0;
+		_write_copy_ptr = (g_params["write_copy_form"] == "ptr");
+		_atomic_timestamp = (g_params["atomic_timestamp"] == "true");
+	}
 	_cur_tid = 0;
-#endif
 
 }
 // Give this txn an ID (global)
@@ -66,13 +75,19 @@ ts_t txn_man::get_ts() {
 	return this->timestamp;
 }
 // Clean up work not finished: release, rollback, reset
+template<int ALG>
 void txn_man::cleanup(RC rc) {
-#if CC_ALG == HEKATON
-	row_cnt = 0;
-	wr_cnt = 0;
-	insert_cnt = 0;
-	return;
-#endif
+	// The rows of an aborted insert are not freed. They lie in the segment
+	// of their table, which never gives memory back.
+	if (rc == Abort)
+		for (uint64_t i = 0; i < insert_cnt; i++)
+			insert_rows[i]->set_hole();
+	if constexpr (ALG == HEKATON) {
+		row_cnt = 0;
+		wr_cnt = 0;
+		insert_cnt = 0;
+		return;
+	}
 	// NOTE: what if some succeed but ended up abort?
 	// We only rollback what we touch
 	// NOTE: why not commit all rows together? What if txns interleavingly commit?
@@ -82,98 +97,133 @@ void txn_man::cleanup(RC rc) {
 		if (type == WR && rc == Abort)
 			type = XP;
 
-#if (CC_ALG == NO_WAIT || CC_ALG == DL_DETECT) && ISOLATION_LEVEL == REPEATABLE_READ
-		if (type == RD) {
-			accesses[rid]->data = NULL;
-			continue;
+#if ISOLATION_LEVEL == REPEATABLE_READ
+		if constexpr (ALG == NO_WAIT || ALG == DL_DETECT) {
+			if (type == RD) {
+				accesses[rid]->data = NULL;
+				continue;
+			}
 		}
 #endif
 
 		if (ROLL_BACK && type == XP &&
-					(CC_ALG == DL_DETECT || 
-					CC_ALG == NO_WAIT || 
-					CC_ALG == WAIT_DIE)) 
+					(ALG == DL_DETECT || 
+					ALG == NO_WAIT || 
+					ALG == WAIT_DIE)) 
 		{
-			orig_r->return_row(type, this, accesses[rid]->orig_data); // If aborted write, recover the original data
+			orig_r->return_row<ALG>(type, this, accesses[rid]->orig_data); // If aborted write, recover the original data
 		} else {
-			orig_r->return_row(type, this, accesses[rid]->data); // Default, may write new data back to the original row
+			orig_r->return_row<ALG>(type, this, accesses[rid]->data); // Default, may write new data back to the original row
 		}
-#if CC_ALG != TICTOC && CC_ALG != SILO
-		accesses[rid]->data = NULL; // Data buffer is already returned
-#endif
+		if constexpr (ALG != TICTOC && ALG != SILO)
+			accesses[rid]->data = NULL; // Data buffer is already returned
 	}
 
-	if (rc == Abort) {
-		for (UInt32 i = 0; i < insert_cnt; i ++) {
-			row_t * row = insert_rows[i];
-			assert(g_part_alloc == false);
-#if CC_ALG != HSTORE && CC_ALG != OCC
-			mem_allocator.free(row->manager, 0);
-#endif
-			row->free_row();
-			mem_allocator.free(row, sizeof(row));
-		}
-	}
 	row_cnt = 0;
 	wr_cnt = 0;
 	insert_cnt = 0;
-#if CC_ALG == DL_DETECT
-	dl_detector.clear_dep(get_txn_id());
-#endif
+	if constexpr (ALG == DL_DETECT)
+		dl_detector.clear_dep(get_txn_id());
 }
 // Get access to a row. See `row_t::get_row`. We will additionally record info in `this->accesses`
+template<int ALG>
 row_t * txn_man::get_row(row_t * row, access_t type) {
-	if (CC_ALG == HSTORE)
+	if constexpr (ALG == HSTORE)
 		return row;
 	uint64_t starttime = get_sys_clock();
 	RC rc = RCOK;
+	// rows of a range scan are read the same way as point reads
+	if (type == SCAN)
+		type = RD;
+	if constexpr (ALG == MVCC || ALG == HEKATON) {
+		if (read_snapshot) {
+			assert(type == RD);
+			// nothing to validate or give back at the end, so nothing is recorded
+			row_t * version = row->get_manager<ALG>()->read_snapshot(get_ts());
+			if (version == NULL) {
+				set_abort(ABORT_VERSION, row);
+				return NULL;
+			}
+			INC_TMP_STATS(get_thd_id(), time_man, get_sys_clock() - starttime);
+			return version;
+		}
+	}
+	assert(row_cnt < MAX_ROW_PER_TXN);
 	if (accesses[row_cnt] == NULL) { // No enough slots even though reusing, alloc a new one
 		Access * access = (Access *) _mm_malloc(sizeof(Access), 64);
 		accesses[row_cnt] = access;
-#if (CC_ALG == SILO || CC_ALG == TICTOC)
-		access->data = (row_t *) _mm_malloc(sizeof(row_t), 64);
-		access->data->init(MAX_TUPLE_SIZE);
-		access->orig_data = (row_t *) _mm_malloc(sizeof(row_t), 64);
-		access->orig_data->init(MAX_TUPLE_SIZE);
-#elif (CC_ALG == DL_DETECT || CC_ALG == NO_WAIT || CC_ALG == WAIT_DIE)
-		access->orig_data = (row_t *) _mm_malloc(sizeof(row_t), 64);
-		access->orig_data->init(MAX_TUPLE_SIZE);
-#endif
+		if constexpr (ALG == SILO || ALG == TICTOC) {
+			access->data = (row_t *) _mm_malloc(sizeof(row_t), 64);
+			access->data->init(MAX_TUPLE_SIZE);
+			access->orig_data = (row_t *) _mm_malloc(sizeof(row_t), 64);
+			access->orig_data->init(MAX_TUPLE_SIZE);
+		} else if constexpr (ALG == DL_DETECT || ALG == NO_WAIT || ALG == WAIT_DIE) {
+			access->orig_data = (row_t *) _mm_malloc(sizeof(row_t), 64);
+			access->orig_data->init(MAX_TUPLE_SIZE);
+		}
 		num_accesses_alloc ++;
 	}
+	if constexpr (ALG == SILO) {
+		if (read_snapshot) {
+			assert(type == RD);
+			// a copy of its own like any read, but it is not validated
+			row_t * local = accesses[row_cnt]->data;
+			local->table = row->get_table();
+			row->get_manager<ALG>()->read_snapshot(get_ts(), local, read_cols);
+			accesses[row_cnt]->type = RD;
+			accesses[row_cnt]->orig_row = row;
+			row_cnt ++;
+			INC_TMP_STATS(get_thd_id(), time_man, get_sys_clock() - starttime);
+			return local;
+		}
+	}
 	// NOTE: if a copy is returned, this `row` should be a different obj from that row stored in `txn` or `accesses`
 	// `this` row becomes the original row and may change once we release the latch
-	rc = row->get_row(type, this, accesses[ row_cnt ]->data);
+	rc = row->get_row<ALG>(type, this, accesses[ row_cnt ]->data);
 
 
 	if (rc == Abort) {
+		// the cause unless the CC already named a more specific one
+		if constexpr (ALG == NO_WAIT)
+			set_abort(ABORT_CONFLICT, row);
+		else if constexpr (ALG == WAIT_DIE)
+			set_abort(ABORT_WAIT_DIE, row);
+		else if constexpr (ALG == DL_DETECT)
+			set_abort(ABORT_DEADLOCK, row);
+		else if constexpr (ALG == TIMESTAMP || ALG == MVCC || ALG == HEKATON)
+			set_abort(ABORT_TS_ORDER, row);
+		else
+			set_abort(ABORT_VALIDATE, row);
 		return NULL;
 	}
 	accesses[row_cnt]->type = type;
 	accesses[row_cnt]->orig_row = row;
-#if CC_ALG == TICTOC
-	accesses[row_cnt]->wts = last_wts;
-	accesses[row_cnt]->rts = last_rts;
-#elif CC_ALG == SILO
-	accesses[row_cnt]->tid = last_tid;
-#elif CC_ALG == HEKATON
-	accesses[row_cnt]->history_entry = history_entry;
-#endif
+	if constexpr (ALG == TICTOC) {
+		accesses[row_cnt]->wts = last_wts;
+		accesses[row_cnt]->rts = last_rts;
+	} else if constexpr (ALG == SILO)
+		accesses[row_cnt]->tid = last_tid;
+	else if constexpr (ALG == HEKATON)
+		accesses[row_cnt]->history_entry = history_entry;
 
-#if ROLL_BACK && (CC_ALG == DL_DETECT || CC_ALG == NO_WAIT || CC_ALG == WAIT_DIE)
-	if (type == WR) {
-		accesses[row_cnt]->orig_data->table = row->get_table();
-		accesses[row_cnt]->orig_data->copy(row);
+#if ROLL_BACK
+	if constexpr (ALG == DL_DETECT || ALG == NO_WAIT || ALG == WAIT_DIE) {
+		if (type == WR) {
+			accesses[row_cnt]->orig_data->table = row->get_table();
+			accesses[row_cnt]->orig_data->copy(row);
+		}
 	}
 #endif
 
-#if (CC_ALG == NO_WAIT || CC_ALG == DL_DETECT) && ISOLATION_LEVEL == REPEATABLE_READ
-	if (type == RD)
-		row->return_row(type, this, accesses[ row_cnt ]->data);
+#if ISOLATION_LEVEL == REPEATABLE_READ
+	if constexpr (ALG == NO_WAIT || ALG == DL_DETECT) {
+		if (type == RD)
+			row->return_row<ALG>(type, this, accesses[ row_cnt ]->data);
+	}
 #endif
 	
 	row_cnt ++;
-	if (type == WR) // SCAN maybe treated as RD, each time we receive different `row`
+	if (type == WR)
 		wr_cnt ++;
 
 	uint64_t timespan = get_sys_clock() - starttime;
@@ -182,8 +232,6 @@ row_t * txn_man::get_row(row_t * row, access_t type) {
 }
 // Never used?
 void txn_man::insert_row(row_t * row, table_t * table) {
-	if (CC_ALG == HSTORE)
-		return;
 	assert(insert_cnt < MAX_ROW_PER_TXN);
 	insert_rows[insert_cnt ++] = row;
 }
@@ -204,32 +252,76 @@ txn_man::index_read(INDEX * index, idx_key_t key, int part_id, itemid_t *& item)
 	INC_TMP_STATS(get_thd_id(), time_index, get_sys_clock() - starttime);
 }
 
+void 
+txn_man::index_scan(INDEX * index, idx_key_t lo, idx_key_t hi, int part_id, idx_cursor &cursor) {
+	uint64_t starttime = get_sys_clock();
+	index->index_scan(lo, hi, cursor, part_id);
+	INC_TMP_STATS(get_thd_id(), time_index, get_sys_clock() - starttime);
+}
+
+itemid_t *
+txn_man::index_next(INDEX * index, idx_cursor &cursor) {
+	uint64_t starttime = get_sys_clock();
+	itemid_t * item;
+	index->index_next(cursor, item);
+	INC_TMP_STATS(get_thd_id(), time_index, get_sys_clock() - starttime);
+	return item;
+}
+
+void txn_man::on_commit(ts_t seq) {
+	if (g_log_redo || g_log_command)
+		log_manager.log_txn(this, seq);
+	if (insert_cnt == 0)
+		return;
+	// in the order of the inserts, so whoever finds a row finds those
+	// inserted before it
+	uint64_t starttime = get_sys_clock();
+	for (uint64_t i = 0; i < insert_cnt; i++)
+		h_wl->index_row(insert_rows[i]->get_table(), insert_rows[i]);
+	INC_TMP_STATS(get_thd_id(), time_index, get_sys_clock() - starttime);
+}
+
+template<int ALG>
 RC txn_man::finish(RC rc) {
-#if CC_ALG == HSTORE
-	return RCOK;
-#endif
+	if constexpr (ALG == HSTORE) {
+		// partitions are still locked
+		if (rc == RCOK)
+			on_commit(get_sys_clock());
+		insert_cnt = 0;
+		return RCOK;
+	}
+	if constexpr (ALG == MVCC || ALG == HEKATON || ALG == SILO) {
+		// the snapshot is consistent as it is
+		if (read_snapshot) {
+			row_cnt = 0;
+			return rc;
+		}
+	}
 	uint64_t starttime = get_sys_clock();
-#if CC_ALG == OCC
-	if (rc == RCOK)
-		rc = occ_man.validate(this);
-	else 
-		cleanup(rc); // Write and release resources
-#elif CC_ALG == TICTOC
-	if (rc == RCOK)
-		rc = validate_tictoc();
-	else 
-		cleanup(rc);
-#elif CC_ALG == SILO
-	if (rc == RCOK)
-		rc = validate_silo();
-	else 
-		cleanup(rc);
-#elif CC_ALG == HEKATON
-	rc = validate_hekaton(rc);
-	cleanup(rc);
-#else 
-	cleanup(rc);
-#endif
+	if constexpr (ALG == OCC) {
+		if (rc == RCOK)
+			rc = occ_man.validate(this);
+		else 
+			cleanup<ALG>(rc); // Write and release resources
+	} else if constexpr (ALG == TICTOC) {
+		if (rc == RCOK)
+			rc = validate_tictoc();
+		else 
+			cleanup<ALG>(rc);
+	} else if constexpr (ALG == SILO) {
+		if (rc == RCOK)
+			rc = validate_silo();
+		else 
+			cleanup<ALG>(rc);
+	} else if constexpr (ALG == HEKATON) {
+		rc = validate_hekaton(rc);
+		cleanup<ALG>(rc);
+	} else {
+		// locks are still held. TIMESTAMP and MVCC order writes by the txn ts.
+		if (rc == RCOK)
+			on_commit((ALG == TIMESTAMP || ALG == MVCC)? get_ts() : get_sys_clock());
+		cleanup<ALG>(rc);
+	}
 	uint64_t timespan = get_sys_clock() - starttime;
 	INC_TMP_STATS(get_thd_id(), time_man,  timespan);
 	INC_STATS(get_thd_id(), time_cleanup,  timespan);
@@ -242,3 +334,9 @@ txn_man::release() {
 		mem_allocator.free(accesses[i], 0);
 	mem_allocator.free(accesses, 0);
 }
+
+#define TXN_ACCESS(alg) \
+	template row_t * txn_man::get_row<alg>(row_t *, access_t); \
+	template RC txn_man::finish<alg>(RC); \
+	template void txn_man::cleanup<alg>(RC);
+CC_EACH(TXN_ACCESS)
@@ -9,6 +9,7 @@ class row_t;
 class table_t;
 class base_query;
 class INDEX;
+struct idx_cursor;
 
 // each thread has a txn_man. 
 // a txn_man corresponds to a single transaction.
@@ -23,18 +24,26 @@ public:
 	row_t * 	data; // Data we want to read or write
 	row_t * 	orig_data; // Original data, no need in OCC
 	void cleanup();
-#if CC_ALG == TICTOC
+	// [TICTOC]
 	ts_t 		wts;
 	ts_t 		rts;
-#elif CC_ALG == SILO
+	// [SILO]
 	ts_t 		tid;
 	ts_t 		epoch;
-#elif CC_ALG == HEKATON
+	// [HEKATON]
 	void * 		history_entry;	
-#endif
 
 };
 
+class Row_silo;
+// [READ_ONLY_SNAPSHOT] a row that kept a version no snapshot reads once the
+// oldest one is at `end`
+struct SiloKept {
+	SiloKept(Row_silo * row, ts_t end) : row(row), end(end) {}
+	Row_silo * 	row;
+	ts_t 		end;
+};
+
 class txn_man
 {
 public:
@@ -44,8 +53,6 @@ public:
 	workload * h_wl;
 	myrand * mrand;
 	uint64_t abort_cnt; // Num of abort when dealing with one txn. May be useless
-	// Run a txn/query and get running code. Resouces are handled internally. If abort, may restart later
-	virtual RC 		run_txn(base_query * m_query) = 0;
 	uint64_t 		get_thd_id();
 	workload * 		get_wl();
 	void 			set_txn_id(txnid_t txn_id);
@@ -57,9 +64,9 @@ public:
 
 	pthread_mutex_t txn_lock;
 	row_t * volatile cur_row; // Content of the row we are currently dealing with
-#if CC_ALG == HEKATON
+	base_query * 	cur_query; // [LOG_COMMAND] the query being run
+	// [HEKATON]
 	void * volatile history_entry;
-#endif
 	// [DL_DETECT, NO_WAIT, WAIT_DIE]
 	bool volatile 	lock_ready;
 	bool volatile 	lock_abort; // forces another waiting txn to abort.
@@ -67,23 +74,49 @@ public:
 	bool volatile 	ts_ready;  // Whether a pending req in queue is ready
 	// [HSTORE]
 	int volatile 	ready_part;
+	// [MVCC, HEKATON, SILO, READ_ONLY_SNAPSHOT] the txn only reads, at the
+	// snapshot of its ts (an epoch under SILO). Its reads are not validated.
+	bool 			read_snapshot;
+	// [PROF_ABORT] the first cause of the abort of the running attempt and
+	// the row it happened on (NULL if there is none)
+	AbortReason 	abort_reason;
+	row_t * 		abort_row;
+	void 			set_abort(AbortReason reason, row_t * row) {
+		if (abort_reason == ABORT_NONE) {
+			abort_reason = reason;
+			abort_row = row;
+		}
+	}
+	void 			reset_abort() { abort_reason = ABORT_NONE; abort_row = NULL; }
+	// The CC paths are instantiated once per algorithm (cf. cc_policy.h)
+	template<int ALG>
 	RC 				finish(RC rc);
+	template<int ALG>
 	void 			cleanup(RC rc);
-#if CC_ALG == TICTOC
+	// At the serialization point, before others can see the writes: appends
+	// the commit record when logging is on and indexes the inserted rows.
+	// `seq` orders the txn among those writing the same rows.
+	void 			on_commit(ts_t seq);
+	// [TICTOC]
 	ts_t 			get_max_wts() 	{ return _max_wts; }
 	void 			update_max_wts(ts_t max_wts);
 	ts_t 			last_wts;
 	ts_t 			last_rts;
-#elif CC_ALG == SILO
+	// [SILO]
 	ts_t 			last_tid;
-#endif
+	// in the order they were kept, so by `end`. A row is pruned again when
+	// it is not written before that.
+	deque<SiloKept> kept_versions;
+	void 			prune_versions();
 	
 	// For OCC
 	uint64_t 		start_ts;
 	uint64_t 		end_ts;
 	// following are public for OCC
-	int 			row_cnt; // How many rows we accessed (WR or RD, can have repetitions, no SCAN up to now)
+	int 			row_cnt; // How many rows we accessed (WR or RD, can have repetitions, each scanned row counts as RD)
 	int	 			wr_cnt; // How many rows we wrote
+	uint64_t 		insert_cnt; // Number of inserted rows
+	row_t * 		insert_rows[MAX_ROW_PER_TXN]; // Rows we inserted, in order
 	Access **		accesses; // Those accesses we made in this txn
 	int 			num_accesses_alloc; // Max number of slots in `accesses` we use. Note that `row_cnt` can be reset in `cleanup` thus slots can be reused
 
@@ -91,30 +124,41 @@ public:
 	TxnType 		vll_txn_type;
 	itemid_t *		index_read(INDEX * index, idx_key_t key, int part_id);
 	void 			index_read(INDEX * index, idx_key_t key, int part_id, itemid_t *& item);
+	// range scan over [lo, hi]. index_next returns NULL past the range.
+	void 			index_scan(INDEX * index, idx_key_t lo, idx_key_t hi, int part_id, idx_cursor &cursor);
+	itemid_t * 		index_next(INDEX * index, idx_cursor &cursor);
+	template<int ALG>
 	row_t * 		get_row(row_t * row, access_t type);
+	// a RD of the columns in the mask `cols` (bit i is column i) only. The
+	// copy the CC makes holds only those, so a PAX row is not gathered.
+	template<int ALG>
+	row_t * 		get_row(row_t * row, access_t type, uint64_t cols) {
+		assert(type == RD);
+		read_cols = cols;
+		row_t * local = get_row<ALG>(row, type);
+		read_cols = ALL_COLS;
+		return local;
+	}
+	// the columns the CC copies on a read, ALL_COLS but in the call above
+	uint64_t 		read_cols;
 protected:	
 	void 			insert_row(row_t * row, table_t * table);
 private:
-	// insert rows
-	uint64_t 		insert_cnt; // Number of inserted rows
-	row_t * 		insert_rows[MAX_ROW_PER_TXN]; // Rows we inserted
 	txnid_t 		txn_id; // My currently processing txn, its ID among all possible txn
 	ts_t 			timestamp; // This txn's start ts
 
 	bool _write_copy_ptr;
-#if CC_ALG == TICTOC || CC_ALG == SILO
+	// [TICTOC, SILO]
 	bool 			_pre_abort;
 	bool 			_validation_no_wait;
-#endif
-#if CC_ALG == TICTOC
+	// [TICTOC]
 	bool			_atomic_timestamp;
 	ts_t 			_max_wts;
 	// the following methods are defined in concurrency_control/tictoc.cpp
 	RC				validate_tictoc();
-#elif CC_ALG == SILO
+	// [SILO]
 	ts_t 			_cur_tid;
 	RC				validate_silo();
-#elif CC_ALG == HEKATON
+	// [HEKATON]
 	RC 				validate_hekaton(RC rc);
-#endif
 };
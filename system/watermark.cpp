@@ -0,0 +1,49 @@
+#include "watermark.h"
+
+void Watermark::init(uint32_t leaf_cnt) {
+	_level_cnt = 1;
+	for (uint32_t size = leaf_cnt; size > 1; size = (size + WM_FANOUT - 1) / WM_FANOUT)
+		_level_cnt ++;
+	_level_start = new uint32_t [_level_cnt];
+	_level_size = new uint32_t [_level_cnt];
+	uint32_t node_cnt = 0;
+	uint32_t size = leaf_cnt;
+	for (uint32_t lvl = 0; lvl < _level_cnt; lvl ++) {
+		_level_start[lvl] = node_cnt;
+		_level_size[lvl] = size;
+		node_cnt += size;
+		size = (size + WM_FANOUT - 1) / WM_FANOUT;
+	}
+	_root = node_cnt - 1;
+	// 0 until every thread has published once
+	_nodes = (Node *) _mm_malloc(sizeof(Node) * node_cnt, CL_SIZE);
+	for (uint32_t i = 0; i < node_cnt; i ++)
+		_nodes[i].value = 0;
+}
+
+void Watermark::publish(uint32_t id, uint64_t value) {
+	assert(value >= _nodes[id].value);
+	_nodes[id].value = value;
+	uint32_t idx = id;
+	for (uint32_t lvl = 0; lvl + 1 < _level_cnt; lvl ++) {
+		uint32_t first = idx / WM_FANOUT * WM_FANOUT;
+		uint32_t last = first + WM_FANOUT;
+		if (last > _level_size[lvl])
+			last = _level_size[lvl];
+		uint64_t min = UINT64_MAX;
+		for (uint32_t i = first; i < last; i ++) {
+			uint64_t v = _nodes[_level_start[lvl] + i].value;
+			if (v < min)
+				min = v;
+		}
+		idx /= WM_FANOUT;
+		Node * parent = &_nodes[_level_start[lvl + 1] + idx];
+		// The children only grow, so `min` is a lower bound of them even if
+		// they moved meanwhile. A node never goes back.
+		uint64_t old = parent->value;
+		if (min <= old)
+			break; // whoever moved the node carries it further up
+		while (min > old && !ATOM_CAS(parent->value, old, min))
+			old = parent->value;
+	}
+}
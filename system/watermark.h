@@ -0,0 +1,33 @@
+#pragma once
+
+#include "global.h"
+#include "helper.h"
+
+// Low-water mark of values that only grow, one per thread (e.g. the ts of
+// the txn a thread runs). The values are the leaves of a tree of fanout
+// WM_FANOUT, one cache line per node; every inner node holds a lower bound
+// of the leaves below it. A thread that raises its leaf recomputes the
+// nodes on its path to the root and stops at the first one that does not
+// move, so the mark advances as soon as the slowest thread does, whichever
+// thread that is, in O(log n) reads of a few sibling lines.
+#define WM_FANOUT			4
+
+class Watermark {
+public:
+	void 		init(uint32_t leaf_cnt);
+	// raises leaf `id` to `value`. Only one thread may write a leaf.
+	void 		publish(uint32_t id, uint64_t value);
+	// at most the smallest leaf
+	uint64_t 	get() { return _nodes[_root].value; }
+private:
+	struct Node {
+		volatile uint64_t 	value;
+		char 				pad[CL_SIZE - sizeof(uint64_t)];
+	};
+	// all levels in one array, the leaves first
+	Node * 		_nodes;
+	uint32_t 	_level_cnt;
+	uint32_t * 	_level_start;
+	uint32_t * 	_level_size;
+	uint32_t 	_root;
+};
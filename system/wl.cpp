@@ -4,9 +4,12 @@
 #include "row.h"
 #include "table.h"
 #include "index_hash.h"
+#include "index_hash_lf.h"
 #include "index_btree.h"
+#include "index_btree_olc.h"
 #include "catalog.h"
 #include "mem_alloc.h"
+#include "checkpoint.h"
 
 RC workload::init() {
 	sim_done = false;
@@ -23,6 +26,14 @@ RC workload::init_schema(string schema_file) {
 		if (line.compare(0, 6, "TABLE=") == 0) { // If belongs to a table
 			string tname;
 			tname = &line[6];
+			// TABLE=NAME,PAX stores the table column by column
+			bool pax = false;
+			size_t sep = tname.find(",");
+			if (sep != string::npos) {
+				M_ASSERT(tname.substr(sep + 1) == "PAX", "unknown table layout %s\n", tname.c_str());
+				pax = true;
+				tname = tname.substr(0, sep);
+			}
 			schema = (Catalog *) _mm_malloc(sizeof(Catalog), CL_SIZE);
 			getline(fin, line);
 			int col_count = 0;
@@ -33,6 +44,7 @@ RC workload::init_schema(string schema_file) {
 				getline(fin, line);
 			}
 			schema->init( tname.c_str(), lines.size() ); // For YCSB, we have 10 columns
+			schema->pax = pax;
 			for (UInt32 i = 0; i < lines.size(); i++) { // Check each line (column)
 				string line = lines[i];
 			    size_t pos = 0;
@@ -60,7 +72,7 @@ RC workload::init_schema(string schema_file) {
 				col_count ++;
 			}
 			table_t * cur_tab = (table_t *) _mm_malloc(sizeof(table_t), CL_SIZE);
-			cur_tab->init(schema);
+			cur_tab->init(schema, tables.size());
 			tables[tname] = cur_tab;
         } else if (!line.compare(0, 6, "INDEX=")) {
 			string iname;
@@ -85,7 +97,7 @@ RC workload::init_schema(string schema_file) {
 			int part_cnt = (CENTRAL_INDEX)? 1 : g_part_cnt;
 			if (tname == "ITEM")
 				part_cnt = 1;
-#if INDEX_STRUCT == IDX_HASH
+#if INDEX_STRUCT == IDX_HASH || INDEX_STRUCT == IDX_HASH_LF
 	#if WORKLOAD == YCSB
 			index->init(part_cnt, tables[tname], g_synth_table_size * 2); // This size is specified intuitively?
 	#elif WORKLOAD == TPCC
@@ -120,6 +132,8 @@ void workload::index_insert(INDEX * index, uint64_t key, row_t * row, int64_t pa
 	m_item->type = DT_row;
 	m_item->location = row;
 	m_item->valid = true;
+	if (ckpt_man.is_dumping_image())
+		ckpt_man.record_index(index, key, row, pid);
 
     assert( index->index_insert(key, m_item, pid) == RCOK );
 }
@@ -5,7 +5,9 @@
 class row_t;
 class table_t;
 class IndexHash;
+class IndexHashLF;
 class index_btree;
+class index_btree_olc;
 class Catalog;
 class lock_man;
 class txn_man;
@@ -29,10 +31,14 @@ public:
 	virtual RC init_table()=0;
 	// Create a new transaction manager and bind it to this hardware/simulator thread
 	virtual RC get_txn_man(txn_man *& txn_manager, thread_t * h_thd)=0;
+	// [RECOVER] inserts a row loaded from a checkpoint into its indexes
+	virtual void index_row(table_t * table, row_t * row) { assert(false); };
+	
+	// also used to rebuild the indexes from an image
+	void index_insert(INDEX * index, uint64_t key, row_t * row, int64_t part_id = -1);
 	
 	bool sim_done;
 protected:
 	void index_insert(string index_name, uint64_t key, row_t * row);
-	void index_insert(INDEX * index, uint64_t key, row_t * row, int64_t part_id = -1);
 };
 